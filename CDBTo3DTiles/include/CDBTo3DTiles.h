@@ -38,11 +38,76 @@ public:
 
     void setElevationThresholdIndices(float elevationThresholdIndices);
 
+    void setElevationSimplifier(ElevationSimplifier elevationSimplifier);
+
+    void setElevationClipSubRegions(bool elevationClipSubRegions);
+
+    void setThreadCount(int threadCount);
+
+    void setPipelineQueueDepth(int pipelineQueueDepth);
+
+    void setPipelineBuilderThreads(int pipelineBuilderThreads);
+
+    void setPipelineEncoderThreads(int pipelineEncoderThreads);
+
+    void setPipelineWriterThreads(int pipelineWriterThreads);
+
+    void setWriterThreads(int writerThreads);
+
+    void setWriterMemoryBudget(int writerMemoryBudget);
+
+    void setPrefetchTiles(int prefetchTiles);
+
+    void setPrefetchThreads(int prefetchThreads);
+
+    void setPrefetchMemoryBudget(int prefetchMemoryBudget);
+
+    void setShard(int shardIndex, int shardCount);
+
+    void setUseIndexCache(bool useIndexCache);
+
+    void setOutputSink(std::shared_ptr<OutputSink> outputSink);
+
+    void setDeduplicateOutput(bool deduplicateOutput);
+
+    void setTileLayout(TileLayout tileLayout);
+
     void convert();
 
+    // hits and misses of the elevation tile prefetcher in the last conversion
+    inline const TilePrefetcher::Statistics &getPrefetchStatistics() const noexcept
+    {
+        return m_prefetchStatistics;
+    }
+
+    // files of the last conversion that weren't written again because an identical file already was
+    inline size_t getDuplicateFileCount() const noexcept { return m_duplicateFileCount; }
+
+    inline uint64_t getDuplicateByteLength() const noexcept { return m_duplicateByteLength; }
+
 private:
     struct TilesetCollection;
 
     std::unique_ptr<CDBTilesetBuilder> m_impl;
+    std::shared_ptr<OutputSink> m_outputSink;
+    TilePrefetcher::Statistics m_prefetchStatistics;
+    size_t m_duplicateFileCount;
+    uint64_t m_duplicateByteLength;
+};
+
+class ShardMerger
+{
+public:
+    ShardMerger(const std::vector<std::filesystem::path> &shardPaths,
+                const std::filesystem::path &outputPath);
+
+    void combineDataset(const std::vector<std::string> &datasets);
+
+    void merge();
+
+private:
+    std::vector<std::filesystem::path> m_shardPaths;
+    std::filesystem::path m_outputPath;
+    std::vector<std::vector<std::string>> m_requestedDatasetToCombine;
 };
 } // namespace CDBTo3DTiles
@@ -59,7 +59,7 @@ inline unsigned int countSetBitsInInteger(unsigned int integer)
     return count;
 }
 
-inline unsigned int countSetBitsInVectorOfInts(std::vector<uint8_t> vec)
+inline unsigned int countSetBitsInVectorOfInts(const std::vector<uint8_t> &vec)
 {
     unsigned int count = 0;
     for(unsigned int integer : vec)
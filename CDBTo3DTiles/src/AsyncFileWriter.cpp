@@ -0,0 +1,140 @@
+#include "AsyncFileWriter.h"
+
+namespace CDBTo3DTiles {
+
+AsyncFileWriter::AsyncFileWriter(size_t threadCount, size_t maxQueuedBytes, OutputSink &outputSink)
+    : m_outputSink{outputSink}
+    , m_maxQueuedBytes{maxQueuedBytes}
+    , m_queuedBytes{0}
+    , m_pendingFileCount{0}
+    , m_stop{false}
+{
+    threadCount = threadCount > 0 ? threadCount : 1;
+    m_threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this]() { writerLoop(); });
+    }
+}
+
+AsyncFileWriter::~AsyncFileWriter() noexcept
+{
+    waitUntilIdle();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_hasFiles.notify_all();
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void AsyncFileWriter::write(const std::filesystem::path &path, std::string content)
+{
+    size_t byteLength = content.size();
+    {
+        // block the producer until enough queued bytes are written. A file larger than the budget
+        // is still accepted once nothing else is queued, so we never wait forever
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_hasSpace.wait(lock, [this, byteLength]() {
+            return m_queuedBytes == 0 || m_queuedBytes + byteLength <= m_maxQueuedBytes;
+        });
+
+        m_queuedBytes += byteLength;
+        ++m_pendingFileCount;
+        m_files.push_back({path, std::move(content)});
+    }
+
+    m_hasFiles.notify_one();
+}
+
+void AsyncFileWriter::write(std::vector<File> files)
+{
+    size_t byteLength = 0;
+    for (const auto &file : files) {
+        byteLength += file.content.size();
+    }
+
+    {
+        // a batch takes the lock once and is admitted as a whole, like one large file
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_hasSpace.wait(lock, [this, byteLength]() {
+            return m_queuedBytes == 0 || m_queuedBytes + byteLength <= m_maxQueuedBytes;
+        });
+
+        m_queuedBytes += byteLength;
+        m_pendingFileCount += files.size();
+        for (auto &file : files) {
+            m_files.emplace_back(std::move(file));
+        }
+    }
+
+    m_hasFiles.notify_all();
+}
+
+void AsyncFileWriter::flush()
+{
+    waitUntilIdle();
+
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(exception, m_exception);
+    }
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void AsyncFileWriter::waitUntilIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_hasSpace.wait(lock, [this]() { return m_pendingFileCount == 0; });
+}
+
+void AsyncFileWriter::writerLoop()
+{
+    while (true) {
+        File file;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_hasFiles.wait(lock, [this]() { return m_stop || !m_files.empty(); });
+            if (m_files.empty()) {
+                return;
+            }
+
+            file = std::move(m_files.front());
+            m_files.pop_front();
+        }
+
+        std::exception_ptr exception;
+        try {
+            writeFile(file);
+        } catch (...) {
+            exception = std::current_exception();
+        }
+
+        // the bytes stay in the budget until they are on disk, not just out of the queue
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (exception && !m_exception) {
+                m_exception = exception;
+            }
+
+            m_queuedBytes -= file.content.size();
+            --m_pendingFileCount;
+        }
+
+        m_hasSpace.notify_all();
+    }
+}
+
+void AsyncFileWriter::writeFile(const File &file)
+{
+    m_outputSink.write(file.path, file.content.data(), file.content.size());
+}
+
+} // namespace CDBTo3DTiles
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "OutputSink.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace CDBTo3DTiles {
+class AsyncFileWriter
+{
+public:
+    struct File
+    {
+        std::filesystem::path path;
+        std::string content;
+    };
+
+    AsyncFileWriter(size_t threadCount,
+                    size_t maxQueuedBytes,
+                    OutputSink &outputSink = FileSystemOutputSink::getInstance());
+
+    AsyncFileWriter(const AsyncFileWriter &) = delete;
+
+    AsyncFileWriter &operator=(const AsyncFileWriter &) = delete;
+
+    ~AsyncFileWriter() noexcept;
+
+    inline size_t getMaxQueuedBytes() const noexcept { return m_maxQueuedBytes; }
+
+    void write(const std::filesystem::path &path, std::string content);
+
+    void write(std::vector<File> files);
+
+    void flush();
+
+private:
+    void waitUntilIdle();
+
+    void writerLoop();
+
+    void writeFile(const File &file);
+
+    OutputSink &m_outputSink;
+    size_t m_maxQueuedBytes;
+    size_t m_queuedBytes;
+    size_t m_pendingFileCount;
+    bool m_stop;
+    std::deque<File> m_files;
+    std::exception_ptr m_exception;
+    std::mutex m_mutex;
+    std::condition_variable m_hasFiles;
+    std::condition_variable m_hasSpace;
+    std::vector<std::thread> m_threads;
+};
+} // namespace CDBTo3DTiles
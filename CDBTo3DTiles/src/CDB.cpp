@@ -1,4 +1,6 @@
 #include "CDB.h"
+#include "VirtualFileSystem.h"
+#include <deque>
 #include <iostream>
 #include <string.h>
 #include <unordered_set>
@@ -13,45 +15,80 @@ const std::filesystem::path CDB::GTModel = "GTModel";
 
 CDB::CDB(const std::filesystem::path &path)
     : m_path{path}
+    , m_index{path}
 {
-    m_GTModelCache = CDBGTModelCache(path);
+    m_GTModelCache.emplace(path);
+}
+
+CDB::CDB(const std::filesystem::path &path, const std::filesystem::path &indexCachePath)
+    : m_path{path}
+    , m_index{path, indexCachePath}
+{
+    m_GTModelCache.emplace(path);
+}
+
+void CDB::saveIndexCache() const
+{
+    m_index.saveCache();
 }
 
 void CDB::forEachGeoCell(std::function<void(CDBGeoCell)> process)
 {
     std::filesystem::path tilesPath = m_path / TILES;
 
-    if (!std::filesystem::exists(tilesPath) || !std::filesystem::is_directory(tilesPath)) {
+    if (!VirtualFileSystem::isDirectory(tilesPath)) {
         throw std::runtime_error(tilesPath.string() + " directory does not exist");
     }
 
-    for (std::filesystem::directory_entry geoCellLatDir : std::filesystem::directory_iterator(tilesPath)) {
-        auto geoCellLatitude = CDBGeoCell::parseLatFromFilename(geoCellLatDir.path().filename().string());
-        if (!geoCellLatitude) {
-            continue;
-        }
+    for (const auto &geoCell : m_index.getGeoCells()) {
+        process(geoCell);
+    }
+}
 
-        for (std::filesystem::directory_entry geoCellLongDir :
-             std::filesystem::directory_iterator(geoCellLatDir)) {
-            auto geoCellLongitude = CDBGeoCell::parseLongFromFilename(
-                geoCellLongDir.path().filename().string());
-            if (!geoCellLongitude) {
-                continue;
+void CDB::forEachElevationTile(const CDBGeoCell &geoCell,
+                               std::function<void(CDBElevation)> process,
+                               TilePrefetcher *prefetcher)
+{
+    if (prefetcher == nullptr) {
+        forEachDatasetTile(geoCell, CDBDataset::Elevation, [&](const std::filesystem::path &elevationPath) {
+            std::optional<CDBElevation> elevation = CDBElevation::createFromFile(elevationPath);
+            if (elevation) {
+                process(std::move(*elevation));
             }
+        });
 
-            process(CDBGeoCell(*geoCellLatitude, *geoCellLongitude));
-        }
+        return;
     }
-}
 
-void CDB::forEachElevationTile(const CDBGeoCell &geoCell, std::function<void(CDBElevation)> process)
-{
-    forEachDatasetTile(geoCell, CDBDataset::Elevation, [&](const std::filesystem::path &elevationTilePath) {
-        std::optional<CDBElevation> elevation = CDBElevation::createFromFile(elevationTilePath);
+    // the tiles are read in the index order, so the prefetcher can stay a fixed number of tiles ahead
+    const auto &elevationFiles = m_index.getDatasetFiles(geoCell, CDBDataset::Elevation);
+    std::deque<std::shared_ptr<TilePrefetcher::Tile>> prefetchedTiles;
+    size_t nextPrefetch = 0;
+    for (size_t i = 0; i < elevationFiles.size(); ++i) {
+        // a tile over the byte budget is retried once earlier tiles are read
+        while (nextPrefetch < elevationFiles.size() && nextPrefetch <= i + prefetcher->getTileCount()) {
+            auto tile = prefetcher->prefetch(getElevationTileInputs(elevationFiles[nextPrefetch]));
+            if (tile == nullptr) {
+                break;
+            }
+
+            prefetchedTiles.emplace_back(std::move(tile));
+            ++nextPrefetch;
+        }
+
+        if (nextPrefetch > i) {
+            prefetcher->consume(prefetchedTiles.front());
+            prefetchedTiles.pop_front();
+        } else {
+            prefetcher->consume(nullptr);
+            nextPrefetch = i + 1;
+        }
+
+        std::optional<CDBElevation> elevation = CDBElevation::createFromFile(elevationFiles[i].path);
         if (elevation) {
             process(std::move(*elevation));
         }
-    });
+    }
 }
 
 void CDB::forEachGTModelTile(const CDBGeoCell &geoCell, std::function<void(CDBGTModels)> process)
@@ -92,7 +129,9 @@ void CDB::forEachGTModelTile(const CDBGeoCell &geoCell, std::function<void(CDBGT
     }
 }
 
-void CDB::forEachGSModelTile(const CDBGeoCell &geoCell, std::function<void(CDBGSModels)> process)
+void CDB::forEachGSModelTile(const CDBGeoCell &geoCell,
+                             std::function<void(CDBGSModels)> process,
+                             ThreadPool *threadPool)
 {
     std::unordered_map<size_t, CDBTileset> tilesets;
     forEachDatasetTile(geoCell, CDBDataset::GSFeature, [&](const std::filesystem::path &GSFeaturePath) {
@@ -122,7 +161,8 @@ void CDB::forEachGSModelTile(const CDBGeoCell &geoCell, std::function<void(CDBGS
                                  nullptr,
                                  [&](CDBModelsAttributes modelAttribute) {
                                      auto models = CDBGSModels::createFromModelsAttributes(modelAttribute,
-                                                                                           m_path);
+                                                                                           m_path,
+                                                                                           threadPool);
                                      if (models) {
                                          process(std::move(*models));
                                      }
@@ -208,8 +248,7 @@ void CDB::traverseModelsAttributes(const CDBTile *root,
                                                    root->getUREF(),
                                                    root->getRREF());
 
-                auto currentElevationPath = m_path / (currentElevation.getRelativePath().string() + ".tif");
-                if (!std::filesystem::exists(currentElevationPath)) {
+                if (!isElevationExist(currentElevation)) {
                     // reuse the previous read parent elevation if there is any
                     if (oldElevationTile) {
                         for (auto &point : model.getCartographicPositions()) {
@@ -413,58 +452,50 @@ void CDB::clampPointOnElevation(const CDBTile &elevationTile,
 
 bool CDB::isElevationExist(const CDBTile &tile) const
 {
-    CDBTile elevationTile = CDBTile(tile.getGeoCell(),
-                                    CDBDataset::Elevation,
-                                    1,
-                                    1,
-                                    tile.getLevel(),
-                                    tile.getUREF(),
-                                    tile.getRREF());
-
-    auto elevationPath = m_path / (elevationTile.getRelativePath().string() + ".tif");
-    return std::filesystem::exists(elevationPath);
+    return m_index.isTileExist(tile.getGeoCell(),
+                               CDBDataset::Elevation,
+                               1,
+                               1,
+                               tile.getLevel(),
+                               tile.getUREF(),
+                               tile.getRREF(),
+                               ".tif");
 }
 
 bool CDB::isImageryExist(const CDBTile &tile) const
 {
-    CDBTile imageryTile = CDBTile(tile.getGeoCell(),
-                                  CDBDataset::Imagery,
-                                  1,
-                                  1,
-                                  tile.getLevel(),
-                                  tile.getUREF(),
-                                  tile.getRREF());
-
-    auto imagery = m_path / (imageryTile.getRelativePath().string() + ".jp2");
-    return std::filesystem::exists(imagery);
+    return m_index.isTileExist(tile.getGeoCell(),
+                               CDBDataset::Imagery,
+                               1,
+                               1,
+                               tile.getLevel(),
+                               tile.getUREF(),
+                               tile.getRREF(),
+                               ".jp2");
 }
 
 bool CDB::isRMTextureExist(const CDBTile &tile) const
 {
-    CDBTile rmTextureTile = CDBTile(tile.getGeoCell(),
-                                  CDBDataset::RMTexture,
-                                  1,
-                                  1,
-                                  tile.getLevel(),
-                                  tile.getUREF(),
-                                  tile.getRREF());
-
-    auto rmTexture = m_path / (rmTextureTile.getRelativePath().string() + ".tif");
-    return std::filesystem::exists(rmTexture);
+    return m_index.isTileExist(tile.getGeoCell(),
+                               CDBDataset::RMTexture,
+                               1,
+                               1,
+                               tile.getLevel(),
+                               tile.getUREF(),
+                               tile.getRREF(),
+                               ".tif");
 }
 
 bool CDB::isRMDescriptorExist(const CDBTile &tile) const
 {
-    CDBTile rmDescriptorTile = CDBTile(tile.getGeoCell(),
-                                  CDBDataset::RMDescriptor,
-                                  1,
-                                  1,
-                                  tile.getLevel(),
-                                  tile.getUREF(),
-                                  tile.getRREF());
-
-    auto rmDescriptor = m_path / (rmDescriptorTile.getRelativePath().string() + ".xml");
-    return std::filesystem::exists(rmDescriptor);
+    return m_index.isTileExist(tile.getGeoCell(),
+                               CDBDataset::RMDescriptor,
+                               1,
+                               1,
+                               tile.getLevel(),
+                               tile.getUREF(),
+                               tile.getRREF(),
+                               ".xml");
 }
 
 std::optional<CDBImagery> CDB::getImagery(const CDBTile &tile) const
@@ -478,7 +509,7 @@ std::optional<CDBImagery> CDB::getImagery(const CDBTile &tile) const
                                   tile.getRREF());
 
     auto imageryPath = m_path / (imageryTile.getRelativePath().string() + ".jp2");
-    if (!std::filesystem::exists(imageryPath)) {
+    if (!m_index.isTileExist(imageryTile, ".jp2")) {
         return std::nullopt;
     }
 
@@ -503,7 +534,7 @@ std::optional<CDBRMTexture> CDB::getRMTexture(const CDBTile &tile) const
                                   tile.getRREF());
 
     auto rmTexturePath = m_path / (rmTextureTile.getRelativePath().string() + ".tif");
-    if (!std::filesystem::exists(rmTexturePath)) {
+    if (!m_index.isTileExist(rmTextureTile, ".tif")) {
         return std::nullopt;
     }
 
@@ -528,36 +559,56 @@ CDBRMDescriptor* CDB::getRMDescriptor(const CDBTile &tile) const
                                   tile.getRREF());
 
     auto rmDescriptorPath = m_path / (rmDescriptorTile.getRelativePath().string() + ".xml");
-    if (!std::filesystem::exists(rmDescriptorPath)) {
+    if (!m_index.isTileExist(rmDescriptorTile, ".xml")) {
         return nullptr;
     }
 
     return new CDBRMDescriptor(rmDescriptorPath, rmDescriptorTile);
 }
 
-void CDB::forEachDatasetTile(const CDBGeoCell &geoCell,
-                             CDBDataset dataset,
-                             std::function<void(const std::filesystem::path &)> process)
+std::vector<TilePrefetcher::File> CDB::getElevationTileInputs(const CDBIndex::File &elevationFile) const
 {
-    auto datasetPath = m_path / geoCell.getRelativePath() / getCDBDatasetDirectoryName(dataset);
-    if (!std::filesystem::exists(datasetPath) || !std::filesystem::is_directory(datasetPath)) {
-        return;
+    // the index only records file sizes when it is saved to disk
+    auto elevationSize = elevationFile.size;
+    if (elevationSize == 0) {
+        elevationSize = VirtualFileSystem::getFileSize(elevationFile.path).value_or(0);
+    }
+
+    std::vector<TilePrefetcher::File> inputs{{elevationFile.path, elevationSize}};
+    auto elevationTile = CDBTile::createFromFile(elevationFile.path.stem().string());
+    if (!elevationTile) {
+        return inputs;
     }
 
-    for (std::filesystem::directory_entry levelDir : std::filesystem::directory_iterator(datasetPath)) {
-        if (!std::filesystem::is_directory(levelDir)) {
+    // the imagery, RMTexture and RMDescriptor files that are read along with the elevation tile
+    const std::pair<CDBDataset, const char *> datasets[] = {{CDBDataset::Imagery, ".jp2"},
+                                                            {CDBDataset::RMTexture, ".tif"},
+                                                            {CDBDataset::RMDescriptor, ".xml"}};
+    for (const auto &[dataset, extension] : datasets) {
+        CDBTile tile(elevationTile->getGeoCell(),
+                     dataset,
+                     1,
+                     1,
+                     elevationTile->getLevel(),
+                     elevationTile->getUREF(),
+                     elevationTile->getRREF());
+        if (!m_index.isTileExist(tile, extension)) {
             continue;
         }
 
-        for (std::filesystem::directory_entry UREFDir : std::filesystem::directory_iterator(levelDir)) {
-            if (!std::filesystem::is_directory(UREFDir)) {
-                continue;
-            }
+        auto path = m_path / (tile.getRelativePath().string() + extension);
+        inputs.push_back({path, VirtualFileSystem::getFileSize(path).value_or(0)});
+    }
 
-            for (std::filesystem::directory_entry tilePath : std::filesystem::directory_iterator(UREFDir)) {
-                process(tilePath);
-            }
-        }
+    return inputs;
+}
+
+void CDB::forEachDatasetTile(const CDBGeoCell &geoCell,
+                             CDBDataset dataset,
+                             std::function<void(const std::filesystem::path &)> process)
+{
+    for (const auto &tileFile : m_index.getDatasetFiles(geoCell, dataset)) {
+        process(tileFile.path);
     }
 }
 } // namespace CDBTo3DTiles
@@ -2,11 +2,13 @@
 
 #include "CDBElevation.h"
 #include "CDBGeometryVectors.h"
+#include "CDBIndex.h"
 #include "CDBImagery.h"
 #include "CDBRMTexture.h"
 #include "CDBRMDescriptor.h"
 #include "CDBModels.h"
 #include "CDBTileset.h"
+#include "TilePrefetcher.h"
 #include <filesystem>
 #include <functional>
 #include <optional>
@@ -20,13 +22,21 @@ class CDB
 public:
     explicit CDB(const std::filesystem::path &path);
 
+    CDB(const std::filesystem::path &path, const std::filesystem::path &indexCachePath);
+
+    void saveIndexCache() const;
+
     void forEachGeoCell(std::function<void(CDBGeoCell geoCell)> process);
 
-    void forEachElevationTile(const CDBGeoCell &geoCell, std::function<void(CDBElevation)> process);
+    void forEachElevationTile(const CDBGeoCell &geoCell,
+                              std::function<void(CDBElevation)> process,
+                              TilePrefetcher *prefetcher = nullptr);
 
     void forEachGTModelTile(const CDBGeoCell &geoCell, std::function<void(CDBGTModels)> process);
 
-    void forEachGSModelTile(const CDBGeoCell &geoCell, std::function<void(CDBGSModels)> process);
+    void forEachGSModelTile(const CDBGeoCell &geoCell,
+                            std::function<void(CDBGSModels)> process,
+                            ThreadPool *threadPool = nullptr);
 
     void forEachRoadNetworkTile(const CDBGeoCell &geoCell, std::function<void(CDBGeometryVectors)> process);
 
@@ -74,12 +84,15 @@ private:
                                GDALDataset &elevationDataset,
                                Core::Cartographic &point);
 
+    std::vector<TilePrefetcher::File> getElevationTileInputs(const CDBIndex::File &elevationFile) const;
+
     void forEachDatasetTile(const CDBGeoCell &geoCell,
                             CDBDataset dataset,
                             std::function<void(const std::filesystem::path &)> process);
 
     std::optional<CDBGTModelCache> m_GTModelCache;
     std::filesystem::path m_path;
+    CDBIndex m_index;
 };
 } // namespace CDBTo3DTiles
 
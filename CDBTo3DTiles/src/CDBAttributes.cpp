@@ -1,5 +1,6 @@
 #include "CDBAttributes.h"
 #include "Transforms.h"
+#include "VirtualFileSystem.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_access.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -184,7 +185,7 @@ std::optional<CDBClassesAttributes> CDBModelsAttributes::createClassesAttributes
                                        instancesTile.getRREF());
 
     auto classLevelPath = CDBPath / (classVectorsTile.getRelativePath().string() + ".dbf");
-    if (!std::filesystem::exists(classLevelPath)) {
+    if (!VirtualFileSystem::exists(classLevelPath)) {
         return std::nullopt;
     }
 
@@ -2,24 +2,58 @@
 
 #include "CDBTile.h"
 #include "Cartographic.h"
+#include "ElevationGrid.h"
+#include "ElevationTriangles.h"
+#include "RTIN.h"
 #include "Scene.h"
 #include "gdal_priv.h"
 #include <filesystem>
+#include <memory>
 
 namespace CDBTo3DTiles {
 
+// how elevation meshes are simplified. MeshOptimizer runs meshopt_simplify on the mesh of the grid. RTIN
+// extracts the triangles from an error map of the heights, which only square grids of 2^n pixels have, so
+// any other grid falls back to meshopt_simplify
+enum class ElevationSimplifier
+{
+    MeshOptimizer,
+    RTIN
+};
+
 class CDBElevation
 {
 public:
-    CDBElevation(Mesh uniformGridMesh, size_t gridWidth, size_t gridHeight, CDBTile tile, double minElevation = 0, double maxElevation = 0);
+    CDBElevation(ElevationGrid grid, CDBTile tile, double minElevation = 0, double maxElevation = 0);
+
+    Mesh createSimplifiedMesh(size_t targetIndexCount,
+                              float targetError,
+                              ElevationSimplifier simplifier = ElevationSimplifier::MeshOptimizer) const;
+
+    // simplifies the heights once and keeps the triangles. Sub regions created afterwards get the triangles
+    // clipped to their quadrant instead of simplifying their heights again
+    void keepSimplifiedTriangles(size_t targetIndexCount,
+                                 float targetError,
+                                 ElevationSimplifier simplifier = ElevationSimplifier::MeshOptimizer);
+
+    inline bool hasSimplifiedTriangles() const noexcept { return m_simplifiedTriangles != nullptr; }
+
+    // the mesh of the kept triangles, or an empty mesh when there are none
+    Mesh createSimplifiedTrianglesMesh() const;
 
-    Mesh createSimplifiedMesh(size_t targetIndexCount, float targetError) const;
+    // builds the error map of the RTIN simplifier. Sub regions created afterwards share it
+    void createRTIN();
 
-    inline const Mesh &getUniformGridMesh() const noexcept { return m_uniformGridMesh; }
+    inline bool hasRTIN() const noexcept { return m_RTIN != nullptr; }
 
-    inline size_t getGridWidth() const noexcept { return m_gridWidth; }
+    inline const ElevationView &getView() const noexcept { return m_view; }
 
-    inline size_t getGridHeight() const noexcept { return m_gridHeight; }
+    // the view as a full mesh with a vertex for every grid vertex
+    inline Mesh createUniformGridMesh() const { return m_view.createMesh(); }
+
+    inline size_t getGridWidth() const noexcept { return m_view.getGridWidth(); }
+
+    inline size_t getGridHeight() const noexcept { return m_view.getGridHeight(); }
 
     inline double getMinElevation() { return m_minElevation; }
 
@@ -31,6 +65,7 @@ public:
 
     void indexUVRelativeToParent(const CDBTile &parentTile);
 
+    // sub regions are views into the heights of the elevation loaded from the file
     std::optional<CDBElevation> createNorthWestSubRegion(bool reindexUVs) const;
 
     std::optional<CDBElevation> createNorthEastSubRegion(bool reindexUVs) const;
@@ -42,13 +77,23 @@ public:
     static std::optional<CDBElevation> createFromFile(const std::filesystem::path &file);
 
 private:
-    CDBElevation createSubRegion(glm::uvec2 begin, const CDBTile &subRegionTile, bool reindexUV) const;
+    CDBElevation(std::shared_ptr<const ElevationGrid> grid,
+                 ElevationView view,
+                 std::shared_ptr<const RTIN> rtin,
+                 CDBTile tile);
 
-    Mesh createSubRegionMesh(glm::uvec2 gridFrom, glm::uvec2 gridTo, bool reindexUV) const;
+    ElevationTriangles simplifyTriangles(size_t targetIndexCount,
+                                         float targetError,
+                                         ElevationSimplifier simplifier) const;
+
+    Mesh createMesh(const ElevationTriangles &triangles) const;
+
+    CDBElevation createSubRegion(glm::uvec2 begin, const CDBTile &subRegionTile, bool reindexUV) const;
 
-    size_t m_gridWidth;
-    size_t m_gridHeight;
-    Mesh m_uniformGridMesh;
+    std::shared_ptr<const ElevationGrid> m_grid;
+    ElevationView m_view;
+    std::shared_ptr<const RTIN> m_RTIN;
+    std::shared_ptr<const ElevationTriangles> m_simplifiedTriangles;
     std::optional<CDBTile> m_tile;
     double m_minElevation;
     double m_maxElevation;
@@ -1,4 +1,5 @@
 #include "CDBGeometryVectors.h"
+#include "VirtualFileSystem.h"
 #include "mapbox/earcut.hpp"
 #include "ogrsf_frmts.h"
 
@@ -68,6 +69,9 @@ void CDBGeometryVectors::createPoint(GDALDataset *vectorDataset)
     m_mesh.primitiveType = PrimitiveType::Points;
 
     const auto &ellipsoid = Core::Ellipsoid::WGS84;
+    std::vector<double> longitudes;
+    std::vector<double> latitudes;
+    std::vector<double> heights;
     int featureID = 0;
     for (int i = 0; i < vectorDataset->GetLayerCount(); ++i) {
         OGRLayer *layer = vectorDataset->GetLayer(i);
@@ -78,12 +82,9 @@ void CDBGeometryVectors::createPoint(GDALDataset *vectorDataset)
             if (geometry != nullptr && wkbFlatten(geometry->getGeometryType()) == wkbPoint) {
                 const OGRPoint *p = geometry->toPoint();
 
-                Core::Cartographic cartographic(glm::radians(p->getX()), glm::radians(p->getY()), p->getZ());
-
-                auto position = ellipsoid.cartographicToCartesian(cartographic);
-
-                m_mesh.aabb->merge(position);
-                m_mesh.positions.emplace_back(position);
+                longitudes.emplace_back(glm::radians(p->getX()));
+                latitudes.emplace_back(glm::radians(p->getY()));
+                heights.emplace_back(p->getZ());
                 m_mesh.batchIDs.emplace_back(featureID);
 
                 ++featureID;
@@ -91,6 +92,8 @@ void CDBGeometryVectors::createPoint(GDALDataset *vectorDataset)
         }
     }
 
+    convertToPositions(ellipsoid, longitudes, latitudes, heights);
+
     auto center = m_mesh.aabb->center();
     m_mesh.positionRTCs.reserve(m_mesh.positions.size());
     for (auto position : m_mesh.positions) {
@@ -104,6 +107,9 @@ void CDBGeometryVectors::createPolyline(GDALDataset *vectorDataset)
     m_mesh.primitiveType = PrimitiveType::Lines;
 
     const auto &ellipsoid = Core::Ellipsoid::WGS84;
+    std::vector<double> longitudes;
+    std::vector<double> latitudes;
+    std::vector<double> heights;
     int featureID = 0;
     for (int i = 0; i < vectorDataset->GetLayerCount(); ++i) {
         OGRLayer *layer = vectorDataset->GetLayer(i);
@@ -117,16 +123,13 @@ void CDBGeometryVectors::createPolyline(GDALDataset *vectorDataset)
                     OGRPoint p;
                     lineString->getPoint(j, &p);
 
-                    Core::Cartographic cartographic(glm::radians(p.getX()), glm::radians(p.getY()), p.getZ());
-
-                    auto position = ellipsoid.cartographicToCartesian(cartographic);
-
-                    m_mesh.aabb->merge(position);
-                    m_mesh.positions.emplace_back(position);
+                    longitudes.emplace_back(glm::radians(p.getX()));
+                    latitudes.emplace_back(glm::radians(p.getY()));
+                    heights.emplace_back(p.getZ());
                     m_mesh.batchIDs.emplace_back(featureID);
 
                     if (j > 0) {
-                        auto index = m_mesh.positions.size() - 1;
+                        auto index = m_mesh.positions.size() + longitudes.size() - 1;
                         m_mesh.indices.emplace_back(index - 1);
                         m_mesh.indices.emplace_back(index);
                     }
@@ -137,6 +140,8 @@ void CDBGeometryVectors::createPolyline(GDALDataset *vectorDataset)
         }
     }
 
+    convertToPositions(ellipsoid, longitudes, latitudes, heights);
+
     auto center = m_mesh.aabb->center();
     m_mesh.positionRTCs.reserve(m_mesh.positions.size());
     for (auto position : m_mesh.positions) {
@@ -189,19 +194,28 @@ void CDBGeometryVectors::createPolygon(int featureID,
 {
     uint32_t currPositionSize = static_cast<uint32_t>(m_mesh.positions.size());
     std::vector<std::vector<std::pair<double, double>>> mapboxRings;
+    std::vector<double> longitudes;
+    std::vector<double> latitudes;
+    std::vector<double> heights;
     for (auto lineRing : *polygon) {
-        std::vector<std::pair<double, double>> mapboxRing;
+        longitudes.clear();
+        latitudes.clear();
+        heights.clear();
         for (auto point : *lineRing) {
-            Core::Cartographic cartographic(glm::radians(point.getX()),
-                                            glm::radians(point.getY()),
-                                            point.getZ());
-            glm::dvec3 position = ellipsoid.cartographicToCartesian(cartographic);
-            glm::dvec2 projectPosition = tangentPlane.projectPointToNearestOnPlane(position);
-            mapboxRing.emplace_back(projectPosition.x, projectPosition.y);
-
-            m_mesh.positions.emplace_back(position);
+            longitudes.emplace_back(glm::radians(point.getX()));
+            latitudes.emplace_back(glm::radians(point.getY()));
+            heights.emplace_back(point.getZ());
             m_mesh.batchIDs.emplace_back(featureID);
-            m_mesh.aabb->merge(position);
+        }
+
+        size_t ringBegin = m_mesh.positions.size();
+        convertToPositions(ellipsoid, longitudes, latitudes, heights);
+
+        std::vector<std::pair<double, double>> mapboxRing;
+        mapboxRing.reserve(longitudes.size());
+        for (size_t i = ringBegin; i < m_mesh.positions.size(); ++i) {
+            glm::dvec2 projectPosition = tangentPlane.projectPointToNearestOnPlane(m_mesh.positions[i]);
+            mapboxRing.emplace_back(projectPosition.x, projectPosition.y);
         }
 
         mapboxRings.emplace_back(mapboxRing);
@@ -214,6 +228,24 @@ void CDBGeometryVectors::createPolygon(int featureID,
     }
 }
 
+void CDBGeometryVectors::convertToPositions(const Core::Ellipsoid &ellipsoid,
+                                            const std::vector<double> &longitudes,
+                                            const std::vector<double> &latitudes,
+                                            const std::vector<double> &heights)
+{
+    size_t begin = m_mesh.positions.size();
+    m_mesh.positions.resize(begin + longitudes.size());
+    ellipsoid.cartographicToCartesian(longitudes.data(),
+                                      latitudes.data(),
+                                      heights.data(),
+                                      longitudes.size(),
+                                      m_mesh.positions.data() + begin);
+
+    for (size_t i = begin; i < m_mesh.positions.size(); ++i) {
+        m_mesh.aabb->merge(m_mesh.positions[i]);
+    }
+}
+
 std::optional<CDBClassesAttributes> createClassesAttributes(const CDBTile &instancesTile,
                                                             const std::filesystem::path &CDBPath)
 {
@@ -237,7 +269,7 @@ std::optional<CDBClassesAttributes> createClassesAttributes(const CDBTile &insta
                                        instancesTile.getRREF());
 
     auto classLevelPath = CDBPath / (classVectorsTile.getRelativePath().string() + ".dbf");
-    if (!std::filesystem::exists(classLevelPath)) {
+    if (!VirtualFileSystem::exists(classLevelPath)) {
         return std::nullopt;
     }
 
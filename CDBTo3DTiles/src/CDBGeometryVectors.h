@@ -37,6 +37,12 @@ private:
                        const Core::Ellipsoid &ellipsoid,
                        Core::EllipsoidTangentPlane &tangentPlane);
 
+    // appends the cartesian positions of the gathered points to the mesh in one batch
+    void convertToPositions(const Core::Ellipsoid &ellipsoid,
+                            const std::vector<double> &longitudes,
+                            const std::vector<double> &latitudes,
+                            const std::vector<double> &heights);
+
     Mesh m_mesh;
     CDBInstancesAttributes m_instancesAttribs;
     std::optional<CDBTile> m_tile;
@@ -0,0 +1,439 @@
+#include "CDBIndex.h"
+#include "CDB.h"
+#include "VirtualFileSystem.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace CDBTo3DTiles {
+
+const std::filesystem::path CDBIndex::CACHE_FILE = ".cdb23dtiles.index";
+
+static constexpr int CACHE_VERSION = 1;
+
+CDBIndex::CDBIndex(const std::filesystem::path &CDBPath)
+    : m_path{CDBPath}
+    , m_isCacheOutdated{false}
+{}
+
+CDBIndex::CDBIndex(const std::filesystem::path &CDBPath, const std::filesystem::path &cachePath)
+    : m_path{CDBPath}
+    , m_cachePath{cachePath}
+    , m_isCacheOutdated{false}
+{
+    loadCache();
+}
+
+std::vector<CDBGeoCell> CDBIndex::getGeoCells() const
+{
+    std::lock_guard<std::mutex> lock(m_geoCellsMutex);
+    if (!m_geoCells) {
+        // the geocell list only changes when a latitude or longitude directory is added or removed, which
+        // changes the modified time of Tiles or of a latitude directory
+        if (!m_cachePath.empty() && !m_cachedGeoCellDirectories.empty()
+            && isDirectoriesUnchanged(m_cachedGeoCellDirectories)) {
+            m_geoCells = m_cachedGeoCells;
+            m_geoCellDirectories = m_cachedGeoCellDirectories;
+        } else {
+            m_geoCells.emplace();
+            m_geoCellDirectories.clear();
+            m_isCacheOutdated = true;
+
+            std::filesystem::path tilesPath = m_path / CDB::TILES;
+            if (!m_cachePath.empty()) {
+                m_geoCellDirectories.push_back({tilesPath, getModifiedTime(tilesPath).value_or(0)});
+            }
+
+            for (const auto &geoCellLatDir : VirtualFileSystem::listDirectory(tilesPath)) {
+                auto geoCellLatitude = CDBGeoCell::parseLatFromFilename(
+                    geoCellLatDir.path.filename().string());
+                if (!geoCellLatitude) {
+                    continue;
+                }
+
+                if (!m_cachePath.empty()) {
+                    m_geoCellDirectories.push_back(
+                        {geoCellLatDir.path, getModifiedTime(geoCellLatDir.path).value_or(0)});
+                }
+
+                for (const auto &geoCellLongDir : VirtualFileSystem::listDirectory(geoCellLatDir.path)) {
+                    auto geoCellLongitude = CDBGeoCell::parseLongFromFilename(
+                        geoCellLongDir.path.filename().string());
+                    if (!geoCellLongitude) {
+                        continue;
+                    }
+
+                    m_geoCells->emplace_back(*geoCellLatitude, *geoCellLongitude);
+                }
+            }
+        }
+    }
+
+    std::vector<CDBGeoCell> geoCells;
+    geoCells.reserve(m_geoCells->size());
+    for (const auto &geoCell : *m_geoCells) {
+        geoCells.emplace_back(geoCell.first, geoCell.second);
+    }
+
+    return geoCells;
+}
+
+bool CDBIndex::isTileExist(const CDBGeoCell &geoCell,
+                           CDBDataset dataset,
+                           int CS_1,
+                           int CS_2,
+                           int level,
+                           int UREF,
+                           int RREF,
+                           const std::string &extension) const
+{
+    const GeoCellIndex &index = getGeoCellIndex(geoCell);
+    auto extensionIter = std::find(index.extensions.begin(), index.extensions.end(), extension);
+    if (extensionIter == index.extensions.end()) {
+        return false;
+    }
+
+    size_t extensionIndex = static_cast<size_t>(extensionIter - index.extensions.begin());
+    return index.tiles.find(packTileKey(dataset, CS_1, CS_2, level, UREF, RREF, extensionIndex))
+           != index.tiles.end();
+}
+
+bool CDBIndex::isTileExist(const CDBTile &tile, const std::string &extension) const
+{
+    return isTileExist(tile.getGeoCell(),
+                       tile.getDataset(),
+                       tile.getCS_1(),
+                       tile.getCS_2(),
+                       tile.getLevel(),
+                       tile.getUREF(),
+                       tile.getRREF(),
+                       extension);
+}
+
+const std::vector<CDBIndex::File> &CDBIndex::getDatasetFiles(const CDBGeoCell &geoCell,
+                                                             CDBDataset dataset) const
+{
+    static const std::vector<File> EMPTY_FILES;
+
+    const GeoCellIndex &index = getGeoCellIndex(geoCell);
+    auto files = index.datasetFiles.find(static_cast<int>(dataset));
+    if (files == index.datasetFiles.end()) {
+        return EMPTY_FILES;
+    }
+
+    return files->second;
+}
+
+void CDBIndex::saveCache() const
+{
+    if (m_cachePath.empty() || !m_isCacheOutdated) {
+        return;
+    }
+
+    auto toRelativePath = [this](const std::filesystem::path &path) {
+        return path.lexically_relative(m_path).generic_string();
+    };
+
+    auto directoriesToJson = [&](const std::vector<Directory> &directories) {
+        json directoriesJson = json::array();
+        for (const auto &directory : directories) {
+            directoriesJson.push_back({toRelativePath(directory.path), directory.modifiedTime});
+        }
+
+        return directoriesJson;
+    };
+
+    auto datasetFilesToJson = [&](const std::map<int, std::vector<File>> &datasetFiles) {
+        json datasetFilesJson = json::array();
+        for (const auto &files : datasetFiles) {
+            json filesJson = json::array();
+            for (const auto &file : files.second) {
+                filesJson.push_back({toRelativePath(file.path), file.size, file.modifiedTime});
+            }
+
+            datasetFilesJson.push_back({{"dataset", files.first}, {"files", std::move(filesJson)}});
+        }
+
+        return datasetFilesJson;
+    };
+
+    json cache;
+    cache["version"] = CACHE_VERSION;
+    cache["geoCells"] = json::array();
+
+    std::vector<std::pair<int, int>> geoCells;
+    {
+        std::lock_guard<std::mutex> lock(m_geoCellsMutex);
+        if (m_geoCells) {
+            geoCells = *m_geoCells;
+            cache["geoCellDirectories"] = directoriesToJson(m_geoCellDirectories);
+        } else {
+            geoCells = m_cachedGeoCells;
+            cache["geoCellDirectories"] = directoriesToJson(m_cachedGeoCellDirectories);
+        }
+    }
+
+    // geocells that are not used in this run keep their cached entries, they are checked the next time
+    std::lock_guard<std::mutex> lock(m_geoCellIndicesMutex);
+    for (const auto &geoCell : geoCells) {
+        json geoCellJson = {{"latitude", geoCell.first}, {"longitude", geoCell.second}};
+        auto index = m_geoCellIndices.find(geoCell);
+        auto cachedIndex = m_cachedGeoCellIndices.find(geoCell);
+        if (index != m_geoCellIndices.end() && index->second.isIndexed) {
+            geoCellJson["directories"] = directoriesToJson(index->second.directories);
+            geoCellJson["datasets"] = datasetFilesToJson(index->second.datasetFiles);
+        } else if (cachedIndex != m_cachedGeoCellIndices.end()) {
+            geoCellJson["directories"] = directoriesToJson(cachedIndex->second.directories);
+            geoCellJson["datasets"] = datasetFilesToJson(cachedIndex->second.datasetFiles);
+        } else {
+            continue;
+        }
+
+        cache["geoCells"].emplace_back(std::move(geoCellJson));
+    }
+
+    // write to a temporary file first, so an interrupted run never leaves a truncated cache behind
+    std::filesystem::path temporaryCachePath = m_cachePath;
+    temporaryCachePath += ".tmp";
+    std::vector<uint8_t> cacheBytes = json::to_cbor(cache);
+    {
+        std::ofstream fs(temporaryCachePath, std::ios::binary);
+        fs.write(reinterpret_cast<const char *>(cacheBytes.data()),
+                 static_cast<std::streamsize>(cacheBytes.size()));
+        if (!fs) {
+            throw std::runtime_error("Failed to write " + temporaryCachePath.string());
+        }
+    }
+
+    std::filesystem::rename(temporaryCachePath, m_cachePath);
+}
+
+size_t CDBIndex::TileKeyHash::operator()(const TileKey &key) const noexcept
+{
+    size_t seed = 0;
+    hashCombine(seed, key.dataset);
+    hashCombine(seed, key.tile);
+    return seed;
+}
+
+const CDBIndex::GeoCellIndex &CDBIndex::getGeoCellIndex(const CDBGeoCell &geoCell) const
+{
+    // only hold the lock for the lookup, so geocells can be swept in parallel. Other threads
+    // asking for a geocell that is being swept wait for that sweep to finish
+    std::pair<int, int> geoCellKey{geoCell.getLatitude(), geoCell.getLongitude()};
+    GeoCellIndex *index;
+    {
+        std::lock_guard<std::mutex> lock(m_geoCellIndicesMutex);
+        index = &m_geoCellIndices[geoCellKey];
+    }
+
+    std::call_once(index->swept, [&]() {
+        // reuse the cached files when no directory of the geocell is modified since the cache is written,
+        // otherwise sweep the geocell again
+        auto cachedIndex = m_cachedGeoCellIndices.find(geoCellKey);
+        if (cachedIndex != m_cachedGeoCellIndices.end()
+            && isDirectoriesUnchanged(cachedIndex->second.directories)) {
+            index->directories = cachedIndex->second.directories;
+            for (const auto &files : cachedIndex->second.datasetFiles) {
+                for (const auto &file : files.second) {
+                    indexFile(files.first, file, *index);
+                }
+            }
+        } else {
+            sweepGeoCell(geoCell, *index);
+            m_isCacheOutdated = true;
+        }
+
+        index->isIndexed = true;
+    });
+
+    return *index;
+}
+
+void CDBIndex::sweepGeoCell(const CDBGeoCell &geoCell, GeoCellIndex &index) const
+{
+    // modified times are read before a directory is listed, so a change during the sweep
+    // makes the next run sweep it again
+    bool isRecordingStatus = !m_cachePath.empty();
+    auto recordDirectory = [&](const std::filesystem::path &directory) {
+        if (isRecordingStatus) {
+            index.directories.push_back({directory, getModifiedTime(directory).value_or(0)});
+        }
+    };
+
+    std::filesystem::path geoCellPath = m_path / geoCell.getRelativePath();
+    if (!VirtualFileSystem::isDirectory(geoCellPath)) {
+        return;
+    }
+
+    recordDirectory(geoCellPath);
+    for (const auto &datasetDir : VirtualFileSystem::listDirectory(geoCellPath)) {
+        if (!datasetDir.isDirectory) {
+            continue;
+        }
+
+        auto dataset = parseDatasetFromDirectoryName(datasetDir.path.filename().string());
+        if (!dataset) {
+            continue;
+        }
+
+        recordDirectory(datasetDir.path);
+        for (const auto &levelDir : VirtualFileSystem::listDirectory(datasetDir.path)) {
+            if (!levelDir.isDirectory) {
+                continue;
+            }
+
+            recordDirectory(levelDir.path);
+            for (const auto &UREFDir : VirtualFileSystem::listDirectory(levelDir.path)) {
+                if (!UREFDir.isDirectory) {
+                    continue;
+                }
+
+                recordDirectory(UREFDir.path);
+                for (const auto &tilePath : VirtualFileSystem::listDirectory(UREFDir.path)) {
+                    File file{tilePath.path, 0, 0};
+                    if (isRecordingStatus && !tilePath.isDirectory) {
+                        file.size = VirtualFileSystem::getFileSize(tilePath.path).value_or(0);
+                        file.modifiedTime = getModifiedTime(tilePath.path).value_or(0);
+                    }
+
+                    indexFile(*dataset, std::move(file), index);
+                }
+            }
+        }
+    }
+}
+
+void CDBIndex::indexFile(int dataset, File file, GeoCellIndex &index) const
+{
+    // only index files that sit where the CDB layout expects them, so a lookup
+    // answers exactly like checking the tile path on disk
+    auto stem = file.path.stem();
+    auto tile = CDBTile::createFromFile(stem.string());
+    if (tile && file.path.parent_path() / stem == m_path / tile->getRelativePath()) {
+        std::string extension = file.path.extension().string();
+        auto extensionIter = std::find(index.extensions.begin(), index.extensions.end(), extension);
+        if (extensionIter == index.extensions.end()) {
+            extensionIter = index.extensions.insert(index.extensions.end(), extension);
+        }
+
+        size_t extensionIndex = static_cast<size_t>(extensionIter - index.extensions.begin());
+        index.tiles.insert(packTileKey(tile->getDataset(),
+                                       tile->getCS_1(),
+                                       tile->getCS_2(),
+                                       tile->getLevel(),
+                                       tile->getUREF(),
+                                       tile->getRREF(),
+                                       extensionIndex));
+    }
+
+    index.datasetFiles[dataset].emplace_back(std::move(file));
+}
+
+void CDBIndex::loadCache()
+{
+    std::ifstream fs(m_cachePath, std::ios::binary);
+    if (!fs) {
+        return;
+    }
+
+    // a cache that can't be read is not an error, the CDB is swept again instead
+    try {
+        json cache = json::from_cbor(fs);
+        if (cache.at("version").get<int>() != CACHE_VERSION) {
+            return;
+        }
+
+        auto directoriesFromJson = [this](const json &directoriesJson) {
+            std::vector<Directory> directories;
+            directories.reserve(directoriesJson.size());
+            for (const auto &directory : directoriesJson) {
+                directories.push_back({m_path / directory.at(0).get<std::string>(),
+                                       directory.at(1).get<int64_t>()});
+            }
+
+            return directories;
+        };
+
+        std::vector<std::pair<int, int>> geoCells;
+        std::map<std::pair<int, int>, CachedGeoCell> geoCellIndices;
+        for (const auto &geoCellJson : cache.at("geoCells")) {
+            std::pair<int, int> geoCell{geoCellJson.at("latitude").get<int>(),
+                                        geoCellJson.at("longitude").get<int>()};
+            CachedGeoCell &cachedGeoCell = geoCellIndices[geoCell];
+            cachedGeoCell.directories = directoriesFromJson(geoCellJson.at("directories"));
+            for (const auto &datasetJson : geoCellJson.at("datasets")) {
+                auto &files = cachedGeoCell.datasetFiles[datasetJson.at("dataset").get<int>()];
+                for (const auto &fileJson : datasetJson.at("files")) {
+                    files.push_back({m_path / fileJson.at(0).get<std::string>(),
+                                     fileJson.at(1).get<uintmax_t>(),
+                                     fileJson.at(2).get<int64_t>()});
+                }
+            }
+
+            geoCells.emplace_back(geoCell);
+        }
+
+        m_cachedGeoCellDirectories = directoriesFromJson(cache.at("geoCellDirectories"));
+        m_cachedGeoCells = std::move(geoCells);
+        m_cachedGeoCellIndices = std::move(geoCellIndices);
+    } catch (const json::exception &) {
+        m_cachedGeoCellDirectories.clear();
+        m_cachedGeoCells.clear();
+        m_cachedGeoCellIndices.clear();
+    }
+}
+
+bool CDBIndex::isDirectoriesUnchanged(const std::vector<Directory> &directories)
+{
+    return std::all_of(directories.begin(), directories.end(), [](const Directory &directory) {
+        return getModifiedTime(directory.path) == directory.modifiedTime;
+    });
+}
+
+std::optional<int64_t> CDBIndex::getModifiedTime(const std::filesystem::path &path)
+{
+    return VirtualFileSystem::getModifiedTime(path);
+}
+
+std::optional<int> CDBIndex::parseDatasetFromDirectoryName(const std::string &directoryName)
+{
+    // dataset directory is named {code}_{name}, e.g 001_Elevation
+    if (directoryName.size() < 4 || directoryName[3] != '_') {
+        return std::nullopt;
+    }
+
+    if (!std::all_of(directoryName.begin(), directoryName.begin() + 3, [](char c) {
+            return std::isdigit(static_cast<unsigned char>(c));
+        })) {
+        return std::nullopt;
+    }
+
+    int dataset = std::stoi(directoryName.substr(0, 3));
+    if (!isValidDataset(dataset)) {
+        return std::nullopt;
+    }
+
+    return dataset;
+}
+
+CDBIndex::TileKey CDBIndex::packTileKey(
+    CDBDataset dataset, int CS_1, int CS_2, int level, int UREF, int RREF, size_t extensionIndex) noexcept
+{
+    // dataset, components and extension take 16 bits each. Level is offset by 10 to be positive, and
+    // UREF and RREF take 23 bits each, which is enough for the maximum level 23
+    TileKey key;
+    key.dataset = (static_cast<uint64_t>(dataset) & 0xFFFF) << 48
+                  | (static_cast<uint64_t>(CS_1) & 0xFFFF) << 32
+                  | (static_cast<uint64_t>(CS_2) & 0xFFFF) << 16
+                  | (static_cast<uint64_t>(extensionIndex) & 0xFFFF);
+    key.tile = (static_cast<uint64_t>(level + 10) & 0x3F) << 46
+               | (static_cast<uint64_t>(UREF) & 0x7FFFFF) << 23
+               | (static_cast<uint64_t>(RREF) & 0x7FFFFF);
+    return key;
+}
+
+} // namespace CDBTo3DTiles
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "CDBTile.h"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace CDBTo3DTiles {
+class CDBIndex
+{
+public:
+    struct File
+    {
+        std::filesystem::path path;
+        uintmax_t size;
+        int64_t modifiedTime;
+    };
+
+    explicit CDBIndex(const std::filesystem::path &CDBPath);
+
+    CDBIndex(const std::filesystem::path &CDBPath, const std::filesystem::path &cachePath);
+
+    CDBIndex(const CDBIndex &) = delete;
+
+    CDBIndex &operator=(const CDBIndex &) = delete;
+
+    std::vector<CDBGeoCell> getGeoCells() const;
+
+    bool isTileExist(const CDBGeoCell &geoCell,
+                     CDBDataset dataset,
+                     int CS_1,
+                     int CS_2,
+                     int level,
+                     int UREF,
+                     int RREF,
+                     const std::string &extension) const;
+
+    bool isTileExist(const CDBTile &tile, const std::string &extension) const;
+
+    const std::vector<File> &getDatasetFiles(const CDBGeoCell &geoCell, CDBDataset dataset) const;
+
+    void saveCache() const;
+
+    static const std::filesystem::path CACHE_FILE;
+
+private:
+    struct TileKey
+    {
+        uint64_t dataset;
+        uint64_t tile;
+
+        inline bool operator==(const TileKey &rhs) const noexcept
+        {
+            return dataset == rhs.dataset && tile == rhs.tile;
+        }
+    };
+
+    struct TileKeyHash
+    {
+        size_t operator()(const TileKey &key) const noexcept;
+    };
+
+    struct Directory
+    {
+        std::filesystem::path path;
+        int64_t modifiedTime;
+    };
+
+    struct CachedGeoCell
+    {
+        std::vector<Directory> directories;
+        std::map<int, std::vector<File>> datasetFiles;
+    };
+
+    struct GeoCellIndex
+    {
+        std::once_flag swept;
+        bool isIndexed{false};
+        std::vector<std::string> extensions;
+        std::unordered_set<TileKey, TileKeyHash> tiles;
+        std::map<int, std::vector<File>> datasetFiles;
+        std::vector<Directory> directories;
+    };
+
+    const GeoCellIndex &getGeoCellIndex(const CDBGeoCell &geoCell) const;
+
+    void sweepGeoCell(const CDBGeoCell &geoCell, GeoCellIndex &index) const;
+
+    void indexFile(int dataset, File file, GeoCellIndex &index) const;
+
+    void loadCache();
+
+    static bool isDirectoriesUnchanged(const std::vector<Directory> &directories);
+
+    static std::optional<int64_t> getModifiedTime(const std::filesystem::path &path);
+
+    static std::optional<int> parseDatasetFromDirectoryName(const std::string &directoryName);
+
+    static TileKey packTileKey(
+        CDBDataset dataset, int CS_1, int CS_2, int level, int UREF, int RREF, size_t extensionIndex) noexcept;
+
+    std::filesystem::path m_path;
+    std::filesystem::path m_cachePath;
+    std::vector<std::pair<int, int>> m_cachedGeoCells;
+    std::vector<Directory> m_cachedGeoCellDirectories;
+    std::map<std::pair<int, int>, CachedGeoCell> m_cachedGeoCellIndices;
+    mutable std::mutex m_geoCellsMutex;
+    mutable std::optional<std::vector<std::pair<int, int>>> m_geoCells;
+    mutable std::vector<Directory> m_geoCellDirectories;
+    mutable std::mutex m_geoCellIndicesMutex;
+    mutable std::map<std::pair<int, int>, GeoCellIndex> m_geoCellIndices;
+    mutable std::atomic<bool> m_isCacheOutdated;
+};
+} // namespace CDBTo3DTiles
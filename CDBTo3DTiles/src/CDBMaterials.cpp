@@ -1,7 +1,9 @@
 #include "CDBMaterials.h"
+#include "VirtualFileSystem.h"
 #include "rapidxml_utils.hpp"
 
 #include <iostream>
+#include <sstream>
 
 namespace CDBTo3DTiles {
 
@@ -10,7 +12,13 @@ static std::string BASE_MATERIAL_ENUM_NAME = "CDBBaseMaterial";
 
 void CDBMaterials::readBaseMaterialsFile(std::filesystem::path materialsXmlPath)
 {
-    rapidxml::file<> xmlFile(materialsXmlPath.c_str());
+    auto xmlContent = VirtualFileSystem::readFile(materialsXmlPath);
+    if (!xmlContent) {
+        throw std::runtime_error("cannot open file " + materialsXmlPath.string());
+    }
+
+    std::istringstream xmlStream(*xmlContent);
+    rapidxml::file<> xmlFile(xmlStream);
     rapidxml::xml_document<> xml;
     xml.parse<0>(xmlFile.data());
 
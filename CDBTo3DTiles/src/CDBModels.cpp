@@ -2,11 +2,13 @@
 #include "CDB.h"
 #include "Ellipsoid.h"
 #include "MathHelpers.h"
+#include "VirtualFileSystem.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/epsilon.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "osg/Material"
 #include "osgDB/ReadFile"
+#include <algorithm>
 #include <unordered_set>
 
 namespace CDBTo3DTiles {
@@ -142,6 +144,54 @@ void CDBModel3DResult::apply(osg::Group &group)
     popStateSet();
 }
 
+void CDBModel3DResult::merge(const CDBModel3DResult &other, int featureIDOffset)
+{
+    std::vector<osg::ref_ptr<osg::StateSet>> otherStateSets(other.m_meshes.size());
+    for (const auto &stateSetToMesh : other.m_stateSetToMesh) {
+        otherStateSets[stateSetToMesh.second] = stateSetToMesh.first;
+    }
+
+    // visit the other meshes in creation order, so new statesets get meshes and materials in the
+    // same order as if their geometries had been visited by this result
+    for (size_t i = 0; i < other.m_meshes.size(); ++i) {
+        const auto &otherMesh = other.m_meshes[i];
+        auto stateSetToMesh = m_stateSetToMesh.find(otherStateSets[i]);
+        if (stateSetToMesh == m_stateSetToMesh.end()) {
+            Material material = other.m_materials[static_cast<size_t>(otherMesh.material)];
+            if (material.texture != -1) {
+                m_images.emplace_back(other.m_images[static_cast<size_t>(material.texture)]);
+                m_textures.emplace_back(other.m_textures[static_cast<size_t>(material.texture)]);
+                material.texture = static_cast<int>(m_textures.size() - 1);
+            }
+
+            m_materials.emplace_back(material);
+
+            Mesh mesh{};
+            mesh.aabb = AABB();
+            mesh.material = static_cast<int>(m_materials.size() - 1);
+            m_meshes.emplace_back(mesh);
+            stateSetToMesh = m_stateSetToMesh.insert({otherStateSets[i], m_meshes.size() - 1}).first;
+        }
+
+        auto &mesh = m_meshes[stateSetToMesh->second];
+        auto indexOffset = static_cast<uint32_t>(mesh.positions.size());
+        mesh.indices.reserve(mesh.indices.size() + otherMesh.indices.size());
+        for (auto index : otherMesh.indices) {
+            mesh.indices.emplace_back(index + indexOffset);
+        }
+
+        mesh.batchIDs.reserve(mesh.batchIDs.size() + otherMesh.batchIDs.size());
+        for (auto batchID : otherMesh.batchIDs) {
+            mesh.batchIDs.emplace_back(batchID + static_cast<float>(featureIDOffset));
+        }
+
+        mesh.positions.insert(mesh.positions.end(), otherMesh.positions.begin(), otherMesh.positions.end());
+        mesh.normals.insert(mesh.normals.end(), otherMesh.normals.begin(), otherMesh.normals.end());
+        mesh.UVs.insert(mesh.UVs.end(), otherMesh.UVs.begin(), otherMesh.UVs.end());
+        mesh.aabb->merge(*otherMesh.aabb);
+    }
+}
+
 void CDBModel3DResult::finalize()
 {
     for (auto &mesh : m_meshes) {
@@ -348,30 +398,55 @@ const CDBModel3DResult *CDBGTModelCache::locateModel3D(const std::string &FACC,
                                                        std::string &modelKey) const
 {
     std::string key = getModelKey(FACC, MODL, FSC);
-    auto model = m_keyToModel.find(key);
-    if (model != m_keyToModel.end()) {
-        modelKey = key;
-        return &model->second;
+    CachedModel *cachedModel;
+    {
+        std::lock_guard<std::mutex> lock(m_keyToModelMutex);
+        cachedModel = &m_keyToModel[key];
+    }
+
+    // parse outside of the lock, so different models are loaded in parallel. Threads asking for
+    // the same model wait for the first one to finish parsing it
+    std::call_once(cachedModel->loaded, [&]() {
+        auto model3D = loadModel3D(FACC, key);
+        if (model3D) {
+            cachedModel->model.emplace(std::move(*model3D));
+        }
+    });
+    if (!cachedModel->model) {
+        return nullptr;
     }
 
-    for (std::filesystem::directory_entry A_Cartegory : std::filesystem::directory_iterator(
+    modelKey = key;
+    return &*cachedModel->model;
+}
+
+std::optional<CDBModel3DResult> CDBGTModelCache::loadModel3D(const std::string &FACC,
+                                                             const std::string &key) const
+{
+    for (const auto &A_Cartegory : VirtualFileSystem::listDirectory(
              m_CDBPath / CDB::GTModel / getCDBDatasetDirectoryName(CDBDataset::GTModelGeometry_500))) {
-        if (A_Cartegory.path().filename().string().front() == FACC[0]) {
-            for (std::filesystem::directory_entry B_Subcartegory :
-                 std::filesystem::directory_iterator(A_Cartegory)) {
-                if (B_Subcartegory.path().filename().string().front() == FACC[1]) {
-                    for (std::filesystem::directory_entry featureCodeDir :
-                         std::filesystem::directory_iterator(B_Subcartegory)) {
-                        if (featureCodeDir.path().filename().string().substr(0, 3) == FACC.substr(2, 3)) {
-                            osg::ref_ptr<osg::Node> geometry = osgDB::readRefNodeFile(featureCodeDir.path()
-                                                                                      / (key + ".flt"));
+        if (A_Cartegory.path.filename().string().front() == FACC[0]) {
+            for (const auto &B_Subcartegory : VirtualFileSystem::listDirectory(A_Cartegory.path)) {
+                if (B_Subcartegory.path.filename().string().front() == FACC[1]) {
+                    for (const auto &featureCodeDir : VirtualFileSystem::listDirectory(B_Subcartegory.path)) {
+                        if (featureCodeDir.path.filename().string().substr(0, 3) == FACC.substr(2, 3)) {
+                            auto modelPath = featureCodeDir.path / (key + ".flt");
+                            osg::ref_ptr<osg::Node> geometry;
+                            if (VirtualFileSystem::isVirtualPath(modelPath)) {
+                                // OSG reads a local copy of an archived model
+                                osg::ref_ptr<osgDB::Options> options = new osgDB::Options();
+                                options->setFindFileCallback(new FindArchivedFile());
+                                geometry = osgDB::readRefNodeFile(
+                                    VirtualFileSystem::getLocalPath(modelPath).string(), options.get());
+                            } else {
+                                geometry = osgDB::readRefNodeFile(modelPath);
+                            }
+
                             if (geometry) {
                                 CDBModel3DResult model3D;
                                 geometry->accept(model3D);
                                 model3D.finalize();
-                                m_keyToModel.insert({key, std::move(model3D)});
-                                modelKey = key;
-                                return &m_keyToModel[key];
+                                return model3D;
                             }
                         }
                     }
@@ -380,7 +455,40 @@ const CDBModel3DResult *CDBGTModelCache::locateModel3D(const std::string &FACC,
         }
     }
 
-    return nullptr;
+    return std::nullopt;
+}
+
+std::string CDBGTModelCache::FindArchivedFile::findDataFile(const std::string &filename,
+                                                            const osgDB::Options *options,
+                                                            osgDB::CaseSensitivity caseSensitivity)
+{
+    std::string fileFound = FindFileCallback::findDataFile(filename, options, caseSensitivity);
+    if (!fileFound.empty() || options == nullptr) {
+        return fileFound;
+    }
+
+    // OSG looks next to the local copy of the model, so resolve the file from the archived directory that
+    // the copy is extracted from, and extract it as well
+    for (const auto &localDirectory : options->getDatabasePathList()) {
+        auto archivedPath = VirtualFileSystem::getArchivedDirectory(localDirectory);
+        if (!archivedPath) {
+            continue;
+        }
+
+        for (const auto &part : std::filesystem::path(filename)) {
+            if (part == "..") {
+                *archivedPath = archivedPath->parent_path();
+            } else if (part != ".") {
+                *archivedPath /= part;
+            }
+        }
+
+        if (VirtualFileSystem::exists(*archivedPath)) {
+            return VirtualFileSystem::getLocalPath(*archivedPath).string();
+        }
+    }
+
+    return "";
 }
 
 std::string CDBGTModelCache::getModelKey(const std::string &FACC, const std::string &MODL, int FCC) const
@@ -416,6 +524,42 @@ const CDBModel3DResult *CDBGTModels::locateModel3D(size_t instanceIdx, std::stri
     return nullptr;
 }
 
+void CDBGTModels::loadModels3D(ThreadPool *threadPool) const
+{
+    const auto &instancesAttribs = m_attributes->getInstancesAttributes();
+    const auto &stringAttribs = instancesAttribs.getStringAttribs();
+    const auto &integerAttribs = instancesAttribs.getIntegerAttribs();
+    auto FACCs = stringAttribs.find("FACC");
+    auto MODLs = stringAttribs.find("MODL");
+    auto FSCs = integerAttribs.find("FSC");
+    if (FACCs == stringAttribs.end() || MODLs == stringAttribs.end() || FSCs == integerAttribs.end()) {
+        return;
+    }
+
+    size_t instanceCount = instancesAttribs.getInstancesCount();
+    if (FACCs->second.size() != instanceCount || MODLs->second.size() != instanceCount
+        || FSCs->second.size() != instanceCount) {
+        return;
+    }
+
+    // the cache parses each model once, so only the first instance of a model needs a task
+    std::unordered_set<std::string> models;
+    TaskGroup modelTasks(threadPool);
+    for (size_t i = 0; i < instanceCount; ++i) {
+        const auto &FACC = FACCs->second[i];
+        const auto &MODL = MODLs->second[i];
+        int FSC = FSCs->second[i];
+        if (models.insert(FACC + "_" + std::to_string(FSC) + "_" + MODL).second) {
+            modelTasks.run([this, &FACC, &MODL, FSC]() {
+                std::string modelKey;
+                m_cache->locateModel3D(FACC, MODL, FSC, modelKey);
+            });
+        }
+    }
+
+    modelTasks.wait();
+}
+
 std::optional<CDBGTModels> CDBGTModels::createFromModelsAttributes(CDBModelsAttributes attributes,
                                                                    CDBGTModelCache *cache)
 {
@@ -432,10 +576,25 @@ std::optional<CDBGTModels> CDBGTModels::createFromModelsAttributes(CDBModelsAttr
     return CDBGTModels(std::move(attributes), cache);
 }
 
+static const size_t MIN_INSTANCES_PER_TASK = 32;
+
+static osg::ref_ptr<osgDB::Archive> reopenArchive(const osgDB::Archive &archive)
+{
+    osgDB::ReaderWriter *rw = osgDB::Registry::instance()->getReaderWriterForExtension("zip");
+    osgDB::ReaderWriter::ReadResult archiveRead = rw->openArchive(archive.getArchiveFileName(),
+                                                                  osgDB::Archive::READ);
+    if (!archiveRead.validArchive()) {
+        throw std::runtime_error("Failed to open " + archive.getArchiveFileName());
+    }
+
+    return archiveRead.takeArchive();
+}
+
 CDBGSModels::CDBGSModels(CDBModelsAttributes modelsAttributes,
                          const CDBTile &GSModelTile,
                          const osg::ref_ptr<osgDB::Archive> &GSModelArchive,
-                         const osg::ref_ptr<osgDB::Options> &options)
+                         const osg::ref_ptr<osgDB::Options> &options,
+                         ThreadPool *threadPool)
     : m_GSModelArchive{GSModelArchive}
     , m_tile{GSModelTile}
 {
@@ -452,6 +611,11 @@ CDBGSModels::CDBGSModels(CDBModelsAttributes modelsAttributes,
 
     Core::Ellipsoid ellipsoid = Core::Ellipsoid::WGS84;
     const auto &cartographicPositions = modelsAttributes.getCartographicPositions();
+    std::vector<glm::dvec3> worldPositions(cartographicPositions.size());
+    ellipsoid.cartographicToCartesian(cartographicPositions.data(),
+                                      cartographicPositions.size(),
+                                      worldPositions.data());
+
     const auto &orientations = modelsAttributes.getOrientations();
     const auto &scales = modelsAttributes.getScales();
     const auto &instancesAttribs = modelsAttributes.getInstancesAttributes();
@@ -461,45 +625,108 @@ CDBGSModels::CDBGSModels(CDBModelsAttributes modelsAttributes,
     auto MODLs = stringAttribs.find("MODL");
     auto FSCs = integerAttribs.find("FSC");
 
-    // extract attributes for this tile only
-    size_t totalInputInstanceCount = instancesAttribs.getInstancesCount();
-    std::vector<size_t> extractedInstances;
-    extractedInstances.reserve(totalInputInstanceCount);
-    int featureID = 0;
-    for (size_t i = 0; i < totalInputInstanceCount; ++i) {
-        const auto &FACC = FACCs->second[i];
-        const auto &MODL = MODLs->second[i];
-        int FSC = FSCs->second[i];
-        std::string modelFilename = getModelFilename(FACC, MODL, FSC);
-        if (geometryFilenames.find(modelFilename) != geometryFilenames.end()) {
-            auto result = m_GSModelArchive->readNode(modelFilename, options.get());
-            if (result.validNode()) {
-                // combine mesh
-                osg::ref_ptr<osg::Node> node = result.takeNode();
-                glm::dvec3 worldPosition = ellipsoid.cartographicToCartesian(cartographicPositions[i]);
-
-                double orientation = 0.0;
-                if (i < orientations.size()) {
-                    orientation = orientations[i];
-                }
+    // decode a range of instances into its own result, numbering the features from 0
+    auto decodeInstances = [&](size_t begin,
+                               size_t end,
+                               osgDB::Archive &archive,
+                               const osgDB::Options *readOptions,
+                               CDBModel3DResult &model3DResult,
+                               std::vector<size_t> &extractedInstances) {
+        int featureID = 0;
+        for (size_t i = begin; i < end; ++i) {
+            const auto &FACC = FACCs->second[i];
+            const auto &MODL = MODLs->second[i];
+            int FSC = FSCs->second[i];
+            std::string modelFilename = getModelFilename(FACC, MODL, FSC);
+            if (geometryFilenames.find(modelFilename) != geometryFilenames.end()) {
+                auto result = archive.readNode(modelFilename, readOptions);
+                if (result.validNode()) {
+                    // combine mesh
+                    osg::ref_ptr<osg::Node> node = result.takeNode();
+                    const glm::dvec3 &worldPosition = worldPositions[i];
+
+                    double orientation = 0.0;
+                    if (i < orientations.size()) {
+                        orientation = orientations[i];
+                    }
 
-                glm::dvec3 scale(1.0f);
-                if (i < scales.size()) {
-                    scale = scales[i];
-                }
+                    glm::dvec3 scale(1.0f);
+                    if (i < scales.size()) {
+                        scale = scales[i];
+                    }
 
-                glm::dmat4 transform = glm::scale(calculateModelOrientation(worldPosition, orientation),
-                                                  scale);
+                    glm::dmat4 transform = glm::scale(calculateModelOrientation(worldPosition, orientation),
+                                                      scale);
 
-                m_model3DResult.setTransformationMatrix(transform);
-                m_model3DResult.setFeatureID(featureID);
-                node->accept(m_model3DResult);
+                    model3DResult.setTransformationMatrix(transform);
+                    model3DResult.setFeatureID(featureID);
+                    node->accept(model3DResult);
 
-                // extract input instance index
-                extractedInstances.emplace_back(i);
-                ++featureID;
+                    // extract input instance index
+                    extractedInstances.emplace_back(i);
+                    ++featureID;
+                }
             }
         }
+    };
+
+    // split the instances into contiguous ranges, so merging the partial results in order gives the
+    // same meshes and feature IDs as decoding them one by one
+    size_t totalInputInstanceCount = instancesAttribs.getInstancesCount();
+    size_t taskCount = 1;
+    if (threadPool) {
+        size_t maxTaskCount = (totalInputInstanceCount + MIN_INSTANCES_PER_TASK - 1) / MIN_INSTANCES_PER_TASK;
+        taskCount = std::max<size_t>(std::min(threadPool->getThreadCount() + 1, maxTaskCount), 1);
+    }
+
+    std::vector<CDBModel3DResult> partialResults(taskCount - 1);
+    std::vector<std::vector<size_t>> partialExtractedInstances(taskCount);
+    TaskGroup decodeTasks(threadPool);
+    for (size_t task = 0; task < taskCount; ++task) {
+        decodeTasks.run([&, task]() {
+            size_t begin = totalInputInstanceCount * task / taskCount;
+            size_t end = totalInputInstanceCount * (task + 1) / taskCount;
+            partialExtractedInstances[task].reserve(end - begin);
+            if (task == 0) {
+                decodeInstances(begin,
+                                end,
+                                *m_GSModelArchive,
+                                options.get(),
+                                m_model3DResult,
+                                partialExtractedInstances[task]);
+                return;
+            }
+
+            // OSG keys its zip handles by OpenThreads thread, which all of our workers share,
+            // so every other task reads through archives of its own
+            osg::ref_ptr<osgDB::Archive> archive = reopenArchive(*m_GSModelArchive);
+            osg::ref_ptr<osgDB::Options> readOptions = options->cloneOptions();
+            auto findMissingFile = dynamic_cast<FindGSModelTexture *>(options->getReadFileCallback());
+            if (findMissingFile) {
+                osg::ref_ptr<FindGSModelTexture> taskFindMissingFile = findMissingFile->reopen();
+                readOptions->setFindFileCallback(taskFindMissingFile);
+                readOptions->setReadFileCallback(taskFindMissingFile);
+            }
+
+            decodeInstances(begin,
+                            end,
+                            *archive,
+                            readOptions.get(),
+                            partialResults[task - 1],
+                            partialExtractedInstances[task]);
+            archive->close();
+        });
+    }
+
+    decodeTasks.wait();
+
+    // offset the feature IDs of each partial result by the features decoded before it
+    std::vector<size_t> extractedInstances = std::move(partialExtractedInstances.front());
+    for (size_t task = 1; task < taskCount; ++task) {
+        m_model3DResult.merge(partialResults[task - 1], static_cast<int>(extractedInstances.size()));
+        extractedInstances.insert(extractedInstances.end(),
+                                  partialExtractedInstances[task].begin(),
+                                  partialExtractedInstances[task].end());
     }
 
     extractInputInstancesAttribs(extractedInstances, instancesAttribs);
@@ -511,6 +738,9 @@ CDBGSModels::~CDBGSModels() noexcept
 {
     // OSG doesn't close the archive after ref_ptr is released, so we do it ourselves
     m_GSModelArchive->close();
+
+    // the models are decoded when they are created, so a local copy of the archive isn't read anymore
+    VirtualFileSystem::removeLocalPath(m_archivedGSModelZip);
 }
 
 std::string CDBGSModels::getModelFilename(const std::string &FACC, const std::string &MODL, int FSC) const
@@ -519,7 +749,8 @@ std::string CDBGSModels::getModelFilename(const std::string &FACC, const std::st
 }
 
 std::optional<CDBGSModels> CDBGSModels::createFromModelsAttributes(CDBModelsAttributes attributes,
-                                                                   const std::filesystem::path &CDBPath)
+                                                                   const std::filesystem::path &CDBPath,
+                                                                   ThreadPool *threadPool)
 {
     const auto &instancesAttribs = attributes.getInstancesAttributes();
     const auto &stringAttribs = instancesAttribs.getStringAttribs();
@@ -542,10 +773,14 @@ std::optional<CDBGSModels> CDBGSModels::createFromModelsAttributes(CDBModelsAttr
                       attributeTile.getRREF());
 
     std::filesystem::path GSModelZip = CDBPath / (modelTile.getRelativePath().string() + ".zip");
-    if (!std::filesystem::exists(GSModelZip)) {
+    if (!VirtualFileSystem::exists(GSModelZip)) {
         return std::nullopt;
     }
 
+    // OSG opens a local copy of a model archive that is itself inside an archived CDB
+    std::filesystem::path archivedGSModelZip = GSModelZip;
+    GSModelZip = VirtualFileSystem::getLocalPath(GSModelZip);
+
     osgDB::ReaderWriter *rw = osgDB::Registry::instance()->getReaderWriterForExtension("zip");
     if (rw) {
         // set relative path for GSModel
@@ -565,6 +800,9 @@ std::optional<CDBGSModels> CDBGSModels::createFromModelsAttributes(CDBModelsAttr
         std::filesystem::path GSModelTextureRelPath = GSModelTextureTile.getRelativePath();
         std::string GSModelTextureTileName = GSModelTextureRelPath.stem().string();
         std::filesystem::path GSModelTextureZip = CDBPath / (GSModelTextureRelPath.string() + ".zip");
+        if (VirtualFileSystem::exists(GSModelTextureZip)) {
+            GSModelTextureZip = VirtualFileSystem::getLocalPath(GSModelTextureZip);
+        }
         osgDB::ReaderWriter::ReadResult GSModelTextureRead = rw->openArchive(GSModelTextureZip,
                                                                              osgDB::Archive::READ);
         if (GSModelTextureRead.validArchive()) {
@@ -579,10 +817,13 @@ std::optional<CDBGSModels> CDBGSModels::createFromModelsAttributes(CDBModelsAttr
         osgDB::ReaderWriter::ReadResult GSModelRead = rw->openArchive(GSModelZip, osgDB::Archive::READ);
         if (GSModelRead.validArchive()) {
             osg::ref_ptr<osgDB::Archive> archive = GSModelRead.takeArchive();
-            return CDBGSModels(std::move(attributes), modelTile, archive, options);
+            CDBGSModels models(std::move(attributes), modelTile, archive, options, threadPool);
+            models.m_archivedGSModelZip = std::move(archivedGSModelZip);
+            return models;
         }
     }
 
+    VirtualFileSystem::removeLocalPath(archivedGSModelZip);
     return std::nullopt;
 }
 
@@ -637,6 +878,11 @@ CDBGSModels::FindGSModelTexture::FindGSModelTexture(const std::string &GSModelTe
     , m_GSModelTextureTileName{GSModelTextureTileName}
 {}
 
+osg::ref_ptr<CDBGSModels::FindGSModelTexture> CDBGSModels::FindGSModelTexture::reopen() const
+{
+    return new FindGSModelTexture(m_GSModelTextureTileName, reopenArchive(*m_archive));
+}
+
 CDBGSModels::FindGSModelTexture::~FindGSModelTexture() noexcept
 {
     // OSG doesn't close the archive after ref_ptr is released, so we do it ourselves
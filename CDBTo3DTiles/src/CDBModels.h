@@ -2,10 +2,12 @@
 
 #include "CDBAttributes.h"
 #include "Scene.h"
+#include "ThreadPool.h"
 #include "osg/NodeVisitor"
 #include "osg/StateSet"
 #include "osgDB/Archive"
 #include <map>
+#include <mutex>
 #include <stack>
 
 namespace CDBTo3DTiles {
@@ -132,6 +134,8 @@ public:
 
     void apply(osg::Group &group) override;
 
+    void merge(const CDBModel3DResult &other, int featureIDOffset);
+
     void finalize();
 
     inline const std::vector<Mesh> &getMeshes() const noexcept { return m_meshes; }
@@ -175,16 +179,38 @@ class CDBGTModelCache
 public:
     CDBGTModelCache(const std::filesystem::path &CDBPath);
 
+    CDBGTModelCache(const CDBGTModelCache &) = delete;
+
+    CDBGTModelCache &operator=(const CDBGTModelCache &) = delete;
+
     const CDBModel3DResult *locateModel3D(const std::string &FACC,
                                           const std::string &MODL,
                                           int FSC,
                                           std::string &modelKey) const;
 
 private:
+    struct CachedModel
+    {
+        std::once_flag loaded;
+        std::optional<CDBModel3DResult> model;
+    };
+
+    // finds the textures of a model that is extracted from an archive in the archived model directory
+    class FindArchivedFile : public osgDB::FindFileCallback
+    {
+    public:
+        std::string findDataFile(const std::string &filename,
+                                 const osgDB::Options *options,
+                                 osgDB::CaseSensitivity caseSensitivity) override;
+    };
+
     std::string getModelKey(const std::string &FACC, const std::string &MODL, int FCC) const;
 
+    std::optional<CDBModel3DResult> loadModel3D(const std::string &FACC, const std::string &key) const;
+
     std::filesystem::path m_CDBPath;
-    mutable std::map<std::string, CDBModel3DResult> m_keyToModel;
+    mutable std::mutex m_keyToModelMutex;
+    mutable std::map<std::string, CachedModel> m_keyToModel;
 };
 
 class CDBGTModels
@@ -196,6 +222,8 @@ public:
 
     const CDBModel3DResult *locateModel3D(size_t instanceIdx, std::string &modelKey) const;
 
+    void loadModels3D(ThreadPool *threadPool) const;
+
     static std::optional<CDBGTModels> createFromModelsAttributes(CDBModelsAttributes attributes,
                                                                  CDBGTModelCache *cache);
 
@@ -210,7 +238,8 @@ public:
     explicit CDBGSModels(CDBModelsAttributes modelsAttributes,
                          const CDBTile &tile,
                          const osg::ref_ptr<osgDB::Archive> &GSModelArchive,
-                         const osg::ref_ptr<osgDB::Options> &options);
+                         const osg::ref_ptr<osgDB::Options> &options,
+                         ThreadPool *threadPool = nullptr);
 
     ~CDBGSModels() noexcept;
 
@@ -221,7 +250,8 @@ public:
     inline const CDBModel3DResult &getModel3D() const noexcept { return m_model3DResult; }
 
     static std::optional<CDBGSModels> createFromModelsAttributes(CDBModelsAttributes attributes,
-                                                                 const std::filesystem::path &CDBPath);
+                                                                 const std::filesystem::path &CDBPath,
+                                                                 ThreadPool *threadPool = nullptr);
 
 private:
     class FindGSModelTexture : public osgDB::FindFileCallback, public osgDB::ReadFileCallback
@@ -238,6 +268,8 @@ private:
         osgDB::ReaderWriter::ReadResult readImage(const std::string &filename,
                                                   const osgDB::Options *options) override;
 
+        osg::ref_ptr<FindGSModelTexture> reopen() const;
+
     private:
         std::string searchArchiveTextureName(const std::string &filename);
 
@@ -254,6 +286,7 @@ private:
     std::string m_tileFilename;
     CDBModel3DResult m_model3DResult;
     osg::ref_ptr<osgDB::Archive> m_GSModelArchive;
+    std::filesystem::path m_archivedGSModelZip;
     std::optional<CDBTile> m_tile;
     CDBInstancesAttributes m_attributes;
 };
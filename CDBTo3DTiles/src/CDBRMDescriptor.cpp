@@ -1,8 +1,10 @@
 #include "CDBRMDescriptor.h"
+#include "VirtualFileSystem.h"
 #include "rapidxml_utils.hpp"
 #include "tiny_gltf.h"
 #include <iostream>
 #include <nlohmann/json.hpp>
+#include <sstream>
 #include <vector>
 #include "Gltf.h"
 #include <tinyutf8/tinyutf8.h>
@@ -21,7 +23,13 @@ CDBRMDescriptor::CDBRMDescriptor(std::filesystem::path xmlPath, const CDBTile &t
 void CDBRMDescriptor::addFeatureTableToGltf(CDBMaterials *materials, tinygltf::Model *gltf, bool externalSchema)
 {
     // Parse RMDescriptor XML file.
-    rapidxml::file<> xmlFile(_xmlPath.c_str());
+    auto xmlContent = VirtualFileSystem::readFile(_xmlPath);
+    if (!xmlContent) {
+        throw std::runtime_error("cannot open file " + _xmlPath.string());
+    }
+
+    std::istringstream xmlStream(*xmlContent);
+    rapidxml::file<> xmlFile(xmlStream);
     rapidxml::xml_document<> xml;
     xml.parse<0>(xmlFile.data());
 
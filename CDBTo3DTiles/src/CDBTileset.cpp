@@ -75,6 +75,8 @@ CDBTile *CDBTileset::insertTile(const CDBTile &tile)
         }
     }
 
+    // tiles of the same tileset can be converted concurrently
+    std::lock_guard<std::mutex> insertLock(m_insertMutex);
     if (m_tiles.empty()) {
         auto cdbRoot = std::make_unique<CDBTile>(tile.getGeoCell(),
                                                  tile.getDataset(),
@@ -3,6 +3,7 @@
 #include "CDBTile.h"
 #include "Cartographic.h"
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace CDBTo3DTiles {
@@ -34,6 +35,7 @@ private:
     int m_rootUREF;
     int m_rootRREF;
     std::vector<std::unique_ptr<CDBTile>> m_tiles;
+    std::mutex m_insertMutex;
 };
 
 } // namespace CDBTo3DTiles
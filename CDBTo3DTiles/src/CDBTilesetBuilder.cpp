@@ -5,9 +5,13 @@
 #include "Gltf.h"
 #include "Math.h"
 #include "TileFormatIO.h"
+#include "cpl_vsi.h"
 #include "gdal.h"
+#include "osgDB/Registry"
 #include "osgDB/WriteFile"
+#include <atomic>
 #include <morton.h>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <unordered_map>
 #include <unordered_set>
@@ -30,6 +34,221 @@ const std::unordered_set<std::string> CDBTilesetBuilder::DATASET_PATHS = {ELEVAT
                                                                           HYDROGRAPHY_NETWORK_PATH,
                                                                           GTMODEL_PATH,
                                                                           GSMODEL_PATH};
+
+std::unique_ptr<CDBTilesetBuilder> CDBTilesetBuilder::createGeoCellBuilder() const
+{
+    // construct with an empty output path so the output of the running conversion isn't removed
+    auto builder = std::make_unique<CDBTilesetBuilder>(cdbPath, std::filesystem::path());
+    builder->outputPath = outputPath;
+    builder->elevationNormal = elevationNormal;
+    builder->elevationLOD = elevationLOD;
+    builder->use3dTilesNext = use3dTilesNext;
+    builder->externalSchema = externalSchema;
+    builder->subtreeLevels = subtreeLevels;
+    builder->nodeAvailabilityByteLengthWithPadding = nodeAvailabilityByteLengthWithPadding;
+    builder->childSubtreeAvailabilityByteLengthWithPadding = childSubtreeAvailabilityByteLengthWithPadding;
+    builder->subtreeNodeCount = subtreeNodeCount;
+    builder->childSubtreeCount = childSubtreeCount;
+    builder->availabilityByteLength = availabilityByteLength;
+    builder->childSubtreeAvailabilityByteLength = childSubtreeAvailabilityByteLength;
+    builder->elevationDecimateError = elevationDecimateError;
+    builder->elevationThresholdIndices = elevationThresholdIndices;
+    builder->elevationSimplifier = elevationSimplifier;
+    builder->elevationClipSubRegions = elevationClipSubRegions;
+    builder->threadCount = threadCount;
+    builder->threadPool = threadPool;
+    builder->pipelineQueueDepth = pipelineQueueDepth;
+    builder->pipelineBuilderThreads = pipelineBuilderThreads;
+    builder->pipelineEncoderThreads = pipelineEncoderThreads;
+    builder->pipelineWriterThreads = pipelineWriterThreads;
+    builder->writerThreads = writerThreads;
+    builder->writerMemoryBudget = writerMemoryBudget;
+    builder->fileWriter = fileWriter;
+    builder->outputSink = outputSink;
+    builder->deduplicateOutput = deduplicateOutput;
+    builder->tileLayout = tileLayout;
+    builder->prefetchTiles = prefetchTiles;
+    builder->prefetchThreads = prefetchThreads;
+    builder->prefetchMemoryBudget = prefetchMemoryBudget;
+    builder->prefetcher = prefetcher;
+    builder->materials = materials;
+    return builder;
+}
+
+void CDBTilesetBuilder::convertGeoCell(CDB &cdb, const CDBGeoCell &geoCell)
+{
+    datasetCSSubtrees.clear();
+    datasetDirs.clear();
+
+    // create directories for converted GeoCell
+    std::filesystem::path geoCellRelativePath = geoCell.getRelativePath();
+    std::filesystem::path geoCellAbsolutePath = outputPath / geoCellRelativePath;
+    std::filesystem::path elevationDir = geoCellAbsolutePath / ELEVATIONS_PATH;
+    std::filesystem::path GTModelDir = geoCellAbsolutePath / GTMODEL_PATH;
+    std::filesystem::path GSModelDir = geoCellAbsolutePath / GSMODEL_PATH;
+    std::filesystem::path roadNetworkDir = geoCellAbsolutePath / ROAD_NETWORK_PATH;
+    std::filesystem::path railRoadNetworkDir = geoCellAbsolutePath / RAILROAD_NETWORK_PATH;
+    std::filesystem::path powerlineNetworkDir = geoCellAbsolutePath / POWERLINE_NETWORK_PATH;
+    std::filesystem::path hydrographyNetworkDir = geoCellAbsolutePath / HYDROGRAPHY_NETWORK_PATH;
+    datasetDirs.insert(std::pair<CDBDataset, std::filesystem::path>(CDBDataset::Elevation, elevationDir));
+    datasetDirs.insert(std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GSFeature, GSModelDir));
+    datasetDirs.insert(std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GSModelGeometry, GSModelDir));
+    datasetDirs.insert(std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GSModelTexture, GSModelDir));
+    datasetDirs.insert(std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GTFeature, GTModelDir));
+    datasetDirs.insert(
+        std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GTModelGeometry_500, GTModelDir));
+    datasetDirs.insert(std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GTModelTexture, GTModelDir));
+    datasetDirs.insert(std::pair<CDBDataset, std::filesystem::path>(CDBDataset::RoadNetwork, roadNetworkDir));
+    datasetDirs.insert(
+        std::pair<CDBDataset, std::filesystem::path>(CDBDataset::RailRoadNetwork, railRoadNetworkDir));
+    datasetDirs.insert(
+        std::pair<CDBDataset, std::filesystem::path>(CDBDataset::PowerlineNetwork, powerlineNetworkDir));
+    datasetDirs.insert(
+        std::pair<CDBDataset, std::filesystem::path>(CDBDataset::HydrographyNetwork, hydrographyNetworkDir));
+
+    // each pass writes to its own dataset directory and tileset collections
+    std::vector<std::function<void(CDBTilesetBuilder &)>> datasetPasses = {
+        // process elevation
+        [&](CDBTilesetBuilder &builder) {
+            if (builder.pipelineQueueDepth > 0) {
+                builder.addElevationsWithPipeline(cdb, geoCell, elevationDir);
+                builder.flushTilesetCollection(geoCell, builder.elevationTilesets);
+                std::unordered_map<CDBTile, ParentImagery>().swap(builder.processedParentImagery);
+                return;
+            }
+
+            // every source tile is its own task. Bound the tiles in flight, since each holds its raster
+            TaskGroup elevationTasks(builder.threadPool);
+            size_t maxPendingElevations = 0;
+            if (builder.threadPool) {
+                maxPendingElevations = 2 * builder.threadPool->getThreadCount() + 2;
+            }
+
+            cdb.forEachElevationTile(
+                geoCell,
+                [&](CDBElevation elevation) {
+                    elevationTasks.run(
+                        [&builder, &cdb, &elevationDir, elevation = std::move(elevation)]() mutable {
+                            builder.addElevationToTilesetCollection(elevation, cdb, elevationDir);
+                        });
+                    elevationTasks.limitPendingTasks(maxPendingElevations);
+                },
+                builder.prefetcher);
+            elevationTasks.wait();
+            builder.flushTilesetCollection(geoCell, builder.elevationTilesets);
+            std::unordered_map<CDBTile, ParentImagery>().swap(builder.processedParentImagery);
+        },
+
+        // process road network
+        [&](CDBTilesetBuilder &builder) {
+            cdb.forEachRoadNetworkTile(geoCell, [&](const CDBGeometryVectors &roadNetwork) {
+                builder.addVectorToTilesetCollection(roadNetwork,
+                                                     roadNetworkDir,
+                                                     builder.roadNetworkTilesets);
+            });
+            builder.flushTilesetCollection(geoCell, builder.roadNetworkTilesets);
+        },
+
+        // process railroad network
+        [&](CDBTilesetBuilder &builder) {
+            cdb.forEachRailRoadNetworkTile(geoCell, [&](const CDBGeometryVectors &railRoadNetwork) {
+                builder.addVectorToTilesetCollection(railRoadNetwork,
+                                                     railRoadNetworkDir,
+                                                     builder.railRoadNetworkTilesets);
+            });
+            builder.flushTilesetCollection(geoCell, builder.railRoadNetworkTilesets);
+        },
+
+        // process powerline network
+        [&](CDBTilesetBuilder &builder) {
+            cdb.forEachPowerlineNetworkTile(geoCell, [&](const CDBGeometryVectors &powerlineNetwork) {
+                builder.addVectorToTilesetCollection(powerlineNetwork,
+                                                     powerlineNetworkDir,
+                                                     builder.powerlineNetworkTilesets);
+            });
+            builder.flushTilesetCollection(geoCell, builder.powerlineNetworkTilesets);
+        },
+
+        // process hydrography network
+        [&](CDBTilesetBuilder &builder) {
+            cdb.forEachHydrographyNetworkTile(geoCell, [&](const CDBGeometryVectors &hydrographyNetwork) {
+                builder.addVectorToTilesetCollection(hydrographyNetwork,
+                                                     hydrographyNetworkDir,
+                                                     builder.hydrographyNetworkTilesets);
+            });
+            builder.flushTilesetCollection(geoCell, builder.hydrographyNetworkTilesets);
+        },
+
+        // process GTModel
+        [&](CDBTilesetBuilder &builder) {
+            cdb.forEachGTModelTile(geoCell, [&](CDBGTModels GTModel) {
+                builder.addGTModelToTilesetCollection(GTModel, GTModelDir);
+            });
+            builder.flushTilesetCollection(geoCell, builder.GTModelTilesets);
+        },
+
+        // process GSModel
+        [&](CDBTilesetBuilder &builder) {
+            cdb.forEachGSModelTile(
+                geoCell,
+                [&](CDBGSModels GSModel) { builder.addGSModelToTilesetCollection(GSModel, GSModelDir); },
+                builder.threadPool);
+            builder.flushTilesetCollection(geoCell, builder.GSModelTilesets, false);
+        }};
+
+    if (threadPool == nullptr) {
+        for (const auto &datasetPass : datasetPasses) {
+            datasetPass(*this);
+        }
+    } else {
+        // run each pass on its own builder so they don't share availability maps, then merge them back
+        // in pass order to keep the combined tilesets in the same order as the serial conversion
+        std::vector<std::unique_ptr<CDBTilesetBuilder>> passBuilders;
+        passBuilders.reserve(datasetPasses.size());
+        for (size_t i = 0; i < datasetPasses.size(); ++i) {
+            auto passBuilder = createGeoCellBuilder();
+            passBuilder->datasetDirs = datasetDirs;
+            passBuilder->GTModelsToGltf = GTModelsToGltf;
+            passBuilder->GTModelGLBs = GTModelGLBs;
+            passBuilders.emplace_back(std::move(passBuilder));
+        }
+
+        TaskGroup passTasks(threadPool);
+        for (size_t i = 0; i < datasetPasses.size(); ++i) {
+            passTasks.run([&, i]() { datasetPasses[i](*passBuilders[i]); });
+        }
+        passTasks.wait();
+
+        for (auto &passBuilder : passBuilders) {
+            mergeDatasetPass(*passBuilder);
+        }
+    }
+
+    flushAvailabilitiesAndWriteSubtrees();
+}
+
+void CDBTilesetBuilder::mergeDatasetPass(CDBTilesetBuilder &passBuilder)
+{
+    // passes produce availabilities for disjoint datasets, so nothing is overwritten here
+    for (auto &[dataset, csSubtrees] : passBuilder.datasetCSSubtrees) {
+        for (auto &[CSKey, subtrees] : csSubtrees) {
+            datasetCSSubtrees[dataset][CSKey].merge(subtrees);
+        }
+    }
+
+    for (auto &[dataset, csTileAndChildAvailabilities] : passBuilder.datasetCSTileAndChildAvailabilities) {
+        for (auto &[CSKey, tileAndChildAvailabilities] : csTileAndChildAvailabilities) {
+            datasetCSTileAndChildAvailabilities[dataset][CSKey].merge(tileAndChildAvailabilities);
+        }
+    }
+
+    defaultDatasetToCombine.insert(defaultDatasetToCombine.end(),
+                                   std::make_move_iterator(passBuilder.defaultDatasetToCombine.begin()),
+                                   std::make_move_iterator(passBuilder.defaultDatasetToCombine.end()));
+    GTModelsToGltf.merge(passBuilder.GTModelsToGltf);
+    GTModelGLBs.merge(passBuilder.GTModelGLBs);
+}
+
 void CDBTilesetBuilder::flushTilesetCollection(
     const CDBGeoCell &geoCell,
     std::unordered_map<CDBGeoCell, TilesetCollection> &tilesetCollections,
@@ -56,9 +275,16 @@ void CDBTilesetBuilder::flushTilesetCollection(
                                    / (CDBTile::retrieveGeoCellDatasetFromTileName(*root) + ".json");
 
             // write to tileset.json file
-            std::ofstream fs(tilesetJsonPath);
-
-            writeToTilesetJson(tileset, replace, fs, use3dTilesNext, subtreeLevels, maxLevel, {});
+            writeOutputFile(tilesetJsonPath, [&](std::ostream &fs) {
+                writeToTilesetJson(tileset,
+                                   replace,
+                                   fs,
+                                   use3dTilesNext,
+                                   subtreeLevels,
+                                   maxLevel,
+                                   {},
+                                   tileLayout);
+            });
 
             // add tileset json path to be combined later for multiple geocell
             // remove the output root path to become relative path
@@ -72,18 +298,23 @@ void CDBTilesetBuilder::flushTilesetCollection(
 
 void CDBTilesetBuilder::flushAvailabilitiesAndWriteSubtrees()
 {
-    std::set<std::string> subtreeRoots;
+    static const size_t SUBTREES_PER_TASK = 64;
 
     // write all of the availability buffers and subtree files for each dataset group
     for (auto &[dataset, csTileAndChildAvailabilities] : datasetCSTileAndChildAvailabilities) {
         if (datasetCSSubtrees.count(dataset) == 0) {
             continue;
         }
-        for (auto &[CSKey, subtreeMap] : datasetCSSubtrees.at(dataset)) {
+        std::filesystem::path datasetDir = datasetDirs.at(dataset);
+        for (const auto &[CSKey, subtreeMap] : datasetCSSubtrees.at(dataset)) {
             std::map<std::string, SubtreeAvailability> &tileAndChildAvailabilities
                 = csTileAndChildAvailabilities.at(CSKey);
-            for (auto &[key, subtree] : subtreeMap) {
-                subtreeRoots.insert(key);
+
+            std::vector<std::string> subtreeRoots;
+            std::set<std::string> availabilityFiles;
+            std::vector<AsyncFileWriter::File> outputFiles;
+            for (const auto &[key, subtree] : subtreeMap) {
+                subtreeRoots.emplace_back(key);
 
                 bool constantNodeAvailability = (subtree.nodeCount == 0)
                                                 || (subtree.nodeCount == subtreeNodeCount);
@@ -92,155 +323,162 @@ void CDBTilesetBuilder::flushAvailabilitiesAndWriteSubtrees()
                     continue;
                 }
 
-                std::vector<uint8_t> outputBuffer(nodeAvailabilityByteLengthWithPadding);
-                uint8_t *outBuffer = &outputBuffer[0];
-                memset(&outBuffer[0], 0, nodeAvailabilityByteLengthWithPadding);
-                memcpy(&outBuffer[0], &subtree.nodeBuffer[0], nodeAvailabilityByteLengthWithPadding);
-                std::filesystem::path path = datasetDirs.at(dataset) / CSKey / "availability"
+                std::string outputBuffer(nodeAvailabilityByteLengthWithPadding, '\0');
+                memcpy(&outputBuffer[0], &subtree.nodeBuffer[0], nodeAvailabilityByteLengthWithPadding);
+                std::filesystem::path path = datasetDir / CSKey / "availability" / getSubtreeDirectory(key)
                                              / (key + ".bin");
-                Utilities::writeBinaryFile(path,
-                                           (const char *) &outBuffer[0],
-                                           nodeAvailabilityByteLengthWithPadding);
+                outputFiles.push_back({path, std::move(outputBuffer)});
+                availabilityFiles.insert(key);
             }
 
-            // write .subtree files for every subtree
-            for (std::string subtreeRoot : subtreeRoots) {
-                json subtreeJson;
-
-                nlohmann::json buffers = nlohmann::json::array();
-                int bufferIndex = 0;
-                nlohmann::json bufferViews = nlohmann::json::array();
-                SubtreeAvailability tileAndChildAvailability = tileAndChildAvailabilities.at(subtreeRoot);
-                tileAndChildAvailability.nodeCount = countSetBitsInVectorOfInts(
-                    tileAndChildAvailability.nodeBuffer);
-                tileAndChildAvailability.childCount = countSetBitsInVectorOfInts(
-                    tileAndChildAvailability.childBuffer);
-                bool constantTileAvailability = (tileAndChildAvailability.nodeCount == 0)
-                                                || (tileAndChildAvailability.nodeCount == subtreeNodeCount);
-                bool constantChildAvailability = (tileAndChildAvailability.childCount == 0)
-                                                 || (tileAndChildAvailability.childCount == childSubtreeCount);
-
-                uint64_t nodeBufferLengthToWrite = static_cast<int>(!constantTileAvailability)
-                                                   * nodeAvailabilityByteLengthWithPadding;
-                uint64_t childBufferLengthToWrite = static_cast<int>(!constantChildAvailability)
-                                                    * childSubtreeAvailabilityByteLengthWithPadding;
-                long unsigned int bufferByteLength = nodeBufferLengthToWrite + childBufferLengthToWrite;
-                if (bufferByteLength != 0) {
-                    nlohmann::json byteLength;
-                    byteLength["byteLength"] = bufferByteLength;
-                    buffers.emplace_back(byteLength);
-                    bufferIndex += 1;
-                }
-
-                std::vector<uint8_t> internalBuffer(bufferByteLength);
-                memset(&internalBuffer[0], 0, bufferByteLength);
-                uint8_t *outInternalBuffer = &internalBuffer[0];
-                nlohmann::json tileAvailabilityJson;
-                int bufferViewIndex = 0;
-                uint64_t internalBufferOffset = 0;
-                if (constantTileAvailability)
-                    tileAvailabilityJson["constant"] = static_cast<int>(tileAndChildAvailability.nodeCount
-                                                                        == subtreeNodeCount);
-                else {
-                    memcpy(&outInternalBuffer[0],
-                           &tileAndChildAvailability.nodeBuffer[0],
-                           nodeAvailabilityByteLengthWithPadding);
-                    nlohmann::json bufferViewObj;
-                    bufferViewObj["buffer"] = 0;
-                    bufferViewObj["byteOffset"] = 0;
-                    bufferViewObj["byteLength"] = availabilityByteLength;
-                    bufferViews.emplace_back(bufferViewObj);
-                    internalBufferOffset += nodeAvailabilityByteLengthWithPadding;
-                    tileAvailabilityJson["bufferView"] = bufferViewIndex;
-                    bufferViewIndex += 1;
-                }
-                subtreeJson["tileAvailability"] = tileAvailabilityJson;
-
-                nlohmann::json childAvailabilityJson;
-                if (constantChildAvailability)
-                    childAvailabilityJson["constant"] = static_cast<int>(tileAndChildAvailability.childCount
-                                                                         == childSubtreeCount);
-                else {
-                    memcpy(&outInternalBuffer[internalBufferOffset],
-                           &tileAndChildAvailability.childBuffer[0],
-                           childSubtreeAvailabilityByteLengthWithPadding);
-                    nlohmann::json bufferViewObj;
-                    bufferViewObj["buffer"] = 0;
-                    bufferViewObj["byteOffset"] = internalBufferOffset;
-                    bufferViewObj["byteLength"] = childSubtreeAvailabilityByteLength;
-                    bufferViews.emplace_back(bufferViewObj);
-                    childAvailabilityJson["bufferView"] = bufferViewIndex;
-                    bufferViewIndex += 1;
-                }
-                subtreeJson["childSubtreeAvailability"] = childAvailabilityJson;
-
-                std::string availabilityFileName = subtreeRoot + ".bin";
-
-                std::filesystem::path datasetDir = datasetDirs.at(dataset);
-
-                std::map<std::string, SubtreeAvailability> csSubtreeRoots = datasetCSSubtrees.at(dataset).at(
-                    CSKey);
-                nlohmann::json contentObj;
-                if (std::filesystem::exists(datasetDir / CSKey / "availability" / availabilityFileName)) {
-                    nlohmann::json bufferObj;
-                    auto datasetDirIt = datasetDir.end();
-                    --datasetDirIt; // point to the dataset directory name
-                    bufferObj["uri"] = "../availability/" + availabilityFileName;
-                    bufferObj["byteLength"] = nodeAvailabilityByteLengthWithPadding;
-                    buffers.emplace_back(bufferObj);
-                    nlohmann::json bufferViewObj;
-                    bufferViewObj["buffer"] = bufferIndex;
-                    bufferViewObj["byteOffset"] = 0;
-                    bufferViewObj["byteLength"] = availabilityByteLength;
-                    bufferViews.emplace_back(bufferViewObj);
-                    contentObj["bufferView"] = bufferViewIndex;
-                    bufferViewIndex += 1;
-                    bufferIndex += 1;
-                } else if (csSubtreeRoots.count(subtreeRoot) != 0) {
-                    SubtreeAvailability subtree = datasetCSSubtrees.at(dataset).at(CSKey).at(subtreeRoot);
-                    contentObj["constant"] = static_cast<int>(subtree.nodeCount == subtreeNodeCount);
-                } else
-                    contentObj["constant"] = 0;
-                subtreeJson["contentAvailability"] = contentObj;
-                if (!buffers.empty())
-                    subtreeJson["buffers"] = buffers;
-                if (!bufferViews.empty())
-                    subtreeJson["bufferViews"] = bufferViews;
-
-                // get json length
-                const std::string jsonString = subtreeJson.dump();
-                const uint64_t jsonStringByteLength = jsonString.size();
-                const uint64_t jsonStringByteLengthWithPadding = alignTo8(jsonStringByteLength);
-
-                // Write subtree binary
-                uint64_t outputBufferLength = jsonStringByteLengthWithPadding + bufferByteLength
-                                              + headerByteLength;
-                std::vector<uint8_t> outputBuffer(outputBufferLength);
-                uint8_t *outBuffer = &outputBuffer[0];
-                *(uint32_t *) &outBuffer[0] = 0x74627573;                      // magic: "subt"
-                *(uint32_t *) &outBuffer[4] = 1;                               // version
-                *(uint64_t *) &outBuffer[8] = jsonStringByteLengthWithPadding; // JSON byte length with padding
-                *(uint64_t *) &outBuffer[16] = bufferByteLength;               // BIN byte length with padding
-
-                memcpy(&outBuffer[headerByteLength], &jsonString[0], jsonStringByteLength);
-                memset(&outBuffer[headerByteLength + jsonStringByteLength],
-                       ' ',
-                       jsonStringByteLengthWithPadding - jsonStringByteLength);
-
-                if (bufferByteLength != 0) {
-                    memcpy(&outBuffer[headerByteLength + jsonStringByteLengthWithPadding],
-                           outInternalBuffer,
-                           bufferByteLength);
-                }
-                std::filesystem::path path = datasetDir / CSKey / "subtrees" / (subtreeRoot + ".subtree");
-                Utilities::writeBinaryFile(path, (const char *) outBuffer, outputBufferLength);
+            // each subtree only reads its own availability, so the .subtree files are serialized in parallel
+            size_t availabilityFileCount = outputFiles.size();
+            outputFiles.resize(availabilityFileCount + subtreeRoots.size());
+            TaskGroup subtreeTasks(threadPool);
+            for (size_t begin = 0; begin < subtreeRoots.size(); begin += SUBTREES_PER_TASK) {
+                size_t end = std::min(begin + SUBTREES_PER_TASK, subtreeRoots.size());
+                subtreeTasks.run([&, begin, end]() {
+                    for (size_t i = begin; i < end; ++i) {
+                        const auto &subtreeRoot = subtreeRoots[i];
+                        auto &subtreeFile = outputFiles[availabilityFileCount + i];
+                        subtreeFile.path = datasetDir / CSKey / "subtrees" / getSubtreeDirectory(subtreeRoot)
+                                           / (subtreeRoot + ".subtree");
+                        subtreeFile.content = serializeSubtree(subtreeRoot,
+                                                               tileAndChildAvailabilities.at(subtreeRoot),
+                                                               subtreeMap.at(subtreeRoot),
+                                                               availabilityFiles.count(subtreeRoot) != 0);
+                    }
+                });
             }
+
+            subtreeTasks.wait();
+            writeOutputFiles(std::move(outputFiles));
             tileAndChildAvailabilities.clear();
-            subtreeRoots.clear();
         }
     }
 }
 
+std::string CDBTilesetBuilder::serializeSubtree(const std::string &subtreeRoot,
+                                                const SubtreeAvailability &tileAndChildAvailability,
+                                                const SubtreeAvailability &contentAvailability,
+                                                bool hasAvailabilityFile) const
+{
+    json subtreeJson;
+
+    nlohmann::json buffers = nlohmann::json::array();
+    int bufferIndex = 0;
+    nlohmann::json bufferViews = nlohmann::json::array();
+    uint64_t nodeCount = countSetBitsInVectorOfInts(tileAndChildAvailability.nodeBuffer);
+    uint64_t childCount = countSetBitsInVectorOfInts(tileAndChildAvailability.childBuffer);
+    bool constantTileAvailability = (nodeCount == 0) || (nodeCount == subtreeNodeCount);
+    bool constantChildAvailability = (childCount == 0) || (childCount == childSubtreeCount);
+
+    uint64_t nodeBufferLengthToWrite = static_cast<int>(!constantTileAvailability)
+                                       * nodeAvailabilityByteLengthWithPadding;
+    uint64_t childBufferLengthToWrite = static_cast<int>(!constantChildAvailability)
+                                        * childSubtreeAvailabilityByteLengthWithPadding;
+    long unsigned int bufferByteLength = nodeBufferLengthToWrite + childBufferLengthToWrite;
+    if (bufferByteLength != 0) {
+        nlohmann::json byteLength;
+        byteLength["byteLength"] = bufferByteLength;
+        buffers.emplace_back(byteLength);
+        bufferIndex += 1;
+    }
+
+    std::vector<uint8_t> internalBuffer(bufferByteLength);
+    uint8_t *outInternalBuffer = internalBuffer.data();
+    nlohmann::json tileAvailabilityJson;
+    int bufferViewIndex = 0;
+    uint64_t internalBufferOffset = 0;
+    if (constantTileAvailability)
+        tileAvailabilityJson["constant"] = static_cast<int>(nodeCount == subtreeNodeCount);
+    else {
+        memcpy(&outInternalBuffer[0],
+               &tileAndChildAvailability.nodeBuffer[0],
+               nodeAvailabilityByteLengthWithPadding);
+        nlohmann::json bufferViewObj;
+        bufferViewObj["buffer"] = 0;
+        bufferViewObj["byteOffset"] = 0;
+        bufferViewObj["byteLength"] = availabilityByteLength;
+        bufferViews.emplace_back(bufferViewObj);
+        internalBufferOffset += nodeAvailabilityByteLengthWithPadding;
+        tileAvailabilityJson["bufferView"] = bufferViewIndex;
+        bufferViewIndex += 1;
+    }
+    subtreeJson["tileAvailability"] = tileAvailabilityJson;
+
+    nlohmann::json childAvailabilityJson;
+    if (constantChildAvailability)
+        childAvailabilityJson["constant"] = static_cast<int>(childCount == childSubtreeCount);
+    else {
+        memcpy(&outInternalBuffer[internalBufferOffset],
+               &tileAndChildAvailability.childBuffer[0],
+               childSubtreeAvailabilityByteLengthWithPadding);
+        nlohmann::json bufferViewObj;
+        bufferViewObj["buffer"] = 0;
+        bufferViewObj["byteOffset"] = internalBufferOffset;
+        bufferViewObj["byteLength"] = childSubtreeAvailabilityByteLength;
+        bufferViews.emplace_back(bufferViewObj);
+        childAvailabilityJson["bufferView"] = bufferViewIndex;
+        bufferViewIndex += 1;
+    }
+    subtreeJson["childSubtreeAvailability"] = childAvailabilityJson;
+
+    nlohmann::json contentObj;
+    if (hasAvailabilityFile) {
+        nlohmann::json bufferObj;
+        // the subtree and its availability are in the same sub directories of subtrees and availability
+        auto subtreeDirectory = std::filesystem::path("subtrees") / getSubtreeDirectory(subtreeRoot);
+        auto availabilityPath = std::filesystem::path("availability") / getSubtreeDirectory(subtreeRoot)
+                                / (subtreeRoot + ".bin");
+        bufferObj["uri"] = availabilityPath.lexically_relative(subtreeDirectory).generic_string();
+        bufferObj["byteLength"] = nodeAvailabilityByteLengthWithPadding;
+        buffers.emplace_back(bufferObj);
+        nlohmann::json bufferViewObj;
+        bufferViewObj["buffer"] = bufferIndex;
+        bufferViewObj["byteOffset"] = 0;
+        bufferViewObj["byteLength"] = availabilityByteLength;
+        bufferViews.emplace_back(bufferViewObj);
+        contentObj["bufferView"] = bufferViewIndex;
+        bufferViewIndex += 1;
+        bufferIndex += 1;
+    } else {
+        contentObj["constant"] = static_cast<int>(contentAvailability.nodeCount == subtreeNodeCount);
+    }
+    subtreeJson["contentAvailability"] = contentObj;
+    if (!buffers.empty())
+        subtreeJson["buffers"] = buffers;
+    if (!bufferViews.empty())
+        subtreeJson["bufferViews"] = bufferViews;
+
+    // get json length
+    const std::string jsonString = subtreeJson.dump();
+    const uint64_t jsonStringByteLength = jsonString.size();
+    const uint64_t jsonStringByteLengthWithPadding = alignTo8(jsonStringByteLength);
+
+    // Write subtree binary
+    uint64_t outputBufferLength = jsonStringByteLengthWithPadding + bufferByteLength + headerByteLength;
+    std::string outputBuffer(outputBufferLength, '\0');
+    uint8_t *outBuffer = reinterpret_cast<uint8_t *>(&outputBuffer[0]);
+    *(uint32_t *) &outBuffer[0] = 0x74627573;                      // magic: "subt"
+    *(uint32_t *) &outBuffer[4] = 1;                               // version
+    *(uint64_t *) &outBuffer[8] = jsonStringByteLengthWithPadding; // JSON byte length with padding
+    *(uint64_t *) &outBuffer[16] = bufferByteLength;               // BIN byte length with padding
+
+    memcpy(&outBuffer[headerByteLength], &jsonString[0], jsonStringByteLength);
+    memset(&outBuffer[headerByteLength + jsonStringByteLength],
+           ' ',
+           jsonStringByteLengthWithPadding - jsonStringByteLength);
+
+    if (bufferByteLength != 0) {
+        memcpy(&outBuffer[headerByteLength + jsonStringByteLengthWithPadding],
+               outInternalBuffer,
+               bufferByteLength);
+    }
+
+    return outputBuffer;
+}
+
 void CDBTilesetBuilder::initializeImplicitTilingParameters()
 {
     subtreeNodeCount = static_cast<int>((pow(4, subtreeLevels) - 1) / 3);
@@ -263,6 +501,8 @@ std::string CDBTilesetBuilder::cs1cs2ToCSKey(int cs1, int cs2)
 
 void CDBTilesetBuilder::addAvailability(const CDBTile &cdbTile)
 {
+    std::lock_guard<std::mutex> availabilityLock(availabilityMutex);
+
     CDBDataset dataset = cdbTile.getDataset();
     if (datasetTilesetCollections.count(dataset) == 0) {
         throw std::invalid_argument(getCDBDatasetDirectoryName(dataset) + " is not currently supported.");
@@ -466,22 +706,23 @@ void CDBTilesetBuilder::addElevationToTilesetCollection(CDBElevation &elevation,
         Texture *parentTexture = nullptr;
         auto current = CDBTile::createParentTile(cdbTile);
         while (current) {
-            // if not in the cache, then write the image and save its name in the cache
-            auto it = processedParentImagery.find(*current);
-            if (it == processedParentImagery.end()) {
-                auto parentImagery = cdb.getImagery(*current);
-                if (parentImagery) {
-                    auto newTexture = createImageryTexture(*parentImagery, tilesetDirectory);
-                    auto cacheImageryTexture = processedParentImagery.insert(
-                        {*current, std::move(newTexture)});
-
-                    parentTexture = &(cacheImageryTexture.first->second);
-
-                    break;
+            ParentImagery *parentImagery;
+            {
+                std::lock_guard<std::mutex> processedParentImageryLock(processedParentImageryMutex);
+                parentImagery = &processedParentImagery[*current];
+            }
+
+            // read and write the image outside of the lock, so tiles with different parents don't wait for
+            // each other. Tiles with the same parent wait for the first one to finish writing it
+            std::call_once(parentImagery->processed, [&]() {
+                auto imagery = cdb.getImagery(*current);
+                if (imagery) {
+                    parentImagery->texture = createImageryTexture(*imagery, tilesetDirectory);
                 }
-            } else {
-                // found it, we don't need to read the image again. Just use saved name of the saved image
-                parentTexture = &it->second;
+            });
+
+            if (parentImagery->texture) {
+                parentTexture = &*parentImagery->texture;
                 break;
             }
 
@@ -510,17 +751,32 @@ void CDBTilesetBuilder::addElevationToTileset(CDBElevation &elevation,
                                               const Texture *featureIdTexture,
                                               CDBRMDescriptor *materialDescriptor)
 {
-    const auto &mesh = elevation.getUniformGridMesh();
-    if (mesh.positionRTCs.empty()) {
+    const auto &view = elevation.getView();
+    if (view.getIndexCount() == 0) {
         return;
     }
 
-    size_t targetIndexCount = static_cast<size_t>(static_cast<float>(mesh.indices.size())
+    size_t targetIndexCount = static_cast<size_t>(static_cast<float>(view.getIndexCount())
                                                   * elevationThresholdIndices);
     float targetError = elevationDecimateError;
-    Mesh simplifed = elevation.createSimplifiedMesh(targetIndexCount, targetError);
+    if (elevationSimplifier == ElevationSimplifier::RTIN && !elevation.hasRTIN()) {
+        elevation.createRTIN();
+    }
+
+    // sub regions that fill missing elevation come with the triangles of their parent clipped to them
+    Mesh simplifed;
+    if (elevationClipSubRegions) {
+        if (!elevation.hasSimplifiedTriangles()) {
+            elevation.keepSimplifiedTriangles(targetIndexCount, targetError, elevationSimplifier);
+        }
+
+        simplifed = elevation.createSimplifiedTrianglesMesh();
+    } else {
+        simplifed = elevation.createSimplifiedMesh(targetIndexCount, targetError, elevationSimplifier);
+    }
+
     if (simplifed.positionRTCs.empty()) {
-        simplifed = mesh;
+        simplifed = elevation.createUniformGridMesh();
     }
 
     if (elevationNormal) {
@@ -542,33 +798,214 @@ void CDBTilesetBuilder::addElevationToTileset(CDBElevation &elevation,
     elevation.setTile(tileWithBoundRegion);
     auto &cdbTile = elevation.getTile();
 
+    ElevationTileContent content{std::move(simplifed), cdbTile, {}, {}, {}, tilesetDirectory, &tileset};
+    if (imagery) {
+        content.imagery = *imagery;
+    }
+
+    if (featureIdTexture) {
+        content.featureIdTexture = *featureIdTexture;
+    }
+
+    if (materialDescriptor) {
+        content.materialDescriptor = *materialDescriptor;
+    }
+
+    // hand the mesh to the encoder stage when the pipeline is running, so we can start on the children
+    if (elevationPipeline) {
+        elevationPipeline->encodeQueue.push(std::move(content));
+    } else {
+        encodeElevationTile(content);
+    }
+
+    if (cdbTile.getLevel() < 0) {
+        fillMissingNegativeLODElevation(elevation, cdb, tilesetDirectory, tileset);
+    } else {
+        fillMissingPositiveLODElevation(elevation, imagery, cdb, tilesetDirectory, tileset);
+    }
+}
+
+void CDBTilesetBuilder::addElevationsWithPipeline(CDB &cdb,
+                                                  const CDBGeoCell &geoCell,
+                                                  const std::filesystem::path &elevationDirectory)
+{
+    ElevationPipeline pipeline(static_cast<size_t>(pipelineQueueDepth));
+    elevationPipeline = &pipeline;
+
+    try {
+        // stages are destroyed in reverse order, so upstream stages are always finished first
+        PipelineStage<TileFile> writerStage(pipeline.writeQueue,
+                                            static_cast<size_t>(pipelineWriterThreads),
+                                            [&](TileFile &tileFile) { writeTileFile(tileFile); });
+        PipelineStage<ElevationTileContent> encoderStage(pipeline.encodeQueue,
+                                                         static_cast<size_t>(pipelineEncoderThreads),
+                                                         [&](ElevationTileContent &content) {
+                                                             encodeElevationTile(content);
+                                                         });
+        PipelineStage<CDBElevation> builderStage(pipeline.readQueue,
+                                                 static_cast<size_t>(pipelineBuilderThreads),
+                                                 [&](CDBElevation &elevation) {
+                                                     addElevationToTilesetCollection(elevation,
+                                                                                     cdb,
+                                                                                     elevationDirectory);
+                                                 });
+
+        // read stage runs on the calling thread
+        cdb.forEachElevationTile(
+            geoCell,
+            [&](CDBElevation elevation) { pipeline.readQueue.push(std::move(elevation)); },
+            prefetcher);
+
+        builderStage.finish();
+        encoderStage.finish();
+        writerStage.finish();
+    } catch (...) {
+        elevationPipeline = nullptr;
+        throw;
+    }
+
+    elevationPipeline = nullptr;
+}
+
+void CDBTilesetBuilder::encodeElevationTile(ElevationTileContent &content)
+{
     tinygltf::Model gltf;
     // create material for mesh if there are imagery
-    if (imagery) {
+    if (content.imagery) {
         Material material;
         material.doubleSided = true;
         material.unlit = !elevationNormal;
         material.texture = 0;
-        simplifed.material = 0;
+        content.mesh.material = 0;
 
-        gltf = createGltf(simplifed, &material, imagery, use3dTilesNext, featureIdTexture);
-        if (featureIdTexture && materialDescriptor) {
-            materialDescriptor->addFeatureTableToGltf(&materials, &gltf, externalSchema);
+        const Texture *featureIdTexture = content.featureIdTexture ? &*content.featureIdTexture : nullptr;
+        gltf = createGltf(content.mesh, &material, &*content.imagery, use3dTilesNext, featureIdTexture);
+        if (content.featureIdTexture && content.materialDescriptor) {
+            content.materialDescriptor->addFeatureTableToGltf(&materials, &gltf, externalSchema);
         }
     } else {
-        gltf = createGltf(simplifed, nullptr, nullptr, use3dTilesNext);
+        gltf = createGltf(content.mesh, nullptr, nullptr, use3dTilesNext);
     }
 
     if (use3dTilesNext) {
-        createGLTFForTileset(gltf, cdbTile, nullptr, tilesetDirectory, tileset);
+        createGLTFForTileset(gltf, content.tile, nullptr, content.tilesetDirectory, *content.tileset);
     } else {
-        createB3DMForTileset(gltf, cdbTile, nullptr, tilesetDirectory, tileset);
+        createB3DMForTileset(gltf, content.tile, nullptr, content.tilesetDirectory, *content.tileset);
     }
+}
 
-    if (cdbTile.getLevel() < 0) {
-        fillMissingNegativeLODElevation(elevation, cdb, tilesetDirectory, tileset);
+void CDBTilesetBuilder::writeTileFile(TileFile &tileFile) const
+{
+    if (fileWriter) {
+        fileWriter->write(tileFile.path, std::move(tileFile.content));
+        return;
+    }
+
+    outputSink->write(tileFile.path, tileFile.content.data(), tileFile.content.size());
+}
+
+void CDBTilesetBuilder::writeTileContent(const std::filesystem::path &path,
+                                         const std::function<void(std::ostream &)> &write)
+{
+    if (elevationPipeline == nullptr && fileWriter == nullptr && outputSink->isFileSystem()) {
+        std::ofstream fs(path, std::ios::binary);
+        write(fs);
+        return;
+    }
+
+    std::ostringstream ss;
+    write(ss);
+    if (elevationPipeline) {
+        elevationPipeline->writeQueue.push({path, ss.str()});
+    } else if (fileWriter) {
+        fileWriter->write(path, ss.str());
     } else {
-        fillMissingPositiveLODElevation(elevation, imagery, cdb, tilesetDirectory, tileset);
+        std::string content = ss.str();
+        outputSink->write(path, content.data(), content.size());
+    }
+}
+
+void CDBTilesetBuilder::writeOutputFiles(std::vector<AsyncFileWriter::File> files) const
+{
+    if (fileWriter) {
+        fileWriter->write(std::move(files));
+    } else {
+        for (const auto &file : files) {
+            outputSink->write(file.path, file.content.data(), file.content.size());
+        }
+    }
+}
+
+void CDBTilesetBuilder::writeOutputFile(const std::filesystem::path &path,
+                                        const char *data,
+                                        uint64_t byteLength) const
+{
+    if (fileWriter) {
+        fileWriter->write(path, std::string(data, byteLength));
+    } else {
+        outputSink->write(path, data, byteLength);
+    }
+}
+
+void CDBTilesetBuilder::writeOutputFile(const std::filesystem::path &path,
+                                        const std::function<void(std::ostream &)> &write) const
+{
+    if (fileWriter == nullptr && outputSink->isFileSystem()) {
+        std::ofstream fs(path, std::ios::binary);
+        write(fs);
+        return;
+    }
+
+    std::ostringstream ss;
+    write(ss);
+    std::string content = ss.str();
+    writeOutputFile(path, content.data(), content.size());
+}
+
+void CDBTilesetBuilder::writeTexture(GDALDriver *driver,
+                                     GDALDataset *dataset,
+                                     const std::filesystem::path &path) const
+{
+    if (fileWriter == nullptr && outputSink->isFileSystem()) {
+        GDALDatasetUniquePtr textureDataset = GDALDatasetUniquePtr(
+            driver->CreateCopy(path.string().c_str(), dataset, false, nullptr, nullptr, nullptr));
+        return;
+    }
+
+    // encode to GDAL's in-memory file system and leave the file I/O to the writer threads or the output sink
+    static std::atomic<uint64_t> memoryTextureCount{0};
+    std::string memoryPath = "/vsimem/texture_" + std::to_string(memoryTextureCount++)
+                             + path.extension().string();
+    GDALDatasetUniquePtr textureDataset = GDALDatasetUniquePtr(
+        driver->CreateCopy(memoryPath.c_str(), dataset, false, nullptr, nullptr, nullptr));
+    textureDataset.reset();
+
+    vsi_l_offset byteLength = 0;
+    GByte *data = VSIGetMemFileBuffer(memoryPath.c_str(), &byteLength, TRUE);
+    if (data) {
+        writeOutputFile(path, reinterpret_cast<const char *>(data), static_cast<uint64_t>(byteLength));
+        CPLFree(data);
+    }
+}
+
+void CDBTilesetBuilder::writeImage(const osg::Image &image, const std::filesystem::path &path) const
+{
+    if (fileWriter == nullptr && outputSink->isFileSystem()) {
+        osgDB::writeImageFile(image, path.string(), nullptr);
+        return;
+    }
+
+    std::string extension = path.extension().string();
+    auto readerWriter = osgDB::Registry::instance()->getReaderWriterForExtension(
+        extension.empty() ? extension : extension.substr(1));
+    if (readerWriter == nullptr) {
+        return;
+    }
+
+    std::ostringstream ss;
+    if (readerWriter->writeImage(image, ss).success()) {
+        std::string content = ss.str();
+        writeOutputFile(path, content.data(), content.size());
     }
 }
 
@@ -606,61 +1043,73 @@ void CDBTilesetBuilder::fillMissingPositiveLODElevation(const CDBElevation &elev
     }
 
     if (shouldFillHole || hasMoreImagery) {
+        // sub regions only depend on this tile's mesh and imagery, which outlive the tasks below
+        TaskGroup subRegionTasks(threadPool);
         if (!isNorthWestExist) {
-            auto subRegionImagery = cdb.getImagery(nw);
-            bool reindexUV = subRegionImagery != std::nullopt;
-            auto subRegion = elevation.createNorthWestSubRegion(reindexUV);
-            if (subRegion) {
-                addSubRegionElevationToTileset(*subRegion,
-                                               cdb,
-                                               subRegionImagery,
-                                               currentImagery,
-                                               tilesetDirectory,
-                                               tileset);
-            }
+            subRegionTasks.run([&]() {
+                auto subRegionImagery = cdb.getImagery(nw);
+                bool reindexUV = subRegionImagery != std::nullopt;
+                auto subRegion = elevation.createNorthWestSubRegion(reindexUV);
+                if (subRegion) {
+                    addSubRegionElevationToTileset(*subRegion,
+                                                   cdb,
+                                                   subRegionImagery,
+                                                   currentImagery,
+                                                   tilesetDirectory,
+                                                   tileset);
+                }
+            });
         }
 
         if (!isNorthEastExist) {
-            auto subRegionImagery = cdb.getImagery(ne);
-            bool reindexUV = subRegionImagery != std::nullopt;
-            auto subRegion = elevation.createNorthEastSubRegion(reindexUV);
-            if (subRegion) {
-                addSubRegionElevationToTileset(*subRegion,
-                                               cdb,
-                                               subRegionImagery,
-                                               currentImagery,
-                                               tilesetDirectory,
-                                               tileset);
-            }
+            subRegionTasks.run([&]() {
+                auto subRegionImagery = cdb.getImagery(ne);
+                bool reindexUV = subRegionImagery != std::nullopt;
+                auto subRegion = elevation.createNorthEastSubRegion(reindexUV);
+                if (subRegion) {
+                    addSubRegionElevationToTileset(*subRegion,
+                                                   cdb,
+                                                   subRegionImagery,
+                                                   currentImagery,
+                                                   tilesetDirectory,
+                                                   tileset);
+                }
+            });
         }
 
         if (!isSouthEastExist) {
-            auto subRegionImagery = cdb.getImagery(se);
-            bool reindexUV = subRegionImagery != std::nullopt;
-            auto subRegion = elevation.createSouthEastSubRegion(reindexUV);
-            if (subRegion) {
-                addSubRegionElevationToTileset(*subRegion,
-                                               cdb,
-                                               subRegionImagery,
-                                               currentImagery,
-                                               tilesetDirectory,
-                                               tileset);
-            }
+            subRegionTasks.run([&]() {
+                auto subRegionImagery = cdb.getImagery(se);
+                bool reindexUV = subRegionImagery != std::nullopt;
+                auto subRegion = elevation.createSouthEastSubRegion(reindexUV);
+                if (subRegion) {
+                    addSubRegionElevationToTileset(*subRegion,
+                                                   cdb,
+                                                   subRegionImagery,
+                                                   currentImagery,
+                                                   tilesetDirectory,
+                                                   tileset);
+                }
+            });
         }
 
         if (!isSouthWestExist) {
-            auto subRegionImagery = cdb.getImagery(sw);
-            bool reindexUV = subRegionImagery != std::nullopt;
-            auto subRegion = elevation.createSouthWestSubRegion(reindexUV);
-            if (subRegion) {
-                addSubRegionElevationToTileset(*subRegion,
-                                               cdb,
-                                               subRegionImagery,
-                                               currentImagery,
-                                               tilesetDirectory,
-                                               tileset);
-            }
+            subRegionTasks.run([&]() {
+                auto subRegionImagery = cdb.getImagery(sw);
+                bool reindexUV = subRegionImagery != std::nullopt;
+                auto subRegion = elevation.createSouthWestSubRegion(reindexUV);
+                if (subRegion) {
+                    addSubRegionElevationToTileset(*subRegion,
+                                                   cdb,
+                                                   subRegionImagery,
+                                                   currentImagery,
+                                                   tilesetDirectory,
+                                                   tileset);
+                }
+            });
         }
+
+        subRegionTasks.wait();
     }
 }
 
@@ -748,18 +1197,11 @@ Texture CDBTilesetBuilder::createFeatureIDTexture(CDBRMTexture &rmTexture,
     auto textureRelativePath = MODEL_TEXTURE_SUB_DIR / (tile.getRelativePath().filename().string() + ".png");
     auto textureAbsolutePath = tilesetOutputDirectory / textureRelativePath;
     auto textureDirectory = tilesetOutputDirectory / MODEL_TEXTURE_SUB_DIR;
-    if (!std::filesystem::exists(textureDirectory)) {
-        std::filesystem::create_directories(textureDirectory);
-    }
+    outputSink->createDirectories(textureDirectory);
 
     auto driver = (GDALDriver *) GDALGetDriverByName("png");
     if (driver) {
-        GDALDatasetUniquePtr pngDataset = GDALDatasetUniquePtr(driver->CreateCopy(textureAbsolutePath.c_str(),
-                                                                                  &rmTexture.getData(),
-                                                                                  false,
-                                                                                  nullptr,
-                                                                                  nullptr,
-                                                                                  nullptr));
+        writeTexture(driver, &rmTexture.getData(), textureAbsolutePath);
     }
 
     Texture texture;
@@ -779,14 +1221,11 @@ Texture CDBTilesetBuilder::createImageryTexture(CDBImagery &imagery,
     auto textureRelativePath = MODEL_TEXTURE_SUB_DIR / (tile.getRelativePath().filename().string() + ".jpeg");
     auto textureAbsolutePath = tilesetOutputDirectory / textureRelativePath;
     auto textureDirectory = tilesetOutputDirectory / MODEL_TEXTURE_SUB_DIR;
-    if (!std::filesystem::exists(textureDirectory)) {
-        std::filesystem::create_directories(textureDirectory);
-    }
+    outputSink->createDirectories(textureDirectory);
 
     auto driver = (GDALDriver *) GDALGetDriverByName("jpeg");
     if (driver) {
-        GDALDatasetUniquePtr jpegDataset = GDALDatasetUniquePtr(driver->CreateCopy(
-            textureAbsolutePath.string().c_str(), &imagery.getData(), false, nullptr, nullptr, nullptr));
+        writeTexture(driver, &imagery.getData(), textureAbsolutePath);
     }
 
     Texture texture;
@@ -837,7 +1276,10 @@ void CDBTilesetBuilder::addGTModelToTilesetCollection(const CDBGTModels &model,
 
     // create gltf file
     auto gltfOutputDIr = tilesetDirectory / MODEL_GLTF_SUB_DIR;
-    std::filesystem::create_directories(gltfOutputDIr);
+    outputSink->createDirectories(gltfOutputDIr);
+
+    // parse the models of the tile in parallel first, so the loop below only hits the cache
+    model.loadModels3D(threadPool);
 
     std::map<std::string, std::vector<int>> instances;
     const auto &modelsAttribs = model.getModelsAttributes();
@@ -859,10 +1301,17 @@ void CDBTilesetBuilder::addGTModelToTilesetCollection(const CDBGTModels &model,
                                                   textures,
                                                   use3dTilesNext);
 
-                // write to glb
-                tinygltf::TinyGLTF loader;
+                // write to glb. It is written synchronously, because the 3D Tiles Next content below
+                // reads it back
+                std::ostringstream glb;
+                GLBWriter(&gltf, 4).write(glb);
+                std::string glbContent = glb.str();
                 std::filesystem::path modelGltfURI = MODEL_GLTF_SUB_DIR / (modelKey + ".glb");
-                loader.WriteGltfSceneToFile(&gltf, tilesetDirectory / modelGltfURI, false, false, false, true);
+                outputSink->write(tilesetDirectory / modelGltfURI, glbContent.data(), glbContent.size());
+                if (use3dTilesNext && !outputSink->isFileSystem()) {
+                    GTModelGLBs.insert({modelKey, std::move(glbContent)});
+                }
+
                 GTModelsToGltf.insert({modelKey, modelGltfURI});
             }
 
@@ -872,8 +1321,9 @@ void CDBTilesetBuilder::addGTModelToTilesetCollection(const CDBGTModels &model,
     }
 
     std::string cdbTileFilename = cdbTile.getRelativePathWithNonZeroPaddedLevel().filename().string();
+    auto contentDirectory = createTileContentDirectory(cdbTile, tilesetDirectory);
     if (use3dTilesNext) {
-        std::filesystem::path gltfPath = cdbTileFilename + std::string(".glb");
+        std::filesystem::path gltfPath = contentDirectory / (cdbTileFilename + std::string(".glb"));
         std::filesystem::path gltfFullPath = tilesetDirectory / gltfPath;
 
         // Create glTF.
@@ -898,49 +1348,68 @@ void CDBTilesetBuilder::addGTModelToTilesetCollection(const CDBGTModels &model,
         sampler.wrapT = TINYGLTF_TEXTURE_WRAP_REPEAT;
         gltf.samplers.emplace_back(sampler);
 
+        // the textures of the models are already written next to their GLBs, so the images are not decoded
+        // and keep their URIs
         std::string error, warning;
         tinygltf::TinyGLTF io;
+        io.SetImageLoader([](tinygltf::Image *,
+                             const int,
+                             std::string *,
+                             std::string *,
+                             int,
+                             int,
+                             const unsigned char *,
+                             int,
+                             void *) { return true; },
+                          nullptr);
         std::vector<tinygltf::Model> glbs;
 
         for (const auto &instance : instances) {
             const auto &instanceIndices = instance.second;
             tinygltf::Model loadedModel;
-            io.LoadBinaryFromFile(&loadedModel,
-                                  &error,
-                                  &warning,
-                                  tilesetDirectory / GTModelsToGltf[instance.first]);
+            auto GLB = GTModelGLBs.find(instance.first);
+            if (GLB == GTModelGLBs.end()) {
+                io.LoadBinaryFromFile(&loadedModel,
+                                      &error,
+                                      &warning,
+                                      tilesetDirectory / GTModelsToGltf[instance.first]);
+            } else {
+                io.LoadBinaryFromMemory(&loadedModel,
+                                        &error,
+                                        &warning,
+                                        reinterpret_cast<const unsigned char *>(GLB->second.data()),
+                                        static_cast<unsigned int>(GLB->second.size()));
+            }
+
+            // texture URIs of the model are relative to its GLB, make them relative to the tileset directory
+            for (auto &image : loadedModel.images) {
+                if (!image.uri.empty() && image.uri.rfind("data:", 0) != 0) {
+                    image.uri = (MODEL_GLTF_SUB_DIR / image.uri).generic_string();
+                }
+            }
 
             createInstancingExtension(&loadedModel, modelsAttribs, instanceIndices);
             glbs.emplace_back(loadedModel);
         }
 
         combineGltfs(&gltf, glbs);
+        relocateGltfURIs(gltf, contentDirectory);
 
         cdbTile.setCustomContentURI(gltfPath);
-
-        // Enable writing textures to output folder.
-        auto originalPath = std::filesystem::current_path();
-        std::filesystem::current_path(tilesetDirectory);
-
-        // Create glTF stringstream
-        std::stringstream ss;
-        tinygltf::TinyGLTF gltfIO;
-        std::ofstream fs(gltfFullPath, std::ios::binary);
-        writePaddedGLB(&gltf, fs);
-
-        std::filesystem::current_path(originalPath);
+        writeOutputFile(gltfFullPath, [&](std::ostream &fs) { writePaddedGLB(&gltf, fs); });
     } else {
         // write i3dm to cmpt
-        std::filesystem::path cmpt = cdbTileFilename + std::string(".cmpt");
+        std::filesystem::path cmpt = contentDirectory / (cdbTileFilename + std::string(".cmpt"));
         std::filesystem::path cmptFullPath = tilesetDirectory / cmpt;
-        std::ofstream fs(cmptFullPath, std::ios::binary);
         auto instance = instances.begin();
-        writeToCMPT(static_cast<uint32_t>(instances.size()), fs, [&](std::ofstream &os, size_t) {
-            const auto &GltfURI = GTModelsToGltf[instance->first];
-            const auto &instanceIndices = instance->second;
-            size_t totalWrite = writeToI3DM(GltfURI, modelsAttribs, instanceIndices, os);
-            instance = std::next(instance);
-            return totalWrite;
+        writeOutputFile(cmptFullPath, [&](std::ostream &fs) {
+            writeToCMPT(static_cast<uint32_t>(instances.size()), fs, [&](std::ostream &os, size_t) {
+                auto GltfURI = GTModelsToGltf[instance->first].lexically_relative(contentDirectory);
+                const auto &instanceIndices = instance->second;
+                size_t totalWrite = writeToI3DM(GltfURI.generic_string(), modelsAttribs, instanceIndices, os);
+                instance = std::next(instance);
+                return totalWrite;
+            });
         });
 
         // add it to tileset
@@ -982,9 +1451,7 @@ std::vector<Texture> CDBTilesetBuilder::writeModeTextures(const std::vector<Text
                                                           const std::filesystem::path &gltfPath)
 {
     auto textureDirectory = gltfPath / textureSubDir;
-    if (!std::filesystem::exists(textureDirectory)) {
-        std::filesystem::create_directories(textureDirectory);
-    }
+    outputSink->createDirectories(textureDirectory);
 
     auto textures = modelTextures;
     for (size_t i = 0; i < modelTextures.size(); ++i) {
@@ -992,7 +1459,8 @@ std::vector<Texture> CDBTilesetBuilder::writeModeTextures(const std::vector<Text
         auto textureAbsolutePath = gltfPath / textureSubDir / modelTextures[i].uri;
 
         if (processedModelTextures.find(textureAbsolutePath) == processedModelTextures.end()) {
-            osgDB::writeImageFile(*images[i], textureAbsolutePath.string(), nullptr);
+            writeImage(*images[i], textureAbsolutePath);
+            processedModelTextures.insert(textureAbsolutePath);
         }
 
         textures[i].uri = textureRelativePath.string();
@@ -1009,12 +1477,13 @@ void CDBTilesetBuilder::createB3DMForTileset(tinygltf::Model &gltf,
 {
     // create b3dm file
     std::string cdbTileFilename = cdbTile.getRelativePathWithNonZeroPaddedLevel().filename().string();
-    std::filesystem::path b3dm = cdbTileFilename + std::string(".b3dm");
+    auto contentDirectory = createTileContentDirectory(cdbTile, outputDirectory);
+    std::filesystem::path b3dm = contentDirectory / (cdbTileFilename + std::string(".b3dm"));
     std::filesystem::path b3dmFullPath = outputDirectory / b3dm;
+    relocateGltfURIs(gltf, contentDirectory);
 
     // write to b3dm
-    std::ofstream fs(b3dmFullPath, std::ios::binary);
-    writeToB3DM(&gltf, instancesAttribs, fs);
+    writeTileContent(b3dmFullPath, [&](std::ostream &os) { writeToB3DM(&gltf, instancesAttribs, os); });
     cdbTile.setCustomContentURI(b3dm);
 
     if (use3dTilesNext) {
@@ -1032,12 +1501,13 @@ void CDBTilesetBuilder::createGLTFForTileset(tinygltf::Model &gltf,
 {
     // Create glTF file
     std::string cdbTileFilename = cdbTile.getRelativePathWithNonZeroPaddedLevel().filename().string();
-    std::filesystem::path gltfFile = cdbTileFilename + std::string(".glb");
+    auto contentDirectory = createTileContentDirectory(cdbTile, outputDirectory);
+    std::filesystem::path gltfFile = contentDirectory / (cdbTileFilename + std::string(".glb"));
     std::filesystem::path gltfFullPath = outputDirectory / gltfFile;
+    relocateGltfURIs(gltf, contentDirectory);
 
     // Write to glTF
-    std::ofstream fs(gltfFullPath, std::ios::binary);
-    writeToGLTF(&gltf, instancesAttribs, fs);
+    writeTileContent(gltfFullPath, [&](std::ostream &os) { writeToGLTF(&gltf, instancesAttribs, os); });
     cdbTile.setCustomContentURI(gltfFile);
 
     if (use3dTilesNext) {
@@ -1047,6 +1517,53 @@ void CDBTilesetBuilder::createGLTFForTileset(tinygltf::Model &gltf,
     tileset.insertTile(cdbTile);
 }
 
+std::filesystem::path CDBTilesetBuilder::createTileContentDirectory(
+    const CDBTile &cdbTile, const std::filesystem::path &outputDirectory) const
+{
+    auto contentDirectory = getTileContentDirectory(tileLayout, cdbTile.getLevel(), cdbTile.getUREF());
+    if (!contentDirectory.empty()) {
+        outputSink->createDirectories(outputDirectory / contentDirectory);
+    }
+
+    return contentDirectory;
+}
+
+void CDBTilesetBuilder::relocateGltfURIs(tinygltf::Model &gltf,
+                                         const std::filesystem::path &contentDirectory) const
+{
+    if (contentDirectory.empty()) {
+        return;
+    }
+
+    // textures and the external schema are relative to the tileset directory, but glTF resolves them from
+    // the tile content
+    for (auto &image : gltf.images) {
+        if (!image.uri.empty() && image.uri.rfind("data:", 0) != 0) {
+            auto imagePath = std::filesystem::path(image.uri);
+            image.uri = imagePath.lexically_relative(contentDirectory).generic_string();
+        }
+    }
+
+    auto metadata = gltf.extensions.find("EXT_feature_metadata");
+    if (metadata != gltf.extensions.end() && metadata->second.Has("schemaUri")) {
+        auto metadataObject = metadata->second.Get<tinygltf::Value::Object>();
+        auto schemaPath = std::filesystem::path(metadataObject["schemaUri"].Get<std::string>());
+        metadataObject["schemaUri"] = tinygltf::Value(
+            schemaPath.lexically_relative(contentDirectory).generic_string());
+        metadata->second = tinygltf::Value(std::move(metadataObject));
+    }
+}
+
+std::filesystem::path CDBTilesetBuilder::getSubtreeDirectory(const std::string &subtreeRoot) const
+{
+    // subtree roots are keyed by level_x_y
+    auto levelEnd = subtreeRoot.find('_');
+    auto xEnd = subtreeRoot.find('_', levelEnd + 1);
+    int level = std::stoi(subtreeRoot.substr(0, levelEnd));
+    int y = std::stoi(subtreeRoot.substr(xEnd + 1));
+    return getTileContentDirectory(tileLayout, level, y);
+}
+
 size_t CDBTilesetBuilder::hashComponentSelectors(int CS_1, int CS_2)
 {
     size_t CSHash = 0;
@@ -1067,6 +1584,7 @@ void CDBTilesetBuilder::getTileset(const CDBTile &cdbTile,
                                    CDBTileset *&tileset,
                                    std::filesystem::path &path)
 {
+    std::lock_guard<std::mutex> tilesetCollectionsLock(tilesetCollectionsMutex);
     const auto &geoCell = cdbTile.getGeoCell();
     auto &tilesetCollection = tilesetCollections[geoCell];
 
@@ -1077,7 +1595,7 @@ void CDBTilesetBuilder::getTileset(const CDBTile &cdbTile,
     auto CSPathIt = CSToPaths.find(CSHash);
     if (CSPathIt == CSToPaths.end()) {
         path = getTilesetDirectory(cdbTile.getCS_1(), cdbTile.getCS_2(), collectionOutputDirectory);
-        std::filesystem::create_directories(path);
+        outputSink->createDirectories(path);
         CSToPaths.insert({CSHash, path});
     } else {
         path = CSPathIt->second;
@@ -1,10 +1,18 @@
 #pragma once
 
+#include "AsyncFileWriter.h"
 #include "CDB.h"
 #include "CDBMaterials.h"
 #include "CDBRMDescriptor.h"
 #include "Gltf.h"
+#include "OutputSink.h"
+#include "Pipeline.h"
+#include "ThreadPool.h"
+#include "TileFormatIO.h"
+#include "TilePrefetcher.h"
 #include <filesystem>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 using namespace CDBTo3DTiles;
@@ -25,6 +33,46 @@ public:
         std::unordered_map<size_t, std::filesystem::path> CSToPaths;
         std::unordered_map<size_t, CDBTileset> CSToTilesets;
     };
+
+    // simplified elevation mesh waiting to be encoded to tile content
+    struct ElevationTileContent
+    {
+        Mesh mesh;
+        CDBTile tile;
+        std::optional<Texture> imagery;
+        std::optional<Texture> featureIdTexture;
+        std::optional<CDBRMDescriptor> materialDescriptor;
+        std::filesystem::path tilesetDirectory;
+        CDBTileset *tileset;
+    };
+
+    // imagery of a parent tile, read and written once by the first tile that needs it
+    struct ParentImagery
+    {
+        std::once_flag processed;
+        std::optional<Texture> texture;
+    };
+
+    // encoded tile content waiting to be written to disk
+    struct TileFile
+    {
+        std::filesystem::path path;
+        std::string content;
+    };
+
+    struct ElevationPipeline
+    {
+        explicit ElevationPipeline(size_t queueDepth)
+            : readQueue{queueDepth}
+            , encodeQueue{queueDepth}
+            , writeQueue{queueDepth}
+        {}
+
+        BoundedQueue<CDBElevation> readQueue;
+        BoundedQueue<ElevationTileContent> encodeQueue;
+        BoundedQueue<TileFile> writeQueue;
+    };
+
     CDBTilesetBuilder(const std::filesystem::path &cdbInputPath, const std::filesystem::path &output)
         : elevationNormal{false}
         , elevationLOD{false}
@@ -33,6 +81,28 @@ public:
         , subtreeLevels{7}
         , elevationDecimateError{0.01f}
         , elevationThresholdIndices{0.3f}
+        , elevationSimplifier{ElevationSimplifier::MeshOptimizer}
+        , elevationClipSubRegions{false}
+        , threadCount{1}
+        , threadPool{nullptr}
+        , pipelineQueueDepth{0}
+        , pipelineBuilderThreads{1}
+        , pipelineEncoderThreads{1}
+        , pipelineWriterThreads{1}
+        , elevationPipeline{nullptr}
+        , writerThreads{0}
+        , writerMemoryBudget{256}
+        , fileWriter{nullptr}
+        , outputSink{&FileSystemOutputSink::getInstance()}
+        , deduplicateOutput{false}
+        , tileLayout{TileLayout::Flat}
+        , prefetchTiles{0}
+        , prefetchThreads{2}
+        , prefetchMemoryBudget{256}
+        , prefetcher{nullptr}
+        , shardIndex{0}
+        , shardCount{1}
+        , useIndexCache{false}
         , cdbPath{cdbInputPath}
         , outputPath{output}
     {
@@ -60,12 +130,23 @@ public:
         }
     }
 
+    std::unique_ptr<CDBTilesetBuilder> createGeoCellBuilder() const;
+
+    void convertGeoCell(CDB &cdb, const CDBGeoCell &geoCell);
+
+    void mergeDatasetPass(CDBTilesetBuilder &passBuilder);
+
     void flushTilesetCollection(const CDBGeoCell &geoCell,
                                 std::unordered_map<CDBGeoCell, TilesetCollection> &tilesetCollections,
                                 bool replace = true);
 
     void flushAvailabilitiesAndWriteSubtrees();
 
+    std::string serializeSubtree(const std::string &subtreeRoot,
+                                 const SubtreeAvailability &tileAndChildAvailability,
+                                 const SubtreeAvailability &contentAvailability,
+                                 bool hasAvailabilityFile) const;
+
     void initializeImplicitTilingParameters();
 
     std::string levelXYtoSubtreeKey(int level, int x, int y);
@@ -94,6 +175,28 @@ public:
                                          const CDB &cdb,
                                          const std::filesystem::path &outputDirectory);
 
+    void addElevationsWithPipeline(CDB &cdb,
+                                   const CDBGeoCell &geoCell,
+                                   const std::filesystem::path &elevationDirectory);
+
+    void encodeElevationTile(ElevationTileContent &content);
+
+    void writeTileFile(TileFile &tileFile) const;
+
+    void writeTileContent(const std::filesystem::path &path,
+                          const std::function<void(std::ostream &)> &write);
+
+    void writeOutputFile(const std::filesystem::path &path, const char *data, uint64_t byteLength) const;
+
+    void writeOutputFile(const std::filesystem::path &path,
+                         const std::function<void(std::ostream &)> &write) const;
+
+    void writeOutputFiles(std::vector<AsyncFileWriter::File> files) const;
+
+    void writeTexture(GDALDriver *driver, GDALDataset *dataset, const std::filesystem::path &path) const;
+
+    void writeImage(const osg::Image &image, const std::filesystem::path &path) const;
+
     void addElevationToTileset(CDBElevation &elevation,
                                const Texture *imagery,
                                const CDB &cdb,
@@ -139,6 +242,13 @@ public:
 
     void addGSModelToTilesetCollection(const CDBGSModels &model, const std::filesystem::path &outputDirectory);
 
+    std::filesystem::path createTileContentDirectory(const CDBTile &cdbTile,
+                                                     const std::filesystem::path &outputDirectory) const;
+
+    void relocateGltfURIs(tinygltf::Model &gltf, const std::filesystem::path &contentDirectory) const;
+
+    std::filesystem::path getSubtreeDirectory(const std::string &subtreeRoot) const;
+
     void createB3DMForTileset(tinygltf::Model &model,
                               CDBTile cdbTile,
                               const CDBInstancesAttributes *instancesAttribs,
@@ -197,13 +307,39 @@ public:
 
     float elevationDecimateError;
     float elevationThresholdIndices;
+    ElevationSimplifier elevationSimplifier;
+    bool elevationClipSubRegions;
+    int threadCount;
+    ThreadPool *threadPool;
+    int pipelineQueueDepth;
+    int pipelineBuilderThreads;
+    int pipelineEncoderThreads;
+    int pipelineWriterThreads;
+    ElevationPipeline *elevationPipeline;
+    int writerThreads;
+    int writerMemoryBudget;
+    AsyncFileWriter *fileWriter;
+    OutputSink *outputSink;
+    bool deduplicateOutput;
+    TileLayout tileLayout;
+    int prefetchTiles;
+    int prefetchThreads;
+    int prefetchMemoryBudget;
+    TilePrefetcher *prefetcher;
+    int shardIndex;
+    int shardCount;
+    bool useIndexCache;
     std::filesystem::path cdbPath;
     std::filesystem::path outputPath;
     std::vector<std::filesystem::path> defaultDatasetToCombine;
     std::vector<std::vector<std::string>> requestedDatasetToCombine;
     std::unordered_set<std::string> processedModelTextures;
-    std::unordered_map<CDBTile, Texture> processedParentImagery;
+    std::unordered_map<CDBTile, ParentImagery> processedParentImagery;
+    std::mutex processedParentImageryMutex;
+    std::mutex availabilityMutex;
+    std::mutex tilesetCollectionsMutex;
     std::unordered_map<std::string, std::filesystem::path> GTModelsToGltf;
+    std::unordered_map<std::string, std::string> GTModelGLBs;
     std::unordered_map<CDBGeoCell, TilesetCollection> elevationTilesets;
     std::unordered_map<CDBGeoCell, TilesetCollection> roadNetworkTilesets;
     std::unordered_map<CDBGeoCell, TilesetCollection> railRoadNetworkTilesets;
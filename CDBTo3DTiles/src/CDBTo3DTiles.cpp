@@ -1,15 +1,22 @@
 #include "CDBTo3DTiles.h"
+#include "AsyncFileWriter.h"
 #include "CDB.h"
 #include "Gltf.h"
 #include "MathHelpers.h"
 #include "TileFormatIO.h"
+#include "VirtualFileSystem.h"
 #include "cpl_conv.h"
 #include "gdal.h"
 #include "osgDB/WriteFile"
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <limits>
 #include <morton.h>
 #include <nlohmann/json.hpp>
+#include <numeric>
+#include <set>
+#include <sstream>
 #include <unordered_map>
 #include <unordered_set>
 using json = nlohmann::json;
@@ -17,24 +24,20 @@ using json = nlohmann::json;
 namespace CDBTo3DTiles {
 
 const std::string MATERIALS_SCHEMA_NAME = "materials.json";
+const std::string SHARD_MANIFEST_PREFIX = "shard_";
 
-Converter::Converter(const std::filesystem::path &CDBPath, const std::filesystem::path &outputPath)
+static void writeOutputFile(OutputSink &outputSink,
+                            const std::filesystem::path &path,
+                            const std::function<void(std::ostream &)> &write)
 {
-    m_impl = std::make_unique<CDBTilesetBuilder>(CDBPath, outputPath);
+    std::ostringstream ss;
+    write(ss);
+    std::string content = ss.str();
+    outputSink.write(path, content.data(), content.size());
 }
 
-Converter::~Converter() noexcept {}
-
-void Converter::combineDataset(const std::vector<std::string> &datasets)
+static void checkCombinedDataset(const std::vector<std::string> &datasets)
 {
-    // Only combine when we have more than 1 tileset. Less than that, it means
-    // the tileset doesn't exist (no action needed here) or
-    // it is already combined from different geocell by default
-    if (datasets.size() == 1) {
-        return;
-    }
-
-    m_impl->requestedDatasetToCombine.emplace_back(datasets);
     for (const auto &dataset : datasets) {
         auto datasetNamePos = dataset.find("_");
         if (datasetNamePos == std::string::npos) {
@@ -43,10 +46,10 @@ void Converter::combineDataset(const std::vector<std::string> &datasets)
         }
 
         auto datasetName = dataset.substr(0, datasetNamePos);
-        if (m_impl->DATASET_PATHS.find(datasetName) == m_impl->DATASET_PATHS.end()) {
+        if (CDBTilesetBuilder::DATASET_PATHS.find(datasetName) == CDBTilesetBuilder::DATASET_PATHS.end()) {
             std::string errorMessage = "Unrecognize dataset: " + datasetName + "\n";
             errorMessage += "Correct dataset names are: \n";
-            for (const auto &requiredDataset : m_impl->DATASET_PATHS) {
+            for (const auto &requiredDataset : CDBTilesetBuilder::DATASET_PATHS) {
                 errorMessage += requiredDataset + "\n";
             }
 
@@ -71,6 +74,206 @@ void Converter::combineDataset(const std::vector<std::string> &datasets)
     }
 }
 
+static std::string getShardManifestName(int shardIndex, int shardCount)
+{
+    return SHARD_MANIFEST_PREFIX + std::to_string(shardIndex) + "_of_" + std::to_string(shardCount) + ".json";
+}
+
+static size_t estimateGeoCellTileCount(const std::filesystem::path &cdbPath, const CDBGeoCell &geoCell)
+{
+    // a UREF directory of level L holds up to 2^L tiles. Only the dataset, LOD and UREF directories are
+    // listed, never the tile files, so the estimate stays cheap for large geocells
+    size_t tileCount = 0;
+    for (const auto &dataset : VirtualFileSystem::listDirectory(cdbPath / geoCell.getRelativePath())) {
+        if (!dataset.isDirectory) {
+            continue;
+        }
+
+        for (const auto &LOD : VirtualFileSystem::listDirectory(dataset.path)) {
+            auto LODName = LOD.path.filename().string();
+            if (!LOD.isDirectory || LODName.size() < 2 || LODName.front() != 'L') {
+                continue;
+            }
+
+            // every negative level of a dataset is in the LC directory, one tile each
+            size_t UREFTileCount = 1;
+            if (LODName[1] != 'C') {
+                if (!std::all_of(LODName.begin() + 1, LODName.end(), ::isdigit)) {
+                    continue;
+                }
+
+                UREFTileCount = size_t(1) << std::min(std::stoi(LODName.substr(1)), 23);
+            }
+
+            for (const auto &UREF : VirtualFileSystem::listDirectory(LOD.path)) {
+                if (UREF.isDirectory) {
+                    tileCount += UREFTileCount;
+                }
+            }
+        }
+    }
+
+    return tileCount;
+}
+
+static std::vector<size_t> assignGeoCellsToShards(const std::filesystem::path &cdbPath,
+                                                  const std::vector<CDBGeoCell> &geoCells,
+                                                  size_t shardCount)
+{
+    std::vector<size_t> tileCounts;
+    tileCounts.reserve(geoCells.size());
+    for (const auto &geoCell : geoCells) {
+        tileCounts.emplace_back(estimateGeoCellTileCount(cdbPath, geoCell));
+    }
+
+    // give the largest geocells out first, each one to the least loaded shard. Ties are broken by
+    // the geocell and shard order, so every node computes the same assignment
+    std::vector<size_t> largestFirst(geoCells.size());
+    std::iota(largestFirst.begin(), largestFirst.end(), 0);
+    std::stable_sort(largestFirst.begin(), largestFirst.end(), [&](size_t lhs, size_t rhs) {
+        return tileCounts[lhs] > tileCounts[rhs];
+    });
+
+    std::vector<size_t> shardTileCounts(shardCount, 0);
+    std::vector<size_t> geoCellShards(geoCells.size());
+    for (auto geoCellIndex : largestFirst) {
+        auto leastLoaded = std::min_element(shardTileCounts.begin(), shardTileCounts.end());
+        geoCellShards[geoCellIndex] = static_cast<size_t>(leastLoaded - shardTileCounts.begin());
+        *leastLoaded += tileCounts[geoCellIndex] + 1;
+    }
+
+    return geoCellShards;
+}
+
+static void checkShardOutputSink(int shardCount, const OutputSink &outputSink)
+{
+    // the merge step reads the manifests and tilesets of the shards from their output directories
+    if (shardCount > 1 && !outputSink.isFileSystem()) {
+        throw std::runtime_error("Sharded conversion can only write to the file system output sink");
+    }
+}
+
+static void writeShardManifest(OutputSink &outputSink,
+                               const std::filesystem::path &outputPath,
+                               int shardIndex,
+                               int shardCount,
+                               const std::vector<CDBGeoCell> &geoCells,
+                               const std::vector<size_t> &geoCellIndices,
+                               const std::vector<std::vector<std::filesystem::path>> &geoCellTilesets)
+{
+    json manifest;
+    manifest["shardIndex"] = shardIndex;
+    manifest["shardCount"] = shardCount;
+    manifest["geoCells"] = json::array();
+    for (auto i : geoCellIndices) {
+        json tilesets = json::array();
+        for (const auto &tilesetJsonPath : geoCellTilesets[i]) {
+            tilesets.emplace_back(tilesetJsonPath.generic_string());
+        }
+
+        manifest["geoCells"].emplace_back(json{{"index", i},
+                                               {"latitude", geoCells[i].getLatitude()},
+                                               {"longitude", geoCells[i].getLongitude()},
+                                               {"tilesets", tilesets}});
+    }
+
+    auto manifestPath = outputPath / getShardManifestName(shardIndex, shardCount);
+    writeOutputFile(outputSink, manifestPath, [&](std::ostream &fs) { fs << manifest; });
+}
+
+static void writeCombinedTilesets(OutputSink &outputSink,
+                                  const std::filesystem::path &outputPath,
+                                  const std::vector<CDBGeoCell> &geoCells,
+                                  const std::vector<std::vector<std::filesystem::path>> &geoCellTilesets,
+                                  const std::vector<std::vector<std::string>> &requestedDatasetToCombine)
+{
+    std::map<std::string, std::vector<std::filesystem::path>> combinedTilesets;
+    std::map<std::string, std::vector<Core::BoundingRegion>> combinedTilesetsRegions;
+    std::map<std::string, Core::BoundingRegion> aggregateTilesetsRegion;
+
+    // get the converted dataset in each geocell to be combine at the end
+    for (size_t i = 0; i < geoCells.size(); ++i) {
+        Core::BoundingRegion geoCellRegion = CDBTile::calcBoundRegion(geoCells[i], -10, 0, 0);
+        for (const auto &tilesetJsonPath : geoCellTilesets[i]) {
+            auto componentSelectors = tilesetJsonPath.parent_path().filename().string();
+            auto dataset = tilesetJsonPath.parent_path().parent_path().filename().string();
+            auto combinedTilesetName = dataset + "_" + componentSelectors;
+
+            combinedTilesets[combinedTilesetName].emplace_back(tilesetJsonPath);
+            combinedTilesetsRegions[combinedTilesetName].emplace_back(geoCellRegion);
+            auto tilesetAggregateRegion = aggregateTilesetsRegion.find(combinedTilesetName);
+            if (tilesetAggregateRegion == aggregateTilesetsRegion.end()) {
+                aggregateTilesetsRegion.insert({combinedTilesetName, geoCellRegion});
+            } else {
+                tilesetAggregateRegion->second = tilesetAggregateRegion->second.computeUnion(geoCellRegion);
+            }
+        }
+    }
+
+    // combine all the default tileset in each geocell into a global one
+    for (auto tileset : combinedTilesets) {
+        writeOutputFile(outputSink, outputPath / (tileset.first + ".json"), [&](std::ostream &fs) {
+            combineTilesetJson(tileset.second, combinedTilesetsRegions[tileset.first], fs);
+        });
+    }
+
+    // combine the requested tilesets
+    for (const auto &tilesets : requestedDatasetToCombine) {
+        std::string combinedTilesetName;
+        if (requestedDatasetToCombine.size() > 1) {
+            for (const auto &tileset : tilesets) {
+                combinedTilesetName += tileset;
+            }
+            combinedTilesetName += ".json";
+        } else {
+            combinedTilesetName = "tileset.json";
+        }
+
+        std::vector<std::filesystem::path> existTilesets;
+        std::vector<Core::BoundingRegion> regions;
+        regions.reserve(tilesets.size());
+        for (const auto &tileset : tilesets) {
+            auto tilesetRegion = aggregateTilesetsRegion.find(tileset);
+            if (tilesetRegion != aggregateTilesetsRegion.end()) {
+                existTilesets.emplace_back(tilesetRegion->first + ".json");
+                regions.emplace_back(tilesetRegion->second);
+            }
+        }
+
+        // a shard may not have any of the requested tilesets
+        if (existTilesets.empty()) {
+            continue;
+        }
+
+        writeOutputFile(outputSink, outputPath / combinedTilesetName, [&](std::ostream &fs) {
+            combineTilesetJson(existTilesets, regions, fs);
+        });
+    }
+}
+
+Converter::Converter(const std::filesystem::path &CDBPath, const std::filesystem::path &outputPath)
+    : m_duplicateFileCount{0}
+    , m_duplicateByteLength{0}
+{
+    // a CDB bundled in an archive is read in place through GDAL
+    m_impl = std::make_unique<CDBTilesetBuilder>(VirtualFileSystem::resolveArchivePath(CDBPath), outputPath);
+}
+
+Converter::~Converter() noexcept {}
+
+void Converter::combineDataset(const std::vector<std::string> &datasets)
+{
+    // Only combine when we have more than 1 tileset. Less than that, it means
+    // the tileset doesn't exist (no action needed here) or
+    // it is already combined from different geocell by default
+    if (datasets.size() == 1) {
+        return;
+    }
+
+    m_impl->requestedDatasetToCombine.emplace_back(datasets);
+    checkCombinedDataset(datasets);
+}
+
 void Converter::setUse3dTilesNext(bool use3dTilesNext)
 {
     m_impl->use3dTilesNext = use3dTilesNext;
@@ -106,167 +309,344 @@ void Converter::setElevationDecimateError(float elevationDecimateError)
     m_impl->elevationDecimateError = elevationDecimateError;
 }
 
+void Converter::setElevationSimplifier(ElevationSimplifier elevationSimplifier)
+{
+    m_impl->elevationSimplifier = elevationSimplifier;
+}
+
+void Converter::setElevationClipSubRegions(bool elevationClipSubRegions)
+{
+    m_impl->elevationClipSubRegions = elevationClipSubRegions;
+}
+
+void Converter::setThreadCount(int threadCount)
+{
+    m_impl->threadCount = threadCount;
+}
+
+void Converter::setPipelineQueueDepth(int pipelineQueueDepth)
+{
+    m_impl->pipelineQueueDepth = pipelineQueueDepth;
+}
+
+void Converter::setPipelineBuilderThreads(int pipelineBuilderThreads)
+{
+    m_impl->pipelineBuilderThreads = pipelineBuilderThreads;
+}
+
+void Converter::setPipelineEncoderThreads(int pipelineEncoderThreads)
+{
+    m_impl->pipelineEncoderThreads = pipelineEncoderThreads;
+}
+
+void Converter::setPipelineWriterThreads(int pipelineWriterThreads)
+{
+    m_impl->pipelineWriterThreads = pipelineWriterThreads;
+}
+
+void Converter::setWriterThreads(int writerThreads)
+{
+    m_impl->writerThreads = writerThreads;
+}
+
+void Converter::setWriterMemoryBudget(int writerMemoryBudget)
+{
+    m_impl->writerMemoryBudget = writerMemoryBudget;
+}
+
+void Converter::setPrefetchTiles(int prefetchTiles)
+{
+    m_impl->prefetchTiles = prefetchTiles;
+}
+
+void Converter::setPrefetchThreads(int prefetchThreads)
+{
+    m_impl->prefetchThreads = prefetchThreads;
+}
+
+void Converter::setPrefetchMemoryBudget(int prefetchMemoryBudget)
+{
+    m_impl->prefetchMemoryBudget = prefetchMemoryBudget;
+}
+
+void Converter::setShard(int shardIndex, int shardCount)
+{
+    if (shardCount < 1 || shardIndex < 0 || shardIndex >= shardCount) {
+        throw std::runtime_error("Shard index has to be between 0 and the shard count - 1");
+    }
+
+    checkShardOutputSink(shardCount, *m_impl->outputSink);
+
+    m_impl->shardIndex = shardIndex;
+    m_impl->shardCount = shardCount;
+}
+
+void Converter::setUseIndexCache(bool useIndexCache)
+{
+    m_impl->useIndexCache = useIndexCache;
+}
+
+void Converter::setOutputSink(std::shared_ptr<OutputSink> outputSink)
+{
+    auto configuredOutputSink = outputSink ? outputSink.get() : &FileSystemOutputSink::getInstance();
+    checkShardOutputSink(m_impl->shardCount, *configuredOutputSink);
+    m_outputSink = std::move(outputSink);
+    m_impl->outputSink = configuredOutputSink;
+}
+
+void Converter::setDeduplicateOutput(bool deduplicateOutput)
+{
+    m_impl->deduplicateOutput = deduplicateOutput;
+}
+
+void Converter::setTileLayout(TileLayout tileLayout)
+{
+    m_impl->tileLayout = tileLayout;
+}
+
 void Converter::convert()
 {
-    CDB cdb(m_impl->cdbPath);
-    std::map<std::string, std::vector<std::filesystem::path>> combinedTilesets;
-    std::map<std::string, std::vector<Core::BoundingRegion>> combinedTilesetsRegions;
-    std::map<std::string, Core::BoundingRegion> aggregateTilesetsRegion;
-    std::map<CDBDataset, std::filesystem::path> &datasetDirs = m_impl->datasetDirs;
+    // an archive can't hold the index cache, and its listing is read at once from its central directory
+    std::filesystem::path indexCachePath;
+    if (m_impl->useIndexCache && !VirtualFileSystem::isVirtualPath(m_impl->cdbPath)) {
+        indexCachePath = m_impl->cdbPath / CDBIndex::CACHE_FILE;
+    }
+
+    CDB cdb(m_impl->cdbPath, indexCachePath);
     m_impl->initializeImplicitTilingParameters();
 
     std::filesystem::path materialsXMLPath = m_impl->cdbPath / "Metadata" / "Materials.xml";
     if (m_impl->use3dTilesNext) {
         // Parse Materials XML to build CDBBaseMaterials index.
-        if (std::filesystem::exists(materialsXMLPath)) {
+        if (VirtualFileSystem::exists(materialsXMLPath)) {
             m_impl->materials.readBaseMaterialsFile(materialsXMLPath);
         }
     }
 
-    cdb.forEachGeoCell([&](CDBGeoCell geoCell) {
-        m_impl->datasetCSSubtrees.clear();
-        datasetDirs.clear();
-
-        // create directories for converted GeoCell
-        std::filesystem::path geoCellRelativePath = geoCell.getRelativePath();
-        std::filesystem::path geoCellAbsolutePath = m_impl->outputPath / geoCellRelativePath;
-        std::filesystem::path elevationDir = geoCellAbsolutePath / CDBTilesetBuilder::ELEVATIONS_PATH;
-        std::filesystem::path GTModelDir = geoCellAbsolutePath / CDBTilesetBuilder::GTMODEL_PATH;
-        std::filesystem::path GSModelDir = geoCellAbsolutePath / CDBTilesetBuilder::GSMODEL_PATH;
-        std::filesystem::path roadNetworkDir = geoCellAbsolutePath / CDBTilesetBuilder::ROAD_NETWORK_PATH;
-        std::filesystem::path railRoadNetworkDir = geoCellAbsolutePath
-                                                   / CDBTilesetBuilder::RAILROAD_NETWORK_PATH;
-        std::filesystem::path powerlineNetworkDir = geoCellAbsolutePath
-                                                    / CDBTilesetBuilder::POWERLINE_NETWORK_PATH;
-        std::filesystem::path hydrographyNetworkDir = geoCellAbsolutePath
-                                                      / CDBTilesetBuilder::HYDROGRAPHY_NETWORK_PATH;
-        datasetDirs.insert(std::pair<CDBDataset, std::filesystem::path>(CDBDataset::Elevation, elevationDir));
-        datasetDirs.insert(std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GSFeature, GSModelDir));
-        datasetDirs.insert(
-            std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GSModelGeometry, GSModelDir));
-        datasetDirs.insert(
-            std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GSModelTexture, GSModelDir));
-        datasetDirs.insert(std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GTFeature, GTModelDir));
-        datasetDirs.insert(
-            std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GTModelGeometry_500, GTModelDir));
-        datasetDirs.insert(
-            std::pair<CDBDataset, std::filesystem::path>(CDBDataset::GTModelTexture, GTModelDir));
-        datasetDirs.insert(
-            std::pair<CDBDataset, std::filesystem::path>(CDBDataset::RoadNetwork, roadNetworkDir));
-        datasetDirs.insert(
-            std::pair<CDBDataset, std::filesystem::path>(CDBDataset::RailRoadNetwork, railRoadNetworkDir));
-        datasetDirs.insert(
-            std::pair<CDBDataset, std::filesystem::path>(CDBDataset::PowerlineNetwork, powerlineNetworkDir));
-        datasetDirs.insert(std::pair<CDBDataset, std::filesystem::path>(CDBDataset::HydrographyNetwork,
-                                                                        hydrographyNetworkDir));
-
-        // process elevation
-        cdb.forEachElevationTile(geoCell, [&](CDBElevation elevation) {
-            m_impl->addElevationToTilesetCollection(elevation, cdb, elevationDir);
-        });
-        m_impl->flushTilesetCollection(geoCell, m_impl->elevationTilesets);
-        std::unordered_map<CDBTile, Texture>().swap(m_impl->processedParentImagery);
+    std::vector<CDBGeoCell> geoCells;
+    cdb.forEachGeoCell([&](CDBGeoCell geoCell) { geoCells.emplace_back(geoCell); });
 
-        // process road network
-        cdb.forEachRoadNetworkTile(geoCell, [&](const CDBGeometryVectors &roadNetwork) {
-            m_impl->addVectorToTilesetCollection(roadNetwork, roadNetworkDir, m_impl->roadNetworkTilesets);
+    // a shard only converts its own geocells. They are sorted first since the directory order can differ
+    // between the nodes, and the index in the sorted order lets the merge step restore the global order
+    std::vector<size_t> geoCellIndices;
+    if (m_impl->shardCount > 1) {
+        std::sort(geoCells.begin(), geoCells.end(), [](const CDBGeoCell &lhs, const CDBGeoCell &rhs) {
+            return std::make_pair(lhs.getLatitude(), lhs.getLongitude())
+                   < std::make_pair(rhs.getLatitude(), rhs.getLongitude());
         });
-        m_impl->flushTilesetCollection(geoCell, m_impl->roadNetworkTilesets);
 
-        // process railroad network
-        cdb.forEachRailRoadNetworkTile(geoCell, [&](const CDBGeometryVectors &railRoadNetwork) {
-            m_impl->addVectorToTilesetCollection(railRoadNetwork,
-                                                 railRoadNetworkDir,
-                                                 m_impl->railRoadNetworkTilesets);
-        });
-        m_impl->flushTilesetCollection(geoCell, m_impl->railRoadNetworkTilesets);
-
-        // process powerline network
-        cdb.forEachPowerlineNetworkTile(geoCell, [&](const CDBGeometryVectors &powerlineNetwork) {
-            m_impl->addVectorToTilesetCollection(powerlineNetwork,
-                                                 powerlineNetworkDir,
-                                                 m_impl->powerlineNetworkTilesets);
-        });
-        m_impl->flushTilesetCollection(geoCell, m_impl->powerlineNetworkTilesets);
+        auto geoCellShards = assignGeoCellsToShards(m_impl->cdbPath,
+                                                    geoCells,
+                                                    static_cast<size_t>(m_impl->shardCount));
+        for (size_t i = 0; i < geoCells.size(); ++i) {
+            if (geoCellShards[i] == static_cast<size_t>(m_impl->shardIndex)) {
+                geoCellIndices.emplace_back(i);
+            }
+        }
+    } else {
+        geoCellIndices.resize(geoCells.size());
+        std::iota(geoCellIndices.begin(), geoCellIndices.end(), 0);
+    }
 
-        // process hydrography network
-        cdb.forEachHydrographyNetworkTile(geoCell, [&](const CDBGeometryVectors &hydrographyNetwork) {
-            m_impl->addVectorToTilesetCollection(hydrographyNetwork,
-                                                 hydrographyNetworkDir,
-                                                 m_impl->hydrographyNetworkTilesets);
-        });
-        m_impl->flushTilesetCollection(geoCell, m_impl->hydrographyNetworkTilesets);
+    // each geocell is written to its own directory, so they can be converted independently. The converted
+    // tilesets are collected per geocell and combined in the original order to keep the output deterministic
+    std::vector<std::vector<std::filesystem::path>> geoCellTilesets(geoCells.size());
+
+    // identical files are only written once when requested. Every write of the conversion goes through it, so
+    // it is restored to the configured sink when the conversion is done
+    OutputSink *configuredOutputSink = m_impl->outputSink;
+    std::unique_ptr<DeduplicatingOutputSink> deduplicatingOutputSink;
+    if (m_impl->deduplicateOutput) {
+        deduplicatingOutputSink = std::make_unique<DeduplicatingOutputSink>(*configuredOutputSink);
+        m_impl->outputSink = deduplicatingOutputSink.get();
+    }
 
-        // process GTModel
-        cdb.forEachGTModelTile(geoCell, [&](CDBGTModels GTModel) {
-            m_impl->addGTModelToTilesetCollection(GTModel, GTModelDir);
-        });
-        m_impl->flushTilesetCollection(geoCell, m_impl->GTModelTilesets);
-      
-        // process GSModel
-        cdb.forEachGSModelTile(geoCell, [&](CDBGSModels GSModel) {
-            m_impl->addGSModelToTilesetCollection(GSModel, GSModelDir);
-        });
-        m_impl->flushTilesetCollection(geoCell, m_impl->GSModelTilesets, false);
+    // tile content, textures and subtrees are written in the background when requested
+    std::unique_ptr<AsyncFileWriter> fileWriter;
+    if (m_impl->writerThreads > 0) {
+        size_t writerMemoryBudget = static_cast<size_t>(m_impl->writerMemoryBudget) * 1024 * 1024;
+        fileWriter = std::make_unique<AsyncFileWriter>(static_cast<size_t>(m_impl->writerThreads),
+                                                       writerMemoryBudget,
+                                                       *m_impl->outputSink);
+        m_impl->fileWriter = fileWriter.get();
+    }
 
-        m_impl->flushAvailabilitiesAndWriteSubtrees();
+    // the inputs of the next elevation tiles are read into the page cache in the background when requested
+    std::unique_ptr<TilePrefetcher> prefetcher;
+    if (m_impl->prefetchTiles > 0) {
+        uintmax_t prefetchMemoryBudget = static_cast<uintmax_t>(m_impl->prefetchMemoryBudget) * 1024 * 1024;
+        prefetcher = std::make_unique<TilePrefetcher>(static_cast<size_t>(m_impl->prefetchThreads),
+                                                      static_cast<size_t>(m_impl->prefetchTiles),
+                                                      prefetchMemoryBudget);
+        m_impl->prefetcher = prefetcher.get();
+    }
 
-        // get the converted dataset in each geocell to be combine at the end
-        Core::BoundingRegion geoCellRegion = CDBTile::calcBoundRegion(geoCell, -10, 0, 0);
-        for (auto tilesetJsonPath : m_impl->defaultDatasetToCombine) {
-            auto componentSelectors = tilesetJsonPath.parent_path().filename().string();
-            auto dataset = tilesetJsonPath.parent_path().parent_path().filename().string();
-            auto combinedTilesetName = dataset + "_" + componentSelectors;
+    try {
+        if (m_impl->threadCount > 1) {
+            ThreadPool threadPool(static_cast<size_t>(m_impl->threadCount - 1));
+            m_impl->threadPool = &threadPool;
+
+            TaskGroup geoCellTasks(&threadPool);
+            for (auto i : geoCellIndices) {
+                geoCellTasks.run([&, i]() {
+                    // the CDB is shared, so a GTModel used by several geocells is only parsed once
+                    auto geoCellBuilder = m_impl->createGeoCellBuilder();
+                    geoCellBuilder->convertGeoCell(cdb, geoCells[i]);
+                    geoCellTilesets[i] = std::move(geoCellBuilder->defaultDatasetToCombine);
+                });
+            }
 
-            combinedTilesets[combinedTilesetName].emplace_back(tilesetJsonPath);
-            combinedTilesetsRegions[combinedTilesetName].emplace_back(geoCellRegion);
-            auto tilesetAggregateRegion = aggregateTilesetsRegion.find(combinedTilesetName);
-            if (tilesetAggregateRegion == aggregateTilesetsRegion.end()) {
-                aggregateTilesetsRegion.insert({combinedTilesetName, geoCellRegion});
-            } else {
-                tilesetAggregateRegion->second = tilesetAggregateRegion->second.computeUnion(geoCellRegion);
+            geoCellTasks.wait();
+            m_impl->threadPool = nullptr;
+        } else {
+            for (auto i : geoCellIndices) {
+                m_impl->convertGeoCell(cdb, geoCells[i]);
+                std::swap(geoCellTilesets[i], m_impl->defaultDatasetToCombine);
             }
         }
-        std::vector<std::filesystem::path>().swap(m_impl->defaultDatasetToCombine);
-    });
 
-    // combine all the default tileset in each geocell into a global one
-    for (auto tileset : combinedTilesets) {
-        std::ofstream fs(m_impl->outputPath / (tileset.first + ".json"));
-        combineTilesetJson(tileset.second, combinedTilesetsRegions[tileset.first], fs);
+        if (fileWriter) {
+            fileWriter->flush();
+        }
+    } catch (...) {
+        m_impl->threadPool = nullptr;
+        m_impl->fileWriter = nullptr;
+        m_impl->prefetcher = nullptr;
+        m_impl->outputSink = configuredOutputSink;
+        throw;
     }
 
-    // combine the requested tilesets
-    for (const auto &tilesets : m_impl->requestedDatasetToCombine) {
-        std::string combinedTilesetName;
-        if (m_impl->requestedDatasetToCombine.size() > 1) {
-            for (const auto &tileset : tilesets) {
-                combinedTilesetName += tileset;
+    m_impl->fileWriter = nullptr;
+    m_impl->prefetcher = nullptr;
+    m_prefetchStatistics = prefetcher ? prefetcher->getStatistics() : TilePrefetcher::Statistics();
+
+    // only save the index after the conversion succeeds, so the geocells it swept are all complete
+    cdb.saveIndexCache();
+
+    auto &outputSink = *m_impl->outputSink;
+    writeCombinedTilesets(outputSink,
+                          m_impl->outputPath,
+                          geoCells,
+                          geoCellTilesets,
+                          m_impl->requestedDatasetToCombine);
+    if (m_impl->shardCount > 1) {
+        writeShardManifest(outputSink,
+                           m_impl->outputPath,
+                           m_impl->shardIndex,
+                           m_impl->shardCount,
+                           geoCells,
+                           geoCellIndices,
+                           geoCellTilesets);
+    }
+
+    if (VirtualFileSystem::exists(materialsXMLPath) && m_impl->externalSchema) {
+        std::string schema = m_impl->materials.generateSchema().dump();
+        outputSink.write(m_impl->outputPath / MATERIALS_SCHEMA_NAME, schema.data(), schema.size());
+    }
+
+    outputSink.finish();
+
+    m_impl->outputSink = configuredOutputSink;
+    m_duplicateFileCount = deduplicatingOutputSink ? deduplicatingOutputSink->getDuplicateFileCount() : 0;
+    m_duplicateByteLength = deduplicatingOutputSink ? deduplicatingOutputSink->getDuplicateByteLength() : 0;
+}
+
+ShardMerger::ShardMerger(const std::vector<std::filesystem::path> &shardPaths,
+                         const std::filesystem::path &outputPath)
+    : m_shardPaths{shardPaths}
+    , m_outputPath{outputPath}
+{}
+
+void ShardMerger::combineDataset(const std::vector<std::string> &datasets)
+{
+    if (datasets.size() == 1) {
+        return;
+    }
+
+    m_requestedDatasetToCombine.emplace_back(datasets);
+    checkCombinedDataset(datasets);
+}
+
+void ShardMerger::merge()
+{
+    struct ShardGeoCell
+    {
+        size_t index;
+        CDBGeoCell geoCell;
+        std::vector<std::filesystem::path> tilesets;
+    };
+
+    int shardCount = 0;
+    std::set<int> mergedShards;
+    std::vector<ShardGeoCell> shardGeoCells;
+    for (const auto &shardPath : m_shardPaths) {
+        for (const auto &entry : std::filesystem::directory_iterator(shardPath)) {
+            auto filename = entry.path().filename().string();
+            if (filename.rfind(SHARD_MANIFEST_PREFIX, 0) != 0 || entry.path().extension() != ".json") {
+                continue;
             }
-            combinedTilesetName += ".json";
-        } else {
-            combinedTilesetName = "tileset.json";
-        }
 
-        std::vector<std::filesystem::path> existTilesets;
-        std::vector<Core::BoundingRegion> regions;
-        regions.reserve(tilesets.size());
-        for (const auto &tileset : tilesets) {
-            auto tilesetRegion = aggregateTilesetsRegion.find(tileset);
-            if (tilesetRegion != aggregateTilesetsRegion.end()) {
-                existTilesets.emplace_back(tilesetRegion->first + ".json");
-                regions.emplace_back(tilesetRegion->second);
+            std::ifstream fs(entry.path());
+            json manifest = json::parse(fs);
+            auto shardIndex = manifest["shardIndex"].get<int>();
+            if (shardCount == 0) {
+                shardCount = manifest["shardCount"].get<int>();
+            } else if (shardCount != manifest["shardCount"].get<int>()) {
+                throw std::runtime_error("Shards are converted with different shard counts");
+            }
+
+            if (!mergedShards.insert(shardIndex).second) {
+                throw std::runtime_error("Shard " + std::to_string(shardIndex) + "/"
+                                         + std::to_string(shardCount) + " is found more than once");
+            }
+
+            // tilesets are referenced relative to the merged output, which may not be the shard directory
+            for (const auto &geoCellJson : manifest["geoCells"]) {
+                ShardGeoCell shardGeoCell{geoCellJson["index"].get<size_t>(),
+                                          CDBGeoCell(geoCellJson["latitude"].get<int>(),
+                                                     geoCellJson["longitude"].get<int>()),
+                                          {}};
+                for (const auto &tileset : geoCellJson["tilesets"]) {
+                    shardGeoCell.tilesets.emplace_back(
+                        std::filesystem::relative(shardPath / tileset.get<std::string>(), m_outputPath));
+                }
+
+                shardGeoCells.emplace_back(std::move(shardGeoCell));
             }
         }
+    }
 
-        std::ofstream fs(m_impl->outputPath / combinedTilesetName);
-        combineTilesetJson(existTilesets, regions, fs);
+    if (shardCount == 0) {
+        throw std::runtime_error("No shard output is found");
     }
 
-    if (std::filesystem::exists(materialsXMLPath) && m_impl->externalSchema) {
-        std::ofstream schemaFile(m_impl->outputPath / MATERIALS_SCHEMA_NAME);
-        schemaFile << m_impl->materials.generateSchema();
+    for (int i = 0; i < shardCount; ++i) {
+        if (mergedShards.find(i) == mergedShards.end()) {
+            throw std::runtime_error("Output of shard " + std::to_string(i) + "/" + std::to_string(shardCount)
+                                     + " is missing");
+        }
     }
+
+    // restore the geocell order of the whole CDB, so the merged tilesets don't depend on the shard count
+    std::sort(shardGeoCells.begin(),
+              shardGeoCells.end(),
+              [](const ShardGeoCell &lhs, const ShardGeoCell &rhs) { return lhs.index < rhs.index; });
+
+    std::vector<CDBGeoCell> geoCells;
+    std::vector<std::vector<std::filesystem::path>> geoCellTilesets;
+    geoCells.reserve(shardGeoCells.size());
+    geoCellTilesets.reserve(shardGeoCells.size());
+    for (auto &shardGeoCell : shardGeoCells) {
+        geoCells.emplace_back(shardGeoCell.geoCell);
+        geoCellTilesets.emplace_back(std::move(shardGeoCell.tilesets));
+    }
+
+    std::filesystem::create_directories(m_outputPath);
+    writeCombinedTilesets(FileSystemOutputSink::getInstance(),
+                          m_outputPath,
+                          geoCells,
+                          geoCellTilesets,
+                          m_requestedDatasetToCombine);
 }
 
 USE_OSGPLUGIN(png)
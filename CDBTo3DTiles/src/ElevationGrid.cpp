@@ -0,0 +1,27 @@
+#include "ElevationGrid.h"
+
+namespace CDBTo3DTiles {
+
+ElevationGrid::ElevationGrid(std::vector<float> heights,
+                             size_t gridWidth,
+                             size_t gridHeight,
+                             Core::Cartographic topLeft,
+                             glm::dvec2 pixelSize)
+    : m_heights{std::move(heights)}
+    , m_gridWidth{gridWidth}
+    , m_gridHeight{gridHeight}
+    , m_topLeft{topLeft}
+    , m_pixelSize{pixelSize}
+{}
+
+ElevationView ElevationGrid::getView() const
+{
+    return ElevationView(m_heights.data(),
+                         m_gridWidth + 1,
+                         glm::uvec2(0),
+                         glm::uvec2(m_gridWidth, m_gridHeight),
+                         m_topLeft,
+                         m_pixelSize);
+}
+
+} // namespace CDBTo3DTiles
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Cartographic.h"
+#include "ElevationView.h"
+#include "glm/glm.hpp"
+#include <vector>
+
+namespace CDBTo3DTiles {
+// The heights of an elevation tile, one float per vertex, and the georeferencing of its north west vertex.
+// A grid costs 4 bytes per vertex instead of the ~60 bytes of the same grid as a Mesh. Everything else is
+// derived through views of the heights
+class ElevationGrid
+{
+public:
+    // heights holds (gridWidth + 1) x (gridHeight + 1) vertices in row major order from the north west
+    // corner. pixelSize is the step between vertices in degrees, negative in y going south
+    ElevationGrid(std::vector<float> heights,
+                  size_t gridWidth,
+                  size_t gridHeight,
+                  Core::Cartographic topLeft,
+                  glm::dvec2 pixelSize);
+
+    inline size_t getGridWidth() const noexcept { return m_gridWidth; }
+
+    inline size_t getGridHeight() const noexcept { return m_gridHeight; }
+
+    inline const std::vector<float> &getHeights() const noexcept { return m_heights; }
+
+    // the view of the whole grid. It points into the heights, so it's valid as long as the grid is
+    ElevationView getView() const;
+
+private:
+    std::vector<float> m_heights;
+    size_t m_gridWidth;
+    size_t m_gridHeight;
+    Core::Cartographic m_topLeft;
+    glm::dvec2 m_pixelSize;
+};
+} // namespace CDBTo3DTiles
@@ -0,0 +1,218 @@
+#include "ElevationTriangles.h"
+#include "Ellipsoid.h"
+#include <limits>
+#include <map>
+#include <tuple>
+
+namespace CDBTo3DTiles {
+
+ElevationTriangles::ElevationTriangles(const ElevationView &view, const std::vector<uint32_t> &indices)
+{
+    size_t verticesWidth = view.getVerticesWidth();
+    std::vector<uint32_t> remap(view.getVertexCount(), std::numeric_limits<uint32_t>::max());
+    m_indices.reserve(indices.size());
+    for (auto index : indices) {
+        if (remap[index] == std::numeric_limits<uint32_t>::max()) {
+            size_t x = index % verticesWidth;
+            size_t y = index / verticesWidth;
+            remap[index] = static_cast<uint32_t>(m_vertices.size());
+            m_vertices.emplace_back(static_cast<double>(x), static_cast<double>(y));
+            m_heights.emplace_back(static_cast<double>(view.getHeight(x, y)));
+        }
+
+        m_indices.emplace_back(remap[index]);
+    }
+}
+
+ElevationTriangles ElevationTriangles::clip(glm::dvec2 min, glm::dvec2 max) const
+{
+    // distance of a vertex inside each side of the rectangle: west, east, north and south
+    auto getDistance = [&](const glm::dvec2 &vertex, int side) {
+        switch (side) {
+        case 0:
+            return vertex.x - min.x;
+        case 1:
+            return max.x - vertex.x;
+        case 2:
+            return vertex.y - min.y;
+        default:
+            return max.y - vertex.y;
+        }
+    };
+
+    // vertices of the split edges are numbered after the vertices of these triangles. Both triangles of an
+    // edge look up the same split vertex, so the clipped triangles stay connected
+    std::vector<glm::dvec2> splitVertices;
+    std::vector<double> splitHeights;
+    std::map<std::tuple<uint32_t, uint32_t, int>, uint32_t> splits;
+    uint32_t vertexCount = static_cast<uint32_t>(m_vertices.size());
+    auto getVertex = [&](uint32_t id) -> const glm::dvec2 & {
+        return id < vertexCount ? m_vertices[id] : splitVertices[id - vertexCount];
+    };
+
+    auto getHeight = [&](uint32_t id) {
+        return id < vertexCount ? m_heights[id] : splitHeights[id - vertexCount];
+    };
+
+    auto splitEdge = [&](uint32_t a, uint32_t b, int side) {
+        if (b < a) {
+            std::swap(a, b);
+        }
+
+        auto split = splits.find(std::make_tuple(a, b, side));
+        if (split != splits.end()) {
+            return split->second;
+        }
+
+        glm::dvec2 vertexA = getVertex(a);
+        glm::dvec2 vertexB = getVertex(b);
+        double distanceA = getDistance(vertexA, side);
+        double t = distanceA / (distanceA - getDistance(vertexB, side));
+        glm::dvec2 vertex = vertexA + (vertexB - vertexA) * t;
+        if (side < 2) {
+            vertex.x = side == 0 ? min.x : max.x;
+        } else {
+            vertex.y = side == 2 ? min.y : max.y;
+        }
+
+        uint32_t id = vertexCount + static_cast<uint32_t>(splitVertices.size());
+        splitVertices.emplace_back(vertex);
+        splitHeights.emplace_back(getHeight(a) + (getHeight(b) - getHeight(a)) * t);
+        splits.insert({std::make_tuple(a, b, side), id});
+        return id;
+    };
+
+    std::vector<uint32_t> clippedIndices;
+    std::vector<uint32_t> polygon;
+    std::vector<uint32_t> clippedPolygon;
+    for (size_t i = 0; i < m_indices.size(); i += 3) {
+        glm::dvec2 p0 = m_vertices[m_indices[i]];
+        glm::dvec2 p1 = m_vertices[m_indices[i + 1]];
+        glm::dvec2 p2 = m_vertices[m_indices[i + 2]];
+        glm::dvec2 triangleMin = glm::min(p0, glm::min(p1, p2));
+        glm::dvec2 triangleMax = glm::max(p0, glm::max(p1, p2));
+        if (triangleMax.x <= min.x || triangleMin.x >= max.x || triangleMax.y <= min.y
+            || triangleMin.y >= max.y) {
+            continue;
+        }
+
+        if (triangleMin.x >= min.x && triangleMax.x <= max.x && triangleMin.y >= min.y
+            && triangleMax.y <= max.y) {
+            clippedIndices.emplace_back(m_indices[i]);
+            clippedIndices.emplace_back(m_indices[i + 1]);
+            clippedIndices.emplace_back(m_indices[i + 2]);
+            continue;
+        }
+
+        // Sutherland-Hodgman against each side. A vertex on a side is kept, and an edge is only split
+        // when it goes from one side of it to the other
+        polygon.assign(m_indices.begin() + static_cast<std::ptrdiff_t>(i),
+                       m_indices.begin() + static_cast<std::ptrdiff_t>(i + 3));
+        for (int side = 0; side < 4 && polygon.size() >= 3; ++side) {
+            clippedPolygon.clear();
+            for (size_t j = 0; j < polygon.size(); ++j) {
+                uint32_t current = polygon[j];
+                uint32_t next = polygon[(j + 1) % polygon.size()];
+                double currentDistance = getDistance(getVertex(current), side);
+                double nextDistance = getDistance(getVertex(next), side);
+                if (currentDistance >= 0.0) {
+                    clippedPolygon.emplace_back(current);
+                }
+
+                if ((currentDistance > 0.0 && nextDistance < 0.0)
+                    || (currentDistance < 0.0 && nextDistance > 0.0)) {
+                    clippedPolygon.emplace_back(splitEdge(current, next, side));
+                }
+            }
+
+            std::swap(polygon, clippedPolygon);
+        }
+
+        // the clipped polygon is convex, so a fan keeps the winding of the triangle
+        for (size_t j = 2; j < polygon.size(); ++j) {
+            glm::dvec2 a = getVertex(polygon[0]);
+            glm::dvec2 b = getVertex(polygon[j - 1]);
+            glm::dvec2 c = getVertex(polygon[j]);
+            double area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area != 0.0) {
+                clippedIndices.emplace_back(polygon[0]);
+                clippedIndices.emplace_back(polygon[j - 1]);
+                clippedIndices.emplace_back(polygon[j]);
+            }
+        }
+    }
+
+    ElevationTriangles clipped;
+    std::vector<uint32_t> remap(vertexCount + splitVertices.size(), std::numeric_limits<uint32_t>::max());
+    clipped.m_indices.reserve(clippedIndices.size());
+    for (auto id : clippedIndices) {
+        if (remap[id] == std::numeric_limits<uint32_t>::max()) {
+            remap[id] = static_cast<uint32_t>(clipped.m_vertices.size());
+            clipped.m_vertices.emplace_back(getVertex(id) - min);
+            clipped.m_heights.emplace_back(getHeight(id));
+        }
+
+        clipped.m_indices.emplace_back(remap[id]);
+    }
+
+    return clipped;
+}
+
+Mesh ElevationTriangles::createMesh(const ElevationView &view, const glm::dvec3 &up) const
+{
+    std::vector<Core::Cartographic> cartographics;
+    cartographics.reserve(m_vertices.size());
+    for (size_t i = 0; i < m_vertices.size(); ++i) {
+        cartographics.emplace_back(view.getCartographic(m_vertices[i], m_heights[i]));
+    }
+
+    std::vector<glm::dvec3> positions(m_vertices.size());
+    const auto &ellipsoid = Core::Ellipsoid::WGS84;
+    ellipsoid.cartographicToCartesian(cartographics.data(), cartographics.size(), positions.data());
+
+    Mesh mesh;
+    mesh.aabb = AABB();
+    std::vector<int> remap(m_vertices.size(), -1);
+    auto extractVertex = [&](uint32_t idx) {
+        if (remap[idx] == -1) {
+            const auto &position = positions[idx];
+            mesh.aabb->merge(position);
+            mesh.positions.emplace_back(position);
+            mesh.UVs.emplace_back(view.getUV(m_vertices[idx]));
+            remap[idx] = static_cast<int>(mesh.positions.size() - 1);
+        }
+
+        mesh.indices.emplace_back(remap[idx]);
+    };
+
+    for (size_t i = 0; i < m_indices.size(); i += 3) {
+        auto idx0 = m_indices[i];
+        auto idx1 = m_indices[i + 1];
+        auto idx2 = m_indices[i + 2];
+
+        const glm::dvec3 &p0 = positions[idx0];
+        const glm::dvec3 &p1 = positions[idx1];
+        const glm::dvec3 &p2 = positions[idx2];
+
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        if (glm::dot(normal, up) < 0.0) {
+            std::swap(idx0, idx2);
+        }
+
+        extractVertex(idx0);
+        extractVertex(idx1);
+        extractVertex(idx2);
+    }
+
+    // calculate position rtc
+    mesh.positionRTCs.reserve(mesh.positions.size());
+    glm::dvec3 center = mesh.aabb->center();
+    for (size_t i = 0; i < mesh.positions.size(); ++i) {
+        glm::vec3 positionRTC = mesh.positions[i] - center;
+        mesh.positionRTCs.emplace_back(positionRTC);
+    }
+
+    return mesh;
+}
+
+} // namespace CDBTo3DTiles
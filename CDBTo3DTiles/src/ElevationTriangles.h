@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ElevationView.h"
+#include "Scene.h"
+#include "glm/glm.hpp"
+#include <vector>
+
+namespace CDBTo3DTiles {
+// Triangles of a simplified elevation mesh. Vertices are a column and row of the view the triangles were
+// simplified from plus a height, so they are only converted to positions when a mesh is written. Clipping
+// the triangles to a quadrant of the view splits the edges that cross it, which puts vertices between the
+// grid vertices
+class ElevationTriangles
+{
+public:
+    ElevationTriangles() = default;
+
+    // triangles of indices into the vertices of the view. Only the vertices they use are kept
+    ElevationTriangles(const ElevationView &view, const std::vector<uint32_t> &indices);
+
+    inline const std::vector<glm::dvec2> &getVertices() const noexcept { return m_vertices; }
+
+    inline const std::vector<double> &getHeights() const noexcept { return m_heights; }
+
+    inline const std::vector<uint32_t> &getIndices() const noexcept { return m_indices; }
+
+    // the parts of the triangles between min and max, with vertices relative to min. Heights of the split
+    // vertices are interpolated along the edges, so the clipped surface is the same as this one
+    ElevationTriangles clip(glm::dvec2 min, glm::dvec2 max) const;
+
+    // positions and UVs of the vertices in the view, with every triangle facing the same side as up
+    Mesh createMesh(const ElevationView &view, const glm::dvec3 &up) const;
+
+private:
+    std::vector<glm::dvec2> m_vertices;
+    std::vector<double> m_heights;
+    std::vector<uint32_t> m_indices;
+};
+} // namespace CDBTo3DTiles
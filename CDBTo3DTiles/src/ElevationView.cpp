@@ -0,0 +1,149 @@
+#include "ElevationView.h"
+#include "Ellipsoid.h"
+#include "EllipsoidGrid.h"
+
+namespace CDBTo3DTiles {
+
+AABB ElevationView::convertPositions(glm::dvec3 *positions) const
+{
+    size_t verticesWidth = getVerticesWidth();
+    std::vector<double> longitudes(verticesWidth);
+    for (size_t x = 0; x < verticesWidth; ++x) {
+        longitudes[x] = getLongitude(x);
+    }
+
+    // every row shares a latitude and every column a longitude, so the trigonometry is evaluated once per
+    // row and once per column
+    Core::EllipsoidGrid grid(Core::Ellipsoid::WGS84, longitudes.data(), verticesWidth);
+    std::vector<double> heights(verticesWidth);
+    AABB aabb;
+    glm::dvec3 minimum = aabb.min;
+    glm::dvec3 maximum = aabb.max;
+    for (size_t y = 0; y < getVerticesHeight(); ++y) {
+        for (size_t x = 0; x < verticesWidth; ++x) {
+            heights[x] = static_cast<double>(getHeight(x, y));
+        }
+
+        grid.convertRow(getLatitude(y), heights.data(), positions + y * verticesWidth, minimum, maximum);
+    }
+
+    return AABB(minimum, maximum);
+}
+
+ElevationView::ElevationView(const float *heights,
+                             size_t stride,
+                             glm::uvec2 origin,
+                             glm::uvec2 extent,
+                             Core::Cartographic topLeft,
+                             glm::dvec2 pixelSize)
+    : m_heights{heights}
+    , m_stride{stride}
+    , m_origin{origin}
+    , m_extent{extent}
+    , m_topLeft{topLeft}
+    , m_pixelSize{pixelSize}
+    , m_UVOffset{0.0}
+    , m_UVScale{1.0 / (glm::dvec2(extent) + 1.0)}
+{}
+
+double ElevationView::getLongitude(size_t x) const
+{
+    return m_topLeft.longitude + glm::radians(static_cast<double>(x + m_origin.x) * m_pixelSize.x);
+}
+
+double ElevationView::getLatitude(size_t y) const
+{
+    return m_topLeft.latitude + glm::radians(static_cast<double>(y + m_origin.y) * m_pixelSize.y);
+}
+
+glm::dvec3 ElevationView::getPosition(size_t x, size_t y) const
+{
+    Core::Cartographic cartographic(getLongitude(x), getLatitude(y), static_cast<double>(getHeight(x, y)));
+    return Core::Ellipsoid::WGS84.cartographicToCartesian(cartographic);
+}
+
+Core::Cartographic ElevationView::getCartographic(glm::dvec2 vertex, double height) const
+{
+    glm::dvec2 degrees = (vertex + glm::dvec2(m_origin)) * m_pixelSize;
+    return Core::Cartographic(m_topLeft.longitude + glm::radians(degrees.x),
+                              m_topLeft.latitude + glm::radians(degrees.y),
+                              height);
+}
+
+void ElevationView::setUVTransform(glm::dvec2 offset, glm::dvec2 scale)
+{
+    m_UVOffset = offset;
+    m_UVScale = scale;
+}
+
+std::vector<glm::vec3> ElevationView::createPositionRTCs() const
+{
+    std::vector<glm::dvec3> positions(getVertexCount());
+    glm::dvec3 center = convertPositions(positions.data()).center();
+    std::vector<glm::vec3> positionRTCs;
+    positionRTCs.reserve(positions.size());
+    for (const auto &position : positions) {
+        positionRTCs.emplace_back(position - center);
+    }
+
+    return positionRTCs;
+}
+
+std::vector<uint32_t> ElevationView::createIndices() const
+{
+    std::vector<uint32_t> indices(getIndexCount());
+    size_t verticesWidth = getVerticesWidth();
+    uint32_t *index = indices.data();
+    for (size_t y = 0; y < getGridHeight(); ++y) {
+        for (size_t x = 0; x < getGridWidth(); ++x) {
+            uint32_t topLeftIndex = static_cast<uint32_t>(y * verticesWidth + x);
+            uint32_t bottomLeftIndex = static_cast<uint32_t>((y + 1) * verticesWidth + x);
+            index[0] = topLeftIndex + 1;
+            index[1] = topLeftIndex;
+            index[2] = bottomLeftIndex;
+
+            index[3] = bottomLeftIndex;
+            index[4] = bottomLeftIndex + 1;
+            index[5] = topLeftIndex + 1;
+            index += 6;
+        }
+    }
+
+    return indices;
+}
+
+Mesh ElevationView::createMesh() const
+{
+    Mesh mesh;
+    mesh.positions.resize(getVertexCount());
+    mesh.aabb = convertPositions(mesh.positions.data());
+
+    size_t verticesWidth = getVerticesWidth();
+    mesh.UVs.reserve(getVertexCount());
+    for (size_t y = 0; y < getVerticesHeight(); ++y) {
+        for (size_t x = 0; x < verticesWidth; ++x) {
+            mesh.UVs.emplace_back(getUV(x, y));
+        }
+    }
+
+    // calculate position rtc
+    mesh.positionRTCs.reserve(getVertexCount());
+    glm::dvec3 center = mesh.aabb->center();
+    for (const auto &position : mesh.positions) {
+        glm::vec3 positionRTC = position - center;
+        mesh.positionRTCs.emplace_back(positionRTC);
+    }
+
+    mesh.indices = createIndices();
+    return mesh;
+}
+
+ElevationView ElevationView::createSubView(glm::uvec2 origin, glm::uvec2 extent) const
+{
+    // the sub view measures its vertices from the same corner, so its positions are the same as here
+    ElevationView subView(m_heights, m_stride, m_origin + origin, extent, m_topLeft, m_pixelSize);
+    subView.setUVTransform(m_UVOffset + glm::dvec2(origin) * m_UVScale, m_UVScale);
+    return subView;
+}
+
+} // namespace CDBTo3DTiles
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Cartographic.h"
+#include "Scene.h"
+#include "glm/glm.hpp"
+#include <vector>
+
+namespace CDBTo3DTiles {
+// A non-owning window of extent pixels into the heights of an ElevationGrid, starting at the vertex origin
+// of the grid and stepping stride heights per row. Splitting a view into quadrants only moves the window, so
+// the heights have to outlive every view of them. Positions, UVs and indices are derived when they are needed
+class ElevationView
+{
+public:
+    ElevationView(const float *heights,
+                  size_t stride,
+                  glm::uvec2 origin,
+                  glm::uvec2 extent,
+                  Core::Cartographic topLeft,
+                  glm::dvec2 pixelSize);
+
+    inline size_t getGridWidth() const noexcept { return m_extent.x; }
+
+    inline size_t getGridHeight() const noexcept { return m_extent.y; }
+
+    inline size_t getVerticesWidth() const noexcept { return getGridWidth() + 1; }
+
+    inline size_t getVerticesHeight() const noexcept { return getGridHeight() + 1; }
+
+    inline size_t getVertexCount() const noexcept { return getVerticesWidth() * getVerticesHeight(); }
+
+    inline size_t getIndexCount() const noexcept { return getGridWidth() * getGridHeight() * 6; }
+
+    inline glm::uvec2 getOrigin() const noexcept { return m_origin; }
+
+    inline glm::uvec2 getExtent() const noexcept { return m_extent; }
+
+    inline size_t getStride() const noexcept { return m_stride; }
+
+    inline float getHeight(size_t x, size_t y) const noexcept
+    {
+        return m_heights[(m_origin.y + y) * m_stride + m_origin.x + x];
+    }
+
+    double getLongitude(size_t x) const;
+
+    double getLatitude(size_t y) const;
+
+    glm::dvec3 getPosition(size_t x, size_t y) const;
+
+    // a point between the vertices, at a fractional column and row of the view
+    Core::Cartographic getCartographic(glm::dvec2 vertex, double height) const;
+
+    // UVs are an affine function of the vertex column and row, so UVs relative to a parent tile or a
+    // sub region only change the offset and the scale
+    inline glm::vec2 getUV(size_t x, size_t y) const noexcept
+    {
+        return glm::vec2(static_cast<float>(m_UVOffset.x + static_cast<double>(x) * m_UVScale.x),
+                         static_cast<float>(m_UVOffset.y + static_cast<double>(y) * m_UVScale.y));
+    }
+
+    inline glm::vec2 getUV(glm::dvec2 vertex) const noexcept
+    {
+        return glm::vec2(m_UVOffset + vertex * m_UVScale);
+    }
+
+    inline glm::dvec2 getUVOffset() const noexcept { return m_UVOffset; }
+
+    inline glm::dvec2 getUVScale() const noexcept { return m_UVScale; }
+
+    void setUVTransform(glm::dvec2 offset, glm::dvec2 scale);
+
+    // positions relative to the center of the view's bounding box, in the same order as the vertices
+    std::vector<glm::vec3> createPositionRTCs() const;
+
+    // two triangles for every pixel
+    std::vector<uint32_t> createIndices() const;
+
+    Mesh createMesh() const;
+
+    // extent pixels starting at the vertex origin of this view. The sub view keeps the UVs it has here
+    ElevationView createSubView(glm::uvec2 origin, glm::uvec2 extent) const;
+
+private:
+    // converts every vertex into positions and returns their bounds
+    AABB convertPositions(glm::dvec3 *positions) const;
+
+    const float *m_heights;
+    size_t m_stride;
+    glm::uvec2 m_origin;
+    glm::uvec2 m_extent;
+    Core::Cartographic m_topLeft;
+    glm::dvec2 m_pixelSize;
+    glm::dvec2 m_UVOffset;
+    glm::dvec2 m_UVScale;
+};
+} // namespace CDBTo3DTiles
@@ -5,8 +5,11 @@
 #include "Gltf.h"
 #include "Utility.h"
 
+#include <algorithm>
 #include <iostream>
 #include <filesystem>
+#include <sstream>
+#include <stdexcept>
 
 namespace std {
 template<>
@@ -713,39 +716,101 @@ void combineGltfs(tinygltf::Model *model, std::vector<tinygltf::Model> glbs) {
     model->extensionsRequired.emplace_back("EXT_mesh_gpu_instancing");
 }
 
-// Writes GLB and adds 0x20 (' ') characters to end of JSON chunk, resizes GLB
-// length and JSON chunk length, if JSON chunk is not padded to 8 bytes.
-void writePaddedGLB(tinygltf::Model *gltf, std::ofstream &fs) {
-    // Write GLB to stringstream.
-    tinygltf::TinyGLTF io;
-    std::stringstream glbStream;
-    io.WriteGltfSceneToStream(gltf, glbStream, false, true);
-    
-    // PERFORMANCE_IDEA: We're copying the whole GLB buffer here. Can we do it in-place?
-    std::string glbStr = glbStream.str();
-    // Get length of GLB and JSON chunk.
+static bool keepImageURI(const std::string *, const std::string *, tinygltf::Image *, bool, void *)
+{
+    return true;
+}
+
+GLBWriter::GLBWriter(tinygltf::Model *gltf, size_t binChunkAlignment)
+    : m_gltf{gltf}
+{
+    // only the first buffer without uri goes to the BIN chunk, like tinygltf does. Its data is moved out
+    // while the JSON is serialized, so tinygltf doesn't copy or base64 encode it
+    bool hasBinChunk = !gltf->buffers.empty() && gltf->buffers.front().uri.empty();
+    std::vector<unsigned char> binData;
+    std::stringstream jsonStream;
+    if (hasBinChunk) {
+        std::swap(binData, gltf->buffers.front().data);
+    }
+
+    try {
+        // images only ever reference texture files written by the caller. Without this, tinygltf encodes
+        // decoded pixels to files in the working directory and points the URI at them
+        tinygltf::TinyGLTF io;
+        io.SetImageWriter(keepImageURI, nullptr);
+        io.WriteGltfSceneToStream(gltf, jsonStream, false, false);
+    } catch (...) {
+        if (hasBinChunk) {
+            std::swap(binData, gltf->buffers.front().data);
+        }
+
+        throw;
+    }
+
+    if (hasBinChunk) {
+        std::swap(binData, gltf->buffers.front().data);
+    }
+
+    // tinygltf serializes the moved out buffer as an empty data URI. It is the first buffer, so the first
+    // match is replaced with the BIN chunk buffer. A match can't be inside a string, where quotes are escaped
+    m_jsonChunk = jsonStream.str();
+    if (hasBinChunk) {
+        static const std::string EMPTY_BUFFER
+            = "{\"byteLength\":0,\"uri\":\"data:application/octet-stream;base64,\"}";
+        auto emptyBuffer = m_jsonChunk.find(EMPTY_BUFFER);
+        if (emptyBuffer == std::string::npos) {
+            throw std::runtime_error("Failed to find the BIN chunk buffer in the glTF JSON");
+        }
+
+        m_jsonChunk.replace(emptyBuffer,
+                            EMPTY_BUFFER.size(),
+                            "{\"byteLength\":" + std::to_string(gltf->buffers.front().data.size()) + "}");
+    }
+
     // https://github.com/KhronosGroup/glTF/tree/master/specification/2.0#binary-gltf-layout
-    uint32_t glbLength;
-    std::memcpy(&glbLength, glbStr.c_str() + 8, 4);
-    uint32_t jsonChunkLength;
-    std::memcpy(&jsonChunkLength, glbStr.c_str() + 12, 4);
-    // Add padding for EXT_feature_metadata
-    size_t binChunkOffset = 20 + jsonChunkLength;
-    if (binChunkOffset % 8 != 0) {
-        // Add padding (using spaces) to JSON chunk data.
-        size_t paddingByteLength = roundUp(binChunkOffset, 8) - binChunkOffset;
-        glbStr.insert(binChunkOffset, paddingByteLength, ' ');
-
-        // Update GLB length.
-        glbLength += static_cast<uint32_t>(paddingByteLength);
-        glbStr[8] = static_cast<unsigned char>(glbLength);
-
-        // Update JSON chunk length.
-        jsonChunkLength += static_cast<uint32_t>(paddingByteLength);
-        glbStr[12] = static_cast<unsigned char>(jsonChunkLength);
+    // JSON chunk is padded with spaces, so the BIN chunk starts at the requested alignment.
+    // EXT_feature_metadata needs 8 bytes, the chunks themselves only need 4
+    size_t binChunkOffset = roundUp(20 + m_jsonChunk.size(), std::max<size_t>(binChunkAlignment, 4));
+    m_jsonChunkByteLength = binChunkOffset - 20;
+    m_jsonChunk.resize(m_jsonChunkByteLength, ' ');
+
+    m_binChunkByteLength = 0;
+    m_byteLength = binChunkOffset;
+    if (hasBinChunk && !gltf->buffers.front().data.empty()) {
+        m_binChunkByteLength = roundUp(gltf->buffers.front().data.size(), 4);
+        m_byteLength += 8 + m_binChunkByteLength;
     }
-    // Write stream to file.
-    fs << glbStr;
+}
+
+void GLBWriter::write(std::ostream &fs) const
+{
+    auto writeUint32 = [&fs](size_t value) {
+        uint32_t value32 = static_cast<uint32_t>(value);
+        fs.write(reinterpret_cast<const char *>(&value32), sizeof(value32));
+    };
+
+    fs.write("glTF", 4);
+    writeUint32(2);
+    writeUint32(m_byteLength);
+
+    writeUint32(m_jsonChunkByteLength);
+    writeUint32(0x4E4F534A);
+    fs.write(m_jsonChunk.data(), static_cast<std::streamsize>(m_jsonChunk.size()));
+
+    if (m_binChunkByteLength > 0) {
+        const auto &binData = m_gltf->buffers.front().data;
+        writeUint32(m_binChunkByteLength);
+        writeUint32(0x004E4942);
+        fs.write(reinterpret_cast<const char *>(binData.data()), static_cast<std::streamsize>(binData.size()));
+
+        static const char ZEROS[4] = {0, 0, 0, 0};
+        fs.write(ZEROS, static_cast<std::streamsize>(m_binChunkByteLength - binData.size()));
+    }
+}
+
+// Writes GLB with the JSON chunk padded with 0x20 (' ') characters, so the BIN chunk is aligned to 8 bytes.
+void writePaddedGLB(tinygltf::Model *gltf, std::ostream &fs) {
+    GLBWriter(gltf, 8).write(fs);
 }
 
 } // namespace CDBTo3DTiles
@@ -6,6 +6,8 @@
 #include "tiny_gltf.h"
 #include <filesystem>
 #include <functional>
+#include <ostream>
+#include <string>
 #include <unordered_set>
 #include <vector>
 
@@ -18,8 +20,27 @@ tinygltf::Model createGltf(const std::vector<Mesh> &meshes,
                            const std::vector<Texture> &textures,
                            bool use3dTilesNext = false);
 
+// Writes a GLB without buffering it. The JSON chunk is serialized up front, so the GLB length is known
+// before anything is written, and the BIN chunk is written straight from the first buffer of the model.
+class GLBWriter
+{
+public:
+    GLBWriter(tinygltf::Model *gltf, size_t binChunkAlignment);
+
+    inline size_t getByteLength() const noexcept { return m_byteLength; }
+
+    void write(std::ostream &fs) const;
+
+private:
+    const tinygltf::Model *m_gltf;
+    std::string m_jsonChunk;
+    size_t m_jsonChunkByteLength;
+    size_t m_binChunkByteLength;
+    size_t m_byteLength;
+};
+
 void combineGltfs(tinygltf::Model *model, std::vector<tinygltf::Model> glbs);
-void writePaddedGLB(tinygltf::Model *gltf, std::ofstream &fs);
+void writePaddedGLB(tinygltf::Model *gltf, std::ostream &fs);
 bool ParseJsonAsValue(tinygltf::Value *ret, const nlohmann::json &o);
 
 uint createMetadataBufferView(tinygltf::Model *gltf, std::vector<uint8_t> data);
@@ -0,0 +1,320 @@
+#include "MappedGeoTIFF.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <optional>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace CDBTo3DTiles {
+
+static constexpr uint16_t TIFF_IMAGE_WIDTH = 256;
+static constexpr uint16_t TIFF_IMAGE_LENGTH = 257;
+static constexpr uint16_t TIFF_BITS_PER_SAMPLE = 258;
+static constexpr uint16_t TIFF_COMPRESSION = 259;
+static constexpr uint16_t TIFF_STRIP_OFFSETS = 273;
+static constexpr uint16_t TIFF_SAMPLES_PER_PIXEL = 277;
+static constexpr uint16_t TIFF_ROWS_PER_STRIP = 278;
+static constexpr uint16_t TIFF_STRIP_BYTE_COUNTS = 279;
+static constexpr uint16_t TIFF_TILE_WIDTH = 322;
+static constexpr uint16_t TIFF_TILE_LENGTH = 323;
+static constexpr uint16_t TIFF_TILE_OFFSETS = 324;
+static constexpr uint16_t TIFF_TILE_BYTE_COUNTS = 325;
+static constexpr uint16_t TIFF_SAMPLE_FORMAT = 339;
+static constexpr uint16_t GEOTIFF_MODEL_PIXEL_SCALE = 33550;
+static constexpr uint16_t GEOTIFF_MODEL_TRANSFORMATION = 34264;
+
+static constexpr uint16_t TIFF_TYPE_SHORT = 3;
+static constexpr uint16_t TIFF_TYPE_LONG = 4;
+static constexpr uint16_t TIFF_TYPE_DOUBLE = 12;
+
+struct TIFFEntry
+{
+    uint16_t type;
+    uint32_t count;
+    size_t valueOffset;
+};
+
+static bool isLittleEndianHost()
+{
+    uint16_t value = 1;
+    uint8_t firstByte;
+    std::memcpy(&firstByte, &value, 1);
+    return firstByte == 1;
+}
+
+static uint16_t readUInt16(const uint8_t *data)
+{
+    return static_cast<uint16_t>(data[0] | data[1] << 8);
+}
+
+static uint32_t readUInt32(const uint8_t *data)
+{
+    return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8
+           | static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+static bool readUnsignedValues(const uint8_t *data,
+                               size_t byteLength,
+                               const TIFFEntry &entry,
+                               std::vector<uint64_t> &values)
+{
+    size_t typeSize = entry.type == TIFF_TYPE_SHORT ? 2 : 4;
+    if ((entry.type != TIFF_TYPE_SHORT && entry.type != TIFF_TYPE_LONG)
+        || entry.valueOffset + entry.count * typeSize > byteLength) {
+        return false;
+    }
+
+    values.resize(entry.count);
+    for (size_t i = 0; i < entry.count; ++i) {
+        const uint8_t *value = data + entry.valueOffset + i * typeSize;
+        values[i] = typeSize == 2 ? readUInt16(value) : readUInt32(value);
+    }
+
+    return true;
+}
+
+static bool readDoubleValues(const uint8_t *data,
+                             size_t byteLength,
+                             const TIFFEntry &entry,
+                             std::vector<double> &values)
+{
+    if (entry.type != TIFF_TYPE_DOUBLE || entry.valueOffset + entry.count * sizeof(double) > byteLength) {
+        return false;
+    }
+
+    values.resize(entry.count);
+    std::memcpy(values.data(), data + entry.valueOffset, entry.count * sizeof(double));
+    return true;
+}
+
+MappedGeoTIFF::MappedGeoTIFF()
+    : m_data{nullptr}
+    , m_byteLength{0}
+    , m_mapping{nullptr}
+    , m_heights{nullptr}
+    , m_width{0}
+    , m_height{0}
+    , m_pixelSizeX{0}
+    , m_pixelSizeY{0}
+{}
+
+MappedGeoTIFF::~MappedGeoTIFF() noexcept
+{
+#ifndef _WIN32
+    if (m_mapping) {
+        munmap(m_mapping, m_byteLength);
+    }
+#endif
+}
+
+std::unique_ptr<MappedGeoTIFF> MappedGeoTIFF::open(const std::filesystem::path &path)
+{
+    // the reader only decodes little endian files into a little endian host
+    if (!isLittleEndianHost()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedGeoTIFF> geoTIFF(new MappedGeoTIFF());
+    if (!geoTIFF->map(path) || !geoTIFF->parse()) {
+        return nullptr;
+    }
+
+    return geoTIFF;
+}
+
+bool MappedGeoTIFF::map(const std::filesystem::path &path)
+{
+#ifdef _WIN32
+    std::ifstream fs(path, std::ios::binary);
+    if (!fs) {
+        return false;
+    }
+
+    m_fileContent.assign(std::istreambuf_iterator<char>(fs), {});
+    m_data = m_fileContent.data();
+    m_byteLength = m_fileContent.size();
+    return true;
+#else
+    int fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size <= 0) {
+        close(fileDescriptor);
+        return false;
+    }
+
+    size_t byteLength = static_cast<size_t>(fileStatus.st_size);
+    void *mapping = mmap(nullptr, byteLength, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_data = static_cast<const uint8_t *>(mapping);
+    m_byteLength = byteLength;
+    return true;
+#endif
+}
+
+bool MappedGeoTIFF::parse()
+{
+    // classic little endian TIFF only. BigTIFF and big endian files go to GDAL
+    if (m_byteLength < 8 || m_data[0] != 'I' || m_data[1] != 'I' || readUInt16(m_data + 2) != 42) {
+        return false;
+    }
+
+    size_t IFDOffset = readUInt32(m_data + 4);
+    if (IFDOffset + 2 > m_byteLength) {
+        return false;
+    }
+
+    size_t entryCount = readUInt16(m_data + IFDOffset);
+    if (IFDOffset + 2 + entryCount * 12 > m_byteLength) {
+        return false;
+    }
+
+    std::map<uint16_t, TIFFEntry> entries;
+    for (size_t i = 0; i < entryCount; ++i) {
+        const uint8_t *entryData = m_data + IFDOffset + 2 + i * 12;
+        TIFFEntry entry;
+        entry.type = readUInt16(entryData + 2);
+        entry.count = readUInt32(entryData + 4);
+
+        size_t typeSize = entry.type == TIFF_TYPE_DOUBLE ? 8 : (entry.type == TIFF_TYPE_LONG ? 4 : 2);
+        if (static_cast<uint64_t>(entry.count) * typeSize <= 4) {
+            entry.valueOffset = static_cast<size_t>(entryData + 8 - m_data);
+        } else {
+            entry.valueOffset = readUInt32(entryData + 8);
+        }
+
+        entries.insert({readUInt16(entryData), entry});
+    }
+
+    auto getUnsigned = [&](uint16_t tag, uint64_t defaultValue) -> std::optional<uint64_t> {
+        auto entry = entries.find(tag);
+        if (entry == entries.end()) {
+            return defaultValue;
+        }
+
+        std::vector<uint64_t> values;
+        if (!readUnsignedValues(m_data, m_byteLength, entry->second, values) || values.empty()) {
+            return std::nullopt;
+        }
+
+        return values.front();
+    };
+
+    auto width = getUnsigned(TIFF_IMAGE_WIDTH, 0);
+    auto height = getUnsigned(TIFF_IMAGE_LENGTH, 0);
+    auto compression = getUnsigned(TIFF_COMPRESSION, 1);
+    auto bitsPerSample = getUnsigned(TIFF_BITS_PER_SAMPLE, 1);
+    auto samplesPerPixel = getUnsigned(TIFF_SAMPLES_PER_PIXEL, 1);
+    auto sampleFormat = getUnsigned(TIFF_SAMPLE_FORMAT, 1);
+    if (!width || !height || *width == 0 || *height == 0 || compression != 1u || bitsPerSample != 32u
+        || samplesPerPixel != 1u || sampleFormat != 3u) {
+        return false;
+    }
+
+    // the pixel size is all the caller needs from the geo transform. A full transformation matrix
+    // may be rotated, so it is left to GDAL
+    auto pixelScale = entries.find(GEOTIFF_MODEL_PIXEL_SCALE);
+    std::vector<double> pixelScales;
+    if (entries.find(GEOTIFF_MODEL_TRANSFORMATION) != entries.end() || pixelScale == entries.end()
+        || !readDoubleValues(m_data, m_byteLength, pixelScale->second, pixelScales)
+        || pixelScales.size() < 2) {
+        return false;
+    }
+
+    m_width = static_cast<size_t>(*width);
+    m_height = static_cast<size_t>(*height);
+    m_pixelSizeX = pixelScales[0];
+    m_pixelSizeY = -pixelScales[1];
+
+    // strips are a tiled layout whose tiles span the whole width
+    bool isTiled = entries.find(TIFF_TILE_OFFSETS) != entries.end();
+    std::optional<uint64_t> blockWidth = m_width;
+    std::optional<uint64_t> blockHeight;
+    std::vector<uint64_t> blockOffsets;
+    std::vector<uint64_t> blockByteCounts;
+    if (isTiled) {
+        blockWidth = getUnsigned(TIFF_TILE_WIDTH, 0);
+        blockHeight = getUnsigned(TIFF_TILE_LENGTH, 0);
+        auto byteCounts = entries.find(TIFF_TILE_BYTE_COUNTS);
+        if (byteCounts == entries.end()
+            || !readUnsignedValues(m_data, m_byteLength, entries.at(TIFF_TILE_OFFSETS), blockOffsets)
+            || !readUnsignedValues(m_data, m_byteLength, byteCounts->second, blockByteCounts)) {
+            return false;
+        }
+    } else {
+        blockHeight = getUnsigned(TIFF_ROWS_PER_STRIP, m_height);
+        auto offsets = entries.find(TIFF_STRIP_OFFSETS);
+        auto byteCounts = entries.find(TIFF_STRIP_BYTE_COUNTS);
+        if (offsets == entries.end() || byteCounts == entries.end()
+            || !readUnsignedValues(m_data, m_byteLength, offsets->second, blockOffsets)
+            || !readUnsignedValues(m_data, m_byteLength, byteCounts->second, blockByteCounts)) {
+            return false;
+        }
+    }
+
+    if (!blockWidth || !blockHeight || *blockWidth == 0 || *blockHeight == 0) {
+        return false;
+    }
+
+    size_t blockColumns = (m_width + *blockWidth - 1) / *blockWidth;
+    size_t blockRows = (m_height + std::min<uint64_t>(*blockHeight, m_height) - 1)
+                       / std::min<uint64_t>(*blockHeight, m_height);
+    if (blockOffsets.size() != blockColumns * blockRows || blockByteCounts.size() != blockOffsets.size()) {
+        return false;
+    }
+
+    // every block has to be in the file. The last strip may be shorter than the others
+    size_t rowsPerBlock = static_cast<size_t>(std::min<uint64_t>(*blockHeight, m_height));
+    size_t blockRowByteLength = static_cast<size_t>(*blockWidth) * sizeof(float);
+    bool isContiguous = !isTiled;
+    for (size_t i = 0; i < blockOffsets.size(); ++i) {
+        size_t firstRow = (i / blockColumns) * rowsPerBlock;
+        size_t rows = isTiled ? rowsPerBlock : std::min(rowsPerBlock, m_height - firstRow);
+        size_t blockByteLength = rows * blockRowByteLength;
+        if (blockByteCounts[i] < blockByteLength || blockOffsets[i] + blockByteLength > m_byteLength) {
+            return false;
+        }
+
+        isContiguous = isContiguous
+                       && blockOffsets[i] == blockOffsets[0] + i * rowsPerBlock * blockRowByteLength;
+    }
+
+    // the mapping is page aligned, so only the offset decides if the floats can be read in place
+    if (isContiguous && blockOffsets[0] % alignof(float) == 0) {
+        m_heights = reinterpret_cast<const float *>(m_data + blockOffsets[0]);
+        return true;
+    }
+
+    m_copiedHeights.resize(m_width * m_height);
+    for (size_t i = 0; i < blockOffsets.size(); ++i) {
+        size_t x = (i % blockColumns) * static_cast<size_t>(*blockWidth);
+        size_t y = (i / blockColumns) * rowsPerBlock;
+        size_t columns = std::min(static_cast<size_t>(*blockWidth), m_width - x);
+        size_t rows = std::min(rowsPerBlock, m_height - y);
+        for (size_t row = 0; row < rows; ++row) {
+            std::memcpy(m_copiedHeights.data() + (y + row) * m_width + x,
+                        m_data + blockOffsets[i] + row * blockRowByteLength,
+                        columns * sizeof(float));
+        }
+    }
+
+    m_heights = m_copiedHeights.data();
+    return true;
+}
+
+} // namespace CDBTo3DTiles
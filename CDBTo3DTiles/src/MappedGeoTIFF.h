@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace CDBTo3DTiles {
+// Reads the heights of an uncompressed single band float32 GeoTIFF, the layout of most CDB elevation tiles,
+// straight from the memory mapped file. Any other layout isn't opened, so the caller can fall back to GDAL
+class MappedGeoTIFF
+{
+public:
+    MappedGeoTIFF(const MappedGeoTIFF &) = delete;
+
+    MappedGeoTIFF &operator=(const MappedGeoTIFF &) = delete;
+
+    ~MappedGeoTIFF() noexcept;
+
+    inline size_t getWidth() const noexcept { return m_width; }
+
+    inline size_t getHeight() const noexcept { return m_height; }
+
+    inline double getPixelSizeX() const noexcept { return m_pixelSizeX; }
+
+    inline double getPixelSizeY() const noexcept { return m_pixelSizeY; }
+
+    // heights in row major order, from the north west corner like GDAL reads them
+    inline const float *getHeights() const noexcept { return m_heights; }
+
+    // a single run of rows is used in place. Tiled or scattered rows are copied into one buffer first
+    inline bool isZeroCopy() const noexcept { return m_copiedHeights.empty(); }
+
+    static std::unique_ptr<MappedGeoTIFF> open(const std::filesystem::path &path);
+
+private:
+    MappedGeoTIFF();
+
+    bool map(const std::filesystem::path &path);
+
+    bool parse();
+
+    const uint8_t *m_data;
+    size_t m_byteLength;
+    void *m_mapping;
+    std::vector<uint8_t> m_fileContent;
+    std::vector<float> m_copiedHeights;
+    const float *m_heights;
+    size_t m_width;
+    size_t m_height;
+    double m_pixelSizeX;
+    double m_pixelSizeY;
+};
+} // namespace CDBTo3DTiles
@@ -0,0 +1,605 @@
+#include "OutputSink.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace CDBTo3DTiles {
+
+static const uint16_t ZIP_VERSION = 20;
+static const uint16_t ZIP64_VERSION = 45;
+static const uint16_t ZIP_UTF8_FLAG = 0x0800;
+static const uint16_t ZIP_DATE = 0x0021;
+static const uint32_t ZIP_MAX_UINT32 = 0xFFFFFFFF;
+
+static const std::array<uint32_t, 256> CRC32_TABLE = []() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < table.size(); ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (0xEDB88320u ^ (crc >> 1)) : (crc >> 1);
+        }
+
+        table[i] = crc;
+    }
+
+    return table;
+}();
+
+static uint32_t computeCRC32(const char *data, size_t byteLength)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < byteLength; ++i) {
+        crc = CRC32_TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template<typename T>
+static void appendLittleEndian(std::string &buffer, T value)
+{
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+static std::array<uint8_t, 16> computeMD5(const char *data, size_t byteLength)
+{
+    static const uint32_t SHIFTS[64] = {7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+                                        5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20,
+                                        4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+                                        6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21};
+    static const std::array<uint32_t, 64> CONSTANTS = []() {
+        std::array<uint32_t, 64> constants{};
+        for (size_t i = 0; i < constants.size(); ++i) {
+            constants[i] = static_cast<uint32_t>(std::floor(std::fabs(std::sin(static_cast<double>(i + 1)))
+                                                            * 4294967296.0));
+        }
+
+        return constants;
+    }();
+
+    uint32_t state[4] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476};
+    auto processBlock = [&](const uint8_t *block) {
+        uint32_t words[16];
+        for (size_t i = 0; i < 16; ++i) {
+            words[i] = static_cast<uint32_t>(block[i * 4]) | static_cast<uint32_t>(block[i * 4 + 1]) << 8
+                       | static_cast<uint32_t>(block[i * 4 + 2]) << 16
+                       | static_cast<uint32_t>(block[i * 4 + 3]) << 24;
+        }
+
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        for (uint32_t i = 0; i < 64; ++i) {
+            uint32_t f;
+            uint32_t g;
+            if (i < 16) {
+                f = (b & c) | (~b & d);
+                g = i;
+            } else if (i < 32) {
+                f = (d & b) | (~d & c);
+                g = (5 * i + 1) % 16;
+            } else if (i < 48) {
+                f = b ^ c ^ d;
+                g = (3 * i + 5) % 16;
+            } else {
+                f = c ^ (b | ~d);
+                g = (7 * i) % 16;
+            }
+
+            f = f + a + CONSTANTS[i] + words[g];
+            a = d;
+            d = c;
+            c = b;
+            b = b + ((f << SHIFTS[i]) | (f >> (32 - SHIFTS[i])));
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+    };
+
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+    size_t blockCount = byteLength / 64;
+    for (size_t i = 0; i < blockCount; ++i) {
+        processBlock(bytes + i * 64);
+    }
+
+    // the last block is padded with a one bit, zeros and the message length in bits
+    uint8_t tail[128] = {};
+    size_t tailByteLength = byteLength - blockCount * 64;
+    std::memcpy(tail, bytes + blockCount * 64, tailByteLength);
+    tail[tailByteLength] = 0x80;
+    size_t paddedByteLength = tailByteLength < 56 ? 64 : 128;
+    uint64_t bitLength = static_cast<uint64_t>(byteLength) * 8;
+    for (size_t i = 0; i < 8; ++i) {
+        tail[paddedByteLength - 8 + i] = static_cast<uint8_t>(bitLength >> (8 * i));
+    }
+
+    for (size_t offset = 0; offset < paddedByteLength; offset += 64) {
+        processBlock(tail + offset);
+    }
+
+    std::array<uint8_t, 16> hash;
+    for (size_t i = 0; i < 16; ++i) {
+        hash[i] = static_cast<uint8_t>(state[i / 4] >> (8 * (i % 4)));
+    }
+
+    return hash;
+}
+
+void OutputSink::createDirectories(const std::filesystem::path &) {}
+
+bool OutputSink::isFileSystem() const noexcept
+{
+    return false;
+}
+
+void OutputSink::finish() {}
+
+void FileSystemOutputSink::write(const std::filesystem::path &path, const char *data, size_t byteLength)
+{
+    std::ofstream fs(path, std::ios::binary);
+    if (!fs) {
+        // only create the directory when it is missing, to avoid an extra round trip per file
+        std::filesystem::create_directories(path.parent_path());
+        fs.open(path, std::ios::binary);
+    }
+
+    fs.write(data, static_cast<std::streamsize>(byteLength));
+    if (!fs) {
+        throw std::runtime_error("Failed to write " + path.string());
+    }
+}
+
+void FileSystemOutputSink::createDirectories(const std::filesystem::path &path)
+{
+    std::filesystem::create_directories(path);
+}
+
+bool FileSystemOutputSink::isFileSystem() const noexcept
+{
+    return true;
+}
+
+FileSystemOutputSink &FileSystemOutputSink::getInstance()
+{
+    static FileSystemOutputSink instance;
+    return instance;
+}
+
+const std::string ArchiveOutputSink::INDEX_NAME = "@3dtilesIndex1@";
+
+ArchiveOutputSink::ArchiveOutputSink(const std::filesystem::path &archivePath,
+                                     const std::filesystem::path &rootPath)
+    : m_archivePath{archivePath}
+    , m_rootPath{rootPath}
+    , m_offset{0}
+    , m_isFinished{false}
+{
+    if (archivePath.has_parent_path()) {
+        std::filesystem::create_directories(archivePath.parent_path());
+    }
+
+    m_archive.open(archivePath, std::ios::binary);
+    if (!m_archive) {
+        throw std::runtime_error("Failed to create " + archivePath.string());
+    }
+}
+
+ArchiveOutputSink::~ArchiveOutputSink() noexcept
+{
+    try {
+        finish();
+    } catch (...) {
+    }
+}
+
+void ArchiveOutputSink::write(const std::filesystem::path &path, const char *data, size_t byteLength)
+{
+    // hash the content before taking the lock, so only the append itself is serialized
+    Entry entry;
+    entry.name = path.lexically_relative(m_rootPath).generic_string();
+    entry.hash = computeMD5(entry.name.data(), entry.name.size());
+    entry.crc32 = computeCRC32(data, byteLength);
+    entry.byteLength = byteLength;
+    entry.offset = 0;
+    if (entry.name.size() > std::numeric_limits<uint16_t>::max()) {
+        throw std::runtime_error("Path " + entry.name + " is too long to be archived");
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_isFinished) {
+        throw std::runtime_error("Can't write " + entry.name + " to a finished archive");
+    }
+
+    // a file written again is appended again, and the central directory only keeps the last one
+    appendFile(entry, data);
+    auto entryIndex = m_entryIndices.find(entry.name);
+    if (entryIndex == m_entryIndices.end()) {
+        m_entryIndices.insert({entry.name, m_entries.size()});
+        m_entries.emplace_back(std::move(entry));
+    } else {
+        m_entries[entryIndex->second] = std::move(entry);
+    }
+}
+
+void ArchiveOutputSink::finish()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_isFinished) {
+        return;
+    }
+
+    m_isFinished = true;
+    writeIndex();
+    writeCentralDirectory();
+}
+
+void ArchiveOutputSink::appendFile(Entry &entry, const char *data)
+{
+    bool isZip64 = entry.byteLength >= ZIP_MAX_UINT32;
+    uint32_t byteLength = isZip64 ? ZIP_MAX_UINT32 : static_cast<uint32_t>(entry.byteLength);
+    std::string localHeader;
+    localHeader.reserve(30 + entry.name.size() + 20);
+    appendLittleEndian<uint32_t>(localHeader, 0x04034B50);
+    appendLittleEndian<uint16_t>(localHeader, isZip64 ? ZIP64_VERSION : ZIP_VERSION);
+    appendLittleEndian<uint16_t>(localHeader, ZIP_UTF8_FLAG);
+    appendLittleEndian<uint16_t>(localHeader, 0);
+    appendLittleEndian<uint16_t>(localHeader, 0);
+    appendLittleEndian<uint16_t>(localHeader, ZIP_DATE);
+    appendLittleEndian<uint32_t>(localHeader, entry.crc32);
+    appendLittleEndian<uint32_t>(localHeader, byteLength);
+    appendLittleEndian<uint32_t>(localHeader, byteLength);
+    appendLittleEndian<uint16_t>(localHeader, static_cast<uint16_t>(entry.name.size()));
+    appendLittleEndian<uint16_t>(localHeader, isZip64 ? 20 : 0);
+    localHeader += entry.name;
+    if (isZip64) {
+        appendLittleEndian<uint16_t>(localHeader, 0x0001);
+        appendLittleEndian<uint16_t>(localHeader, 16);
+        appendLittleEndian<uint64_t>(localHeader, entry.byteLength);
+        appendLittleEndian<uint64_t>(localHeader, entry.byteLength);
+    }
+
+    m_archive.write(localHeader.data(), static_cast<std::streamsize>(localHeader.size()));
+    m_archive.write(data, static_cast<std::streamsize>(entry.byteLength));
+    if (!m_archive) {
+        throw std::runtime_error("Failed to write " + entry.name + " to " + m_archivePath.string());
+    }
+
+    entry.offset = m_offset;
+    m_offset += localHeader.size() + entry.byteLength;
+}
+
+void ArchiveOutputSink::writeIndex()
+{
+    // 3TZ readers binary search the index by the MD5 hash of the file path. The hash is compared as two
+    // little endian uint64, the last 8 bytes first
+    std::vector<const Entry *> sortedEntries;
+    sortedEntries.reserve(m_entries.size());
+    for (const auto &entry : m_entries) {
+        sortedEntries.emplace_back(&entry);
+    }
+
+    auto hashKey = [](const Entry *entry) {
+        uint64_t low = 0;
+        uint64_t high = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            low |= static_cast<uint64_t>(entry->hash[i]) << (8 * i);
+            high |= static_cast<uint64_t>(entry->hash[i + 8]) << (8 * i);
+        }
+
+        return std::make_pair(high, low);
+    };
+
+    std::sort(sortedEntries.begin(), sortedEntries.end(), [&](const Entry *lhs, const Entry *rhs) {
+        return hashKey(lhs) < hashKey(rhs);
+    });
+
+    std::string index;
+    index.reserve(sortedEntries.size() * 24);
+    for (const auto *entry : sortedEntries) {
+        index.append(reinterpret_cast<const char *>(entry->hash.data()), entry->hash.size());
+        appendLittleEndian<uint64_t>(index, entry->offset);
+    }
+
+    Entry indexEntry;
+    indexEntry.name = INDEX_NAME;
+    indexEntry.hash = computeMD5(INDEX_NAME.data(), INDEX_NAME.size());
+    indexEntry.crc32 = computeCRC32(index.data(), index.size());
+    indexEntry.byteLength = index.size();
+    indexEntry.offset = 0;
+    appendFile(indexEntry, index.data());
+
+    // the index has to be the last entry of the central directory
+    m_entries.emplace_back(std::move(indexEntry));
+}
+
+void ArchiveOutputSink::writeCentralDirectory()
+{
+    uint64_t centralDirectoryOffset = m_offset;
+    std::string centralDirectory;
+    for (const auto &entry : m_entries) {
+        // zip64 moves every field that doesn't fit in 32 bits to the extra field, in this order
+        std::string zip64Extra;
+        if (entry.byteLength >= ZIP_MAX_UINT32) {
+            appendLittleEndian<uint64_t>(zip64Extra, entry.byteLength);
+            appendLittleEndian<uint64_t>(zip64Extra, entry.byteLength);
+        }
+
+        if (entry.offset >= ZIP_MAX_UINT32) {
+            appendLittleEndian<uint64_t>(zip64Extra, entry.offset);
+        }
+
+        uint32_t byteLength = entry.byteLength >= ZIP_MAX_UINT32 ? ZIP_MAX_UINT32
+                                                                 : static_cast<uint32_t>(entry.byteLength);
+        uint32_t offset = entry.offset >= ZIP_MAX_UINT32 ? ZIP_MAX_UINT32
+                                                         : static_cast<uint32_t>(entry.offset);
+        uint16_t version = zip64Extra.empty() ? ZIP_VERSION : ZIP64_VERSION;
+        appendLittleEndian<uint32_t>(centralDirectory, 0x02014B50);
+        appendLittleEndian<uint16_t>(centralDirectory, version);
+        appendLittleEndian<uint16_t>(centralDirectory, version);
+        appendLittleEndian<uint16_t>(centralDirectory, ZIP_UTF8_FLAG);
+        appendLittleEndian<uint16_t>(centralDirectory, 0);
+        appendLittleEndian<uint16_t>(centralDirectory, 0);
+        appendLittleEndian<uint16_t>(centralDirectory, ZIP_DATE);
+        appendLittleEndian<uint32_t>(centralDirectory, entry.crc32);
+        appendLittleEndian<uint32_t>(centralDirectory, byteLength);
+        appendLittleEndian<uint32_t>(centralDirectory, byteLength);
+        appendLittleEndian<uint16_t>(centralDirectory, static_cast<uint16_t>(entry.name.size()));
+        appendLittleEndian<uint16_t>(centralDirectory,
+                                     static_cast<uint16_t>(zip64Extra.empty() ? 0 : 4 + zip64Extra.size()));
+        appendLittleEndian<uint16_t>(centralDirectory, 0);
+        appendLittleEndian<uint16_t>(centralDirectory, 0);
+        appendLittleEndian<uint16_t>(centralDirectory, 0);
+        appendLittleEndian<uint32_t>(centralDirectory, 0);
+        appendLittleEndian<uint32_t>(centralDirectory, offset);
+        centralDirectory += entry.name;
+        if (!zip64Extra.empty()) {
+            appendLittleEndian<uint16_t>(centralDirectory, 0x0001);
+            appendLittleEndian<uint16_t>(centralDirectory, static_cast<uint16_t>(zip64Extra.size()));
+            centralDirectory += zip64Extra;
+        }
+    }
+
+    uint64_t centralDirectoryByteLength = centralDirectory.size();
+    uint64_t entryCount = m_entries.size();
+    bool isZip64 = entryCount >= std::numeric_limits<uint16_t>::max()
+                   || centralDirectoryOffset >= ZIP_MAX_UINT32
+                   || centralDirectoryByteLength >= ZIP_MAX_UINT32;
+    if (isZip64) {
+        uint64_t zip64EndOfCentralDirectoryOffset = centralDirectoryOffset + centralDirectoryByteLength;
+        appendLittleEndian<uint32_t>(centralDirectory, 0x06064B50);
+        appendLittleEndian<uint64_t>(centralDirectory, 44);
+        appendLittleEndian<uint16_t>(centralDirectory, ZIP64_VERSION);
+        appendLittleEndian<uint16_t>(centralDirectory, ZIP64_VERSION);
+        appendLittleEndian<uint32_t>(centralDirectory, 0);
+        appendLittleEndian<uint32_t>(centralDirectory, 0);
+        appendLittleEndian<uint64_t>(centralDirectory, entryCount);
+        appendLittleEndian<uint64_t>(centralDirectory, entryCount);
+        appendLittleEndian<uint64_t>(centralDirectory, centralDirectoryByteLength);
+        appendLittleEndian<uint64_t>(centralDirectory, centralDirectoryOffset);
+
+        appendLittleEndian<uint32_t>(centralDirectory, 0x07064B50);
+        appendLittleEndian<uint32_t>(centralDirectory, 0);
+        appendLittleEndian<uint64_t>(centralDirectory, zip64EndOfCentralDirectoryOffset);
+        appendLittleEndian<uint32_t>(centralDirectory, 1);
+    }
+
+    // the zip64 records hold the real values, the end of central directory only points to them
+    uint16_t shortEntryCount = isZip64 ? std::numeric_limits<uint16_t>::max()
+                                       : static_cast<uint16_t>(entryCount);
+    uint32_t shortByteLength = static_cast<uint32_t>(centralDirectoryByteLength);
+    uint32_t shortOffset = static_cast<uint32_t>(centralDirectoryOffset);
+    appendLittleEndian<uint32_t>(centralDirectory, 0x06054B50);
+    appendLittleEndian<uint16_t>(centralDirectory, 0);
+    appendLittleEndian<uint16_t>(centralDirectory, 0);
+    appendLittleEndian<uint16_t>(centralDirectory, shortEntryCount);
+    appendLittleEndian<uint16_t>(centralDirectory, shortEntryCount);
+    appendLittleEndian<uint32_t>(centralDirectory, isZip64 ? ZIP_MAX_UINT32 : shortByteLength);
+    appendLittleEndian<uint32_t>(centralDirectory, isZip64 ? ZIP_MAX_UINT32 : shortOffset);
+    appendLittleEndian<uint16_t>(centralDirectory, 0);
+
+    m_archive.write(centralDirectory.data(), static_cast<std::streamsize>(centralDirectory.size()));
+    m_archive.close();
+    if (!m_archive) {
+        throw std::runtime_error("Failed to write " + m_archivePath.string());
+    }
+}
+
+void MemoryOutputSink::write(const std::filesystem::path &path, const char *data, size_t byteLength)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_files[path].assign(data, byteLength);
+}
+
+const std::string *MemoryOutputSink::getFile(const std::filesystem::path &path) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto file = m_files.find(path);
+    if (file == m_files.end()) {
+        return nullptr;
+    }
+
+    return &file->second;
+}
+
+DeduplicatingOutputSink::DeduplicatingOutputSink(OutputSink &outputSink)
+    : m_outputSink{outputSink}
+    , m_duplicateFileCount{0}
+    , m_duplicateByteLength{0}
+{}
+
+void DeduplicatingOutputSink::write(const std::filesystem::path &path, const char *data, size_t byteLength)
+{
+    ContentKey content{computeXXH64(data, byteLength), byteLength};
+    std::string pathKey = path.string();
+    std::optional<std::filesystem::path> duplicatePath;
+    bool isLinked = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto pathContent = m_pathContents.find(pathKey);
+        if (pathContent != m_pathContents.end() && pathContent->second == content) {
+            ++m_duplicateFileCount;
+            m_duplicateByteLength += byteLength;
+            return;
+        }
+
+        auto contentPath = m_contentPaths.find(content);
+        if (contentPath != m_contentPaths.end() && contentPath->second != path) {
+            duplicatePath = contentPath->second;
+        }
+
+        isLinked = m_linkedPaths.find(pathKey) != m_linkedPaths.end();
+    }
+
+    if (duplicatePath && m_outputSink.isFileSystem()
+        && linkToDuplicate(path, *duplicatePath, data, byteLength)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pathContents[pathKey] = content;
+        m_linkedPaths.insert(pathKey);
+        m_linkedPaths.insert(duplicatePath->string());
+        ++m_duplicateFileCount;
+        m_duplicateByteLength += byteLength;
+        return;
+    }
+
+    // a linked file shares its bytes with other files, so it is replaced instead of written in place
+    if (isLinked) {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    m_outputSink.write(path, data, byteLength);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pathContents[pathKey] = content;
+    m_contentPaths.emplace(content, path);
+}
+
+void DeduplicatingOutputSink::createDirectories(const std::filesystem::path &path)
+{
+    m_outputSink.createDirectories(path);
+}
+
+void DeduplicatingOutputSink::finish()
+{
+    m_outputSink.finish();
+}
+
+bool DeduplicatingOutputSink::linkToDuplicate(const std::filesystem::path &path,
+                                              const std::filesystem::path &duplicatePath,
+                                              const char *data,
+                                              size_t byteLength)
+{
+    // the duplicate may have been rewritten with other bytes since, and a hash can collide
+    std::ifstream fs(duplicatePath, std::ios::binary);
+    std::string duplicate(byteLength, '\0');
+    if (!fs.read(duplicate.data(), static_cast<std::streamsize>(byteLength)) || fs.peek() != EOF
+        || std::memcmp(duplicate.data(), data, byteLength) != 0) {
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::filesystem::create_hard_link(duplicatePath, path, error);
+    return !error;
+}
+
+uint64_t DeduplicatingOutputSink::computeXXH64(const char *data, size_t byteLength, uint64_t seed)
+{
+    static const uint64_t PRIME_1 = 11400714785074694791ULL;
+    static const uint64_t PRIME_2 = 14029467366897019727ULL;
+    static const uint64_t PRIME_3 = 1609587929392839161ULL;
+    static const uint64_t PRIME_4 = 9650029242287828579ULL;
+    static const uint64_t PRIME_5 = 2870177450012600261ULL;
+
+    auto rotateLeft = [](uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); };
+    auto round = [&](uint64_t accumulator, uint64_t input) {
+        return rotateLeft(accumulator + input * PRIME_2, 31) * PRIME_1;
+    };
+    auto mergeRound = [&](uint64_t accumulator, uint64_t value) {
+        return (accumulator ^ round(0, value)) * PRIME_1 + PRIME_4;
+    };
+    auto read64 = [](const uint8_t *bytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+        }
+
+        return value;
+    };
+    auto read32 = [](const uint8_t *bytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+        }
+
+        return value;
+    };
+
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+    const uint8_t *end = bytes + byteLength;
+    uint64_t hash;
+    if (byteLength >= 32) {
+        uint64_t v1 = seed + PRIME_1 + PRIME_2;
+        uint64_t v2 = seed + PRIME_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME_1;
+        for (; end - bytes >= 32; bytes += 32) {
+            v1 = round(v1, read64(bytes));
+            v2 = round(v2, read64(bytes + 8));
+            v3 = round(v3, read64(bytes + 16));
+            v4 = round(v4, read64(bytes + 24));
+        }
+
+        hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = seed + PRIME_5;
+    }
+
+    hash += static_cast<uint64_t>(byteLength);
+    for (; end - bytes >= 8; bytes += 8) {
+        hash = rotateLeft(hash ^ round(0, read64(bytes)), 27) * PRIME_1 + PRIME_4;
+    }
+
+    if (end - bytes >= 4) {
+        hash = rotateLeft(hash ^ (read32(bytes) * PRIME_1), 23) * PRIME_2 + PRIME_3;
+        bytes += 4;
+    }
+
+    for (; bytes < end; ++bytes) {
+        hash = rotateLeft(hash ^ (static_cast<uint64_t>(*bytes) * PRIME_5), 11) * PRIME_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+NullOutputSink::NullOutputSink()
+    : m_fileCount{0}
+    , m_byteLength{0}
+{}
+
+void NullOutputSink::write(const std::filesystem::path &, const char *, size_t byteLength)
+{
+    ++m_fileCount;
+    m_byteLength += byteLength;
+}
+
+} // namespace CDBTo3DTiles
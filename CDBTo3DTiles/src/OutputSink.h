@@ -0,0 +1,160 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace CDBTo3DTiles {
+// Destination of every converted file. A write always contains a whole file, and can be called from
+// several threads at the same time
+class OutputSink
+{
+public:
+    virtual ~OutputSink() noexcept = default;
+
+    virtual void write(const std::filesystem::path &path, const char *data, size_t byteLength) = 0;
+
+    virtual void createDirectories(const std::filesystem::path &path);
+
+    // writers that can only write to a file path, like GDAL or osgDB, skip the in memory copy when the
+    // output goes to the file system anyway
+    virtual bool isFileSystem() const noexcept;
+
+    virtual void finish();
+};
+
+class FileSystemOutputSink : public OutputSink
+{
+public:
+    void write(const std::filesystem::path &path, const char *data, size_t byteLength) override;
+
+    void createDirectories(const std::filesystem::path &path) override;
+
+    bool isFileSystem() const noexcept override;
+
+    static FileSystemOutputSink &getInstance();
+};
+
+// Writes every file into one 3D Tiles archive (3TZ). That is an uncompressed zip, with zip64 records once it
+// grows past the zip limits, and a hashed index of the files as the last entry so readers can locate a tile
+// without parsing the central directory. Files are appended as they are written
+class ArchiveOutputSink : public OutputSink
+{
+public:
+    ArchiveOutputSink(const std::filesystem::path &archivePath, const std::filesystem::path &rootPath);
+
+    ArchiveOutputSink(const ArchiveOutputSink &) = delete;
+
+    ArchiveOutputSink &operator=(const ArchiveOutputSink &) = delete;
+
+    ~ArchiveOutputSink() noexcept;
+
+    void write(const std::filesystem::path &path, const char *data, size_t byteLength) override;
+
+    void finish() override;
+
+    static const std::string INDEX_NAME;
+
+private:
+    struct Entry
+    {
+        std::string name;
+        std::array<uint8_t, 16> hash;
+        uint32_t crc32;
+        uint64_t byteLength;
+        uint64_t offset;
+    };
+
+    void appendFile(Entry &entry, const char *data);
+
+    void writeIndex();
+
+    void writeCentralDirectory();
+
+    std::filesystem::path m_archivePath;
+    std::filesystem::path m_rootPath;
+    std::ofstream m_archive;
+    uint64_t m_offset;
+    std::vector<Entry> m_entries;
+    std::unordered_map<std::string, size_t> m_entryIndices;
+    bool m_isFinished;
+    std::mutex m_mutex;
+};
+
+class MemoryOutputSink : public OutputSink
+{
+public:
+    void write(const std::filesystem::path &path, const char *data, size_t byteLength) override;
+
+    const std::string *getFile(const std::filesystem::path &path) const;
+
+    inline const std::map<std::filesystem::path, std::string> &getFiles() const noexcept { return m_files; }
+
+private:
+    std::map<std::filesystem::path, std::string> m_files;
+    mutable std::mutex m_mutex;
+};
+
+// Writes each distinct content once. A file with the same bytes as an earlier file is hard linked to it
+// when the output goes to the file system, and a file rewritten with the bytes it already has is skipped.
+// Contents are matched by their XXH64 hash and compared byte by byte before they are linked. It needs the
+// bytes of every file, so it doesn't report itself as a file system sink even when the wrapped sink is one
+class DeduplicatingOutputSink : public OutputSink
+{
+public:
+    explicit DeduplicatingOutputSink(OutputSink &outputSink);
+
+    void write(const std::filesystem::path &path, const char *data, size_t byteLength) override;
+
+    void createDirectories(const std::filesystem::path &path) override;
+
+    void finish() override;
+
+    inline size_t getDuplicateFileCount() const noexcept { return m_duplicateFileCount; }
+
+    inline uint64_t getDuplicateByteLength() const noexcept { return m_duplicateByteLength; }
+
+    static uint64_t computeXXH64(const char *data, size_t byteLength, uint64_t seed = 0);
+
+private:
+    // hash and byte length of a content
+    using ContentKey = std::pair<uint64_t, uint64_t>;
+
+    bool linkToDuplicate(const std::filesystem::path &path,
+                         const std::filesystem::path &duplicatePath,
+                         const char *data,
+                         size_t byteLength);
+
+    OutputSink &m_outputSink;
+    std::map<ContentKey, std::filesystem::path> m_contentPaths;
+    std::unordered_map<std::string, ContentKey> m_pathContents;
+    std::unordered_set<std::string> m_linkedPaths;
+    std::atomic<size_t> m_duplicateFileCount;
+    std::atomic<uint64_t> m_duplicateByteLength;
+    std::mutex m_mutex;
+};
+
+class NullOutputSink : public OutputSink
+{
+public:
+    NullOutputSink();
+
+    void write(const std::filesystem::path &path, const char *data, size_t byteLength) override;
+
+    inline size_t getFileCount() const noexcept { return m_fileCount; }
+
+    inline uint64_t getByteLength() const noexcept { return m_byteLength; }
+
+private:
+    std::atomic<size_t> m_fileCount;
+    std::atomic<uint64_t> m_byteLength;
+};
+} // namespace CDBTo3DTiles
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace CDBTo3DTiles {
+template<typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity)
+        : m_capacity{capacity > 0 ? capacity : 1}
+        , m_closed{false}
+    {}
+
+    BoundedQueue(const BoundedQueue &) = delete;
+
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    inline size_t getCapacity() const noexcept { return m_capacity; }
+
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) {
+            return false;
+        }
+
+        m_items.emplace_back(std::move(item));
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+        if (m_items.empty()) {
+            return std::nullopt;
+        }
+
+        std::optional<T> item = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_notFull.notify_one();
+        return item;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+private:
+    size_t m_capacity;
+    bool m_closed;
+    std::deque<T> m_items;
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+};
+
+template<typename T>
+class PipelineStage
+{
+public:
+    PipelineStage(BoundedQueue<T> &input, size_t threadCount, std::function<void(T &)> process)
+        : m_input{input}
+        , m_process{std::move(process)}
+    {
+        threadCount = threadCount > 0 ? threadCount : 1;
+        m_threads.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i) {
+            m_threads.emplace_back([this]() { processLoop(); });
+        }
+    }
+
+    PipelineStage(const PipelineStage &) = delete;
+
+    PipelineStage &operator=(const PipelineStage &) = delete;
+
+    ~PipelineStage() noexcept { finishThreads(); }
+
+    void finish()
+    {
+        finishThreads();
+        if (m_exception) {
+            std::rethrow_exception(std::exchange(m_exception, nullptr));
+        }
+    }
+
+private:
+    void finishThreads() noexcept
+    {
+        m_input.close();
+        for (auto &thread : m_threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    void processLoop()
+    {
+        // keep draining after a failure so the upstream stage never blocks on a full queue
+        while (auto item = m_input.pop()) {
+            try {
+                m_process(*item);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(m_exceptionMutex);
+                if (!m_exception) {
+                    m_exception = std::current_exception();
+                }
+            }
+        }
+    }
+
+    BoundedQueue<T> &m_input;
+    std::function<void(T &)> m_process;
+    std::vector<std::thread> m_threads;
+    std::exception_ptr m_exception;
+    std::mutex m_exceptionMutex;
+};
+} // namespace CDBTo3DTiles
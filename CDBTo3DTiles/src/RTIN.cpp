@@ -0,0 +1,189 @@
+#include "RTIN.h"
+#include <stdexcept>
+
+namespace CDBTo3DTiles {
+
+static bool isPowerOfTwo(size_t value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+template<typename Visit>
+bool RTIN::visitTriangle(glm::uvec2 a, glm::uvec2 b, glm::uvec2 c, float maxError, Visit &visit) const
+{
+    // a and b are the ends of the hypotenuse and c is the right angle. The smallest triangles have no
+    // midpoint left to split them at
+    glm::uvec2 midpoint((a.x + b.x) / 2, (a.y + b.y) / 2);
+    glm::ivec2 leg = glm::ivec2(a) - glm::ivec2(c);
+    if (glm::abs(leg.x) + glm::abs(leg.y) > 1 && getError(midpoint.x, midpoint.y) > maxError) {
+        return visitTriangle(c, a, midpoint, maxError, visit)
+               && visitTriangle(b, c, midpoint, maxError, visit);
+    }
+
+    return visit(a, b, c);
+}
+
+template<typename Visit>
+void RTIN::forEachTriangle(const ElevationView &view, float maxError, Visit visit) const
+{
+    // the cells of a level are split along alternating diagonals, starting with the north west to south east
+    // diagonal of the whole grid
+    glm::uvec2 origin = view.getOrigin();
+    glm::uvec2 extent = view.getExtent();
+    glm::uvec2 topLeft = origin;
+    glm::uvec2 topRight = origin + glm::uvec2(extent.x, 0);
+    glm::uvec2 bottomLeft = origin + glm::uvec2(0, extent.y);
+    glm::uvec2 bottomRight = origin + extent;
+    bool isMainDiagonal = (origin.x / extent.x + origin.y / extent.y) % 2 == 0;
+    if (isMainDiagonal) {
+        if (visitTriangle(topLeft, bottomRight, topRight, maxError, visit)) {
+            visitTriangle(bottomRight, topLeft, bottomLeft, maxError, visit);
+        }
+    } else {
+        if (visitTriangle(bottomLeft, topRight, topLeft, maxError, visit)) {
+            visitTriangle(topRight, bottomLeft, bottomRight, maxError, visit);
+        }
+    }
+}
+
+RTIN::RTIN(const ElevationView &view)
+    : m_size{view.getGridWidth()}
+{
+    if (!isSupported(view)) {
+        throw std::runtime_error("RTIN needs a square grid of 2^n pixels");
+    }
+
+    m_errors.resize((m_size + 1) * (m_size + 1), 0.0f);
+    auto getInterpolationError = [&](size_t x, size_t y, size_t ax, size_t ay, size_t bx, size_t by) {
+        float interpolatedHeight = (view.getHeight(ax, ay) + view.getHeight(bx, by)) * 0.5f;
+        return glm::abs(interpolatedHeight - view.getHeight(x, y));
+    };
+
+    // levels go from the smallest triangles up, so the error of a midpoint includes the errors of the
+    // midpoints below it on both sides of its hypotenuse
+    for (size_t cellSize = 2; cellSize <= m_size; cellSize *= 2) {
+        size_t half = cellSize / 2;
+        size_t quarter = cellSize / 4;
+
+        // triangles whose hypotenuse is an edge of a cell
+        for (size_t y = 0; y <= m_size; y += half) {
+            bool isHorizontalEdge = y % cellSize == 0;
+            for (size_t x = isHorizontalEdge ? half : 0; x <= m_size; x += cellSize) {
+                float error = isHorizontalEdge ? getInterpolationError(x, y, x - half, y, x + half, y)
+                                               : getInterpolationError(x, y, x, y - half, x, y + half);
+                if (quarter > 0) {
+                    for (size_t childY : {y - quarter, y + quarter}) {
+                        for (size_t childX : {x - quarter, x + quarter}) {
+                            if (childX <= m_size && childY <= m_size) {
+                                error = glm::max(error, getError(childX, childY));
+                            }
+                        }
+                    }
+                }
+
+                updateError(glm::uvec2(x, y), error);
+            }
+        }
+
+        // triangles whose hypotenuse is a diagonal of a cell
+        size_t cellCount = m_size / cellSize;
+        for (size_t j = 0; j < cellCount; ++j) {
+            for (size_t i = 0; i < cellCount; ++i) {
+                size_t x = i * cellSize + half;
+                size_t y = j * cellSize + half;
+                float error = (i + j) % 2 == 0
+                                  ? getInterpolationError(x, y, x - half, y - half, x + half, y + half)
+                                  : getInterpolationError(x, y, x + half, y - half, x - half, y + half);
+                error = glm::max(error, getError(x - half, y));
+                error = glm::max(error, getError(x + half, y));
+                error = glm::max(error, getError(x, y - half));
+                error = glm::max(error, getError(x, y + half));
+                updateError(glm::uvec2(x, y), error);
+            }
+        }
+    }
+}
+
+bool RTIN::isSupported(const ElevationView &view)
+{
+    return view.getOrigin() == glm::uvec2(0) && view.getGridWidth() == view.getGridHeight()
+           && view.getStride() == view.getVerticesWidth() && isPowerOfTwo(view.getGridWidth());
+}
+
+bool RTIN::isCovering(const ElevationView &view) const
+{
+    glm::uvec2 origin = view.getOrigin();
+    glm::uvec2 extent = view.getExtent();
+    return view.getStride() == m_size + 1 && extent.x == extent.y && isPowerOfTwo(extent.x)
+           && origin.x % extent.x == 0 && origin.y % extent.y == 0 && origin.x + extent.x <= m_size
+           && origin.y + extent.y <= m_size;
+}
+
+std::vector<uint32_t> RTIN::createIndices(const ElevationView &view, float maxError) const
+{
+    std::vector<uint32_t> indices;
+    glm::uvec2 origin = view.getOrigin();
+    size_t verticesWidth = view.getVerticesWidth();
+    auto toIndex = [&](glm::uvec2 vertex) {
+        return static_cast<uint32_t>((vertex.y - origin.y) * verticesWidth + vertex.x - origin.x);
+    };
+
+    forEachTriangle(view, maxError, [&](glm::uvec2 a, glm::uvec2 b, glm::uvec2 c) {
+        indices.emplace_back(toIndex(a));
+        indices.emplace_back(toIndex(b));
+        indices.emplace_back(toIndex(c));
+        return true;
+    });
+
+    return indices;
+}
+
+std::vector<uint32_t> RTIN::simplify(const ElevationView &view,
+                                     size_t targetIndexCount,
+                                     float targetError) const
+{
+    // the error map holds height errors in meters, so the relative target error is scaled by the width of
+    // the view in meters
+    glm::dvec3 topLeft = view.getPosition(0, 0);
+    double width = glm::length(view.getPosition(view.getGridWidth(), 0) - topLeft);
+    double height = glm::length(view.getPosition(0, view.getGridHeight()) - topLeft);
+    float maxError = static_cast<float>(static_cast<double>(targetError) * glm::max(width, height));
+    if (countIndices(view, maxError, targetIndexCount) > targetIndexCount) {
+        return createIndices(view, maxError);
+    }
+
+    // the index count only goes down as the error goes up, so search for the smallest error that is
+    // within the target index count
+    float lowError = 0.0f;
+    float highError = maxError;
+    for (int i = 0; i < 16; ++i) {
+        float error = (lowError + highError) * 0.5f;
+        if (countIndices(view, error, targetIndexCount) > targetIndexCount) {
+            lowError = error;
+        } else {
+            highError = error;
+        }
+    }
+
+    return createIndices(view, highError);
+}
+
+size_t RTIN::countIndices(const ElevationView &view, float maxError, size_t maxIndexCount) const
+{
+    // stops as soon as the count goes over, so the too detailed errors of the search are cheap
+    size_t indexCount = 0;
+    forEachTriangle(view, maxError, [&](glm::uvec2, glm::uvec2, glm::uvec2) {
+        indexCount += 3;
+        return indexCount <= maxIndexCount;
+    });
+
+    return indexCount;
+}
+
+void RTIN::updateError(glm::uvec2 midpoint, float error)
+{
+    float &currentError = m_errors[midpoint.y * (m_size + 1) + midpoint.x];
+    currentError = glm::max(currentError, error);
+}
+
+} // namespace CDBTo3DTiles
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ElevationView.h"
+#include "glm/glm.hpp"
+#include <vector>
+
+namespace CDBTo3DTiles {
+// Right-triangulated irregular network of a square elevation grid of 2^n pixels. The grid is recursively
+// split into right triangles along the midpoints of their hypotenuses, and the error map holds for each
+// midpoint the largest height error of leaving it out, including every midpoint below it. Triangles at any
+// error threshold are then extracted without looking at the heights again, and without cracks between them
+class RTIN
+{
+public:
+    // the view has to start at the origin of its grid and cover 2^n x 2^n pixels
+    explicit RTIN(const ElevationView &view);
+
+    static bool isSupported(const ElevationView &view);
+
+    // the error map also serves a quadrant, or a quadrant of a quadrant, of the view it was built for
+    bool isCovering(const ElevationView &view) const;
+
+    inline float getError(size_t x, size_t y) const noexcept { return m_errors[y * (m_size + 1) + x]; }
+
+    // triangles of the view whose height error is at most maxError, as vertex indices of the view
+    std::vector<uint32_t> createIndices(const ElevationView &view, float maxError) const;
+
+    // the most detailed triangles of the view that have at most targetIndexCount indices, without going
+    // over targetError. Like meshopt_simplify, targetError is relative to the extents of the view
+    std::vector<uint32_t> simplify(const ElevationView &view,
+                                   size_t targetIndexCount,
+                                   float targetError) const;
+
+private:
+    template<typename Visit>
+    void forEachTriangle(const ElevationView &view, float maxError, Visit visit) const;
+
+    template<typename Visit>
+    bool visitTriangle(glm::uvec2 a, glm::uvec2 b, glm::uvec2 c, float maxError, Visit &visit) const;
+
+    size_t countIndices(const ElevationView &view, float maxError, size_t maxIndexCount) const;
+
+    void updateError(glm::uvec2 midpoint, float error);
+
+    std::vector<float> m_errors;
+    size_t m_size;
+};
+} // namespace CDBTo3DTiles
@@ -39,6 +39,12 @@ void AABB::merge(const glm::dvec3 &point)
     max = glm::max(point, max);
 }
 
+void AABB::merge(const AABB &aabb)
+{
+    min = glm::min(aabb.min, min);
+    max = glm::max(aabb.max, max);
+}
+
 Texture::Texture()
     : minFilter{TextureFilter::LINEAR_MIPMAP_LINEAR}
     , magFilter{TextureFilter::LINEAR}
@@ -17,6 +17,8 @@ struct AABB
 
     void merge(const glm::dvec3 &point);
 
+    void merge(const AABB &aabb);
+
     glm::dvec3 min;
     glm::dvec3 max;
 };
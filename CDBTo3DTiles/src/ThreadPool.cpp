@@ -0,0 +1,228 @@
+#include "ThreadPool.h"
+
+namespace CDBTo3DTiles {
+
+static thread_local const ThreadPool *currentPool = nullptr;
+static thread_local size_t currentQueueIndex = 0;
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : m_queuedTaskCount{0}
+    , m_stop{false}
+{
+    // one queue per worker, plus one for tasks enqueued by threads outside of the pool
+    m_queues.reserve(threadCount + 1);
+    for (size_t i = 0; i < threadCount + 1; ++i) {
+        m_queues.emplace_back(std::make_unique<WorkQueue>());
+    }
+
+    m_threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_condition.notify_all();
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_queuedTaskCount;
+    }
+
+    auto &queue = *m_queues[getCurrentQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.emplace_back(std::move(task));
+    }
+
+    m_condition.notify_one();
+}
+
+size_t ThreadPool::getCurrentQueueIndex() const noexcept
+{
+    if (currentPool == this) {
+        return currentQueueIndex;
+    }
+
+    return m_queues.size() - 1;
+}
+
+bool ThreadPool::popTask(size_t queueIndex, std::function<void()> &task)
+{
+    // take the newest task of our own queue first, so nested tasks are finished depth first
+    {
+        auto &queue = *m_queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            --m_queuedTaskCount;
+            return true;
+        }
+    }
+
+    // otherwise steal the oldest task of another queue
+    for (size_t i = 1; i < m_queues.size(); ++i) {
+        auto &queue = *m_queues[(queueIndex + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            --m_queuedTaskCount;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t queueIndex)
+{
+    currentPool = this;
+    currentQueueIndex = queueIndex;
+
+    while (true) {
+        std::function<void()> task;
+        if (popTask(queueIndex, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return m_stop || m_queuedTaskCount > 0; });
+        if (m_stop && m_queuedTaskCount == 0) {
+            return;
+        }
+    }
+}
+
+TaskGroup::TaskGroup(ThreadPool *pool)
+    : m_pool{pool}
+    , m_state{std::make_shared<State>()}
+{}
+
+TaskGroup::~TaskGroup() noexcept
+{
+    // tasks may still reference the caller's stack, so never leave them running
+    waitForPendingTasks(0);
+}
+
+void TaskGroup::run(std::function<void()> task)
+{
+    // without a pool, behave exactly like the serial code path
+    if (m_pool == nullptr) {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        ++m_state->pending;
+        m_state->tasks.emplace_back(std::move(task));
+    }
+
+    m_state->changed.notify_all();
+
+    // the handle finds nothing to do when a waiting thread already ran the task, so it holds on to the
+    // state rather than the group
+    m_pool->enqueue([state = m_state]() { runQueuedTask(*state, false); });
+}
+
+void TaskGroup::limitPendingTasks(size_t maxPendingTasks)
+{
+    waitForPendingTasks(maxPendingTasks);
+}
+
+void TaskGroup::wait()
+{
+    waitForPendingTasks(0);
+
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        std::swap(exception, m_state->exception);
+    }
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+bool TaskGroup::runQueuedTask(State &state, bool newest)
+{
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.tasks.empty()) {
+            return false;
+        }
+
+        if (newest) {
+            task = std::move(state.tasks.back());
+            state.tasks.pop_back();
+        } else {
+            task = std::move(state.tasks.front());
+            state.tasks.pop_front();
+        }
+    }
+
+    std::exception_ptr exception;
+    try {
+        task();
+    } catch (...) {
+        exception = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (exception && !state.exception) {
+            state.exception = exception;
+        }
+
+        --state.pending;
+    }
+
+    state.changed.notify_all();
+    return true;
+}
+
+void TaskGroup::waitForPendingTasks(size_t maxPendingTasks)
+{
+    if (m_pool == nullptr) {
+        return;
+    }
+
+    auto &state = *m_state;
+    while (true) {
+        {
+            // wake up when a task finishes or is queued. Tasks of the group that are running elsewhere can
+            // only be waited for
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.changed.wait(lock, [&state, maxPendingTasks]() {
+                return state.pending <= maxPendingTasks || !state.tasks.empty();
+            });
+
+            if (state.pending <= maxPendingTasks) {
+                return;
+            }
+        }
+
+        // help with the newest task of this group instead of blocking, so nested groups finish depth first
+        // and can't starve the pool
+        runQueuedTask(state, true);
+    }
+}
+
+} // namespace CDBTo3DTiles
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CDBTo3DTiles {
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threadCount);
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool() noexcept;
+
+    inline size_t getThreadCount() const noexcept { return m_threads.size(); }
+
+    void enqueue(std::function<void()> task);
+
+private:
+    struct WorkQueue
+    {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    size_t getCurrentQueueIndex() const noexcept;
+
+    bool popTask(size_t queueIndex, std::function<void()> &task);
+
+    void workerLoop(size_t queueIndex);
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_queuedTaskCount;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop;
+};
+
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool *pool);
+
+    TaskGroup(const TaskGroup &) = delete;
+
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    ~TaskGroup() noexcept;
+
+    void run(std::function<void()> task);
+
+    void limitPendingTasks(size_t maxPendingTasks);
+
+    void wait();
+
+private:
+    // tasks of the group that haven't started yet. The pool only gets a handle to run the oldest of them, so
+    // a waiting thread can run the group's own tasks without picking up unrelated work
+    struct State
+    {
+        std::deque<std::function<void()>> tasks;
+        size_t pending{0};
+        std::exception_ptr exception;
+        std::mutex mutex;
+        std::condition_variable changed;
+    };
+
+    static bool runQueuedTask(State &state, bool newest);
+
+    void waitForPendingTasks(size_t maxPendingTasks);
+
+    ThreadPool *m_pool;
+    std::shared_ptr<State> m_state;
+};
+} // namespace CDBTo3DTiles
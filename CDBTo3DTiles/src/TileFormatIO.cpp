@@ -27,11 +27,23 @@ static void convertTilesetToJson(const CDBTile &tile,
                                  bool use3dTilesNext = false,
                                  int subtreeLevels = 7,
                                  int maxLevel = 0,
-                                 std::map<int, std::vector<std::string>> urisAtEachLevel = {});
+                                 std::map<int, std::vector<std::string>> urisAtEachLevel = {},
+                                 TileLayout layout = TileLayout::Flat);
+
+std::filesystem::path getTileContentDirectory(TileLayout layout, int level, int UREF)
+{
+    if (layout == TileLayout::Flat) {
+        return std::filesystem::path();
+    }
+
+    // the level isn't zero padded, so implicit tiling templates can match the directories
+    std::string levelDirectory = level < 0 ? "LC" + std::to_string(-level) : "L" + std::to_string(level);
+    return std::filesystem::path(levelDirectory) / ("U" + std::to_string(UREF));
+}
 
 void combineTilesetJson(const std::vector<std::filesystem::path> &tilesetJsonPaths,
                         const std::vector<Core::BoundingRegion> &regions,
-                        std::ofstream &fs,
+                        std::ostream &fs,
                         bool use3dTilesNext)
 {
     nlohmann::json tilesetJson;
@@ -87,11 +99,12 @@ void combineTilesetJson(const std::vector<std::filesystem::path> &tilesetJsonPat
 
 void writeToTilesetJson(const CDBTileset &tileset,
                         bool replace,
-                        std::ofstream &fs,
+                        std::ostream &fs,
                         bool use3dTilesNext,
                         int subtreeLevels,
                         int maxLevel,
-                        std::map<int, std::vector<std::string>> urisAtEachLevel)
+                        std::map<int, std::vector<std::string>> urisAtEachLevel,
+                        TileLayout layout)
 {
     nlohmann::json tilesetJson;
     tilesetJson["asset"] = {{"version", "1.0"}};
@@ -115,12 +128,35 @@ void writeToTilesetJson(const CDBTileset &tileset,
                              use3dTilesNext,
                              subtreeLevels,
                              maxLevel,
-                             urisAtEachLevel);
+                             urisAtEachLevel,
+                             layout);
         tilesetJson["geometricError"] = tilesetJson["root"]["geometricError"];
         fs << tilesetJson << std::endl;
     }
 }
 
+static std::vector<glm::dvec3> convertInstancePositions(
+    const Core::Ellipsoid &ellipsoid,
+    const std::vector<Core::Cartographic> &cartographicPositions,
+    const std::vector<int> &attribIndices)
+{
+    std::vector<double> longitudes, latitudes, heights;
+    longitudes.reserve(attribIndices.size());
+    latitudes.reserve(attribIndices.size());
+    heights.reserve(attribIndices.size());
+    for (int instanceIndex : attribIndices) {
+        const auto &cartographic = cartographicPositions[static_cast<size_t>(instanceIndex)];
+        longitudes.emplace_back(cartographic.longitude);
+        latitudes.emplace_back(cartographic.latitude);
+        heights.emplace_back(cartographic.height);
+    }
+
+    std::vector<glm::dvec3> positions(attribIndices.size());
+    ellipsoid.cartographicToCartesian(
+        longitudes.data(), latitudes.data(), heights.data(), positions.size(), positions.data());
+    return positions;
+}
+
 void createInstancingExtension(tinygltf::Model *gltf,
                                const CDBModelsAttributes &modelsAttribs,
                                const std::vector<int> &attribIndices)
@@ -188,9 +224,10 @@ void createInstancingExtension(tinygltf::Model *gltf,
     bufferData.resize(bufferSize);
 
     // Iterate through instances.
+    auto positionsCartesian = convertInstancePositions(ellipsoid, cartographicPositions, attribIndices);
     for (size_t i = 0; i < totalInstances; ++i) {
         int instanceIndex = attribIndices[i];
-        glm::dvec3 positionCartesian = ellipsoid.cartographicToCartesian(cartographicPositions[instanceIndex]);
+        const glm::dvec3 &positionCartesian = positionsCartesian[i];
         glm::fvec3 rtcPositionCartesian = glm::fvec3(positionCartesian - tileCenterCartesian);
 
         glm::fmat4 tMatrix = glm::translate(glm::mat4(1.0f), rtcPositionCartesian);
@@ -256,7 +293,7 @@ void createInstancingExtension(tinygltf::Model *gltf,
 size_t writeToI3DM(std::string GltfURI,
                    const CDBModelsAttributes &modelsAttribs,
                    const std::vector<int> &attribIndices,
-                   std::ofstream &fs)
+                   std::ostream &fs)
 {
     const auto &cdbTile = modelsAttribs.getTile();
     const auto &instancesAttribs = modelsAttribs.getInstancesAttributes();
@@ -290,9 +327,10 @@ size_t writeToI3DM(std::string GltfURI,
     std::vector<unsigned char> featureTableBuffer;
     featureTableBuffer.resize(
         roundUp(totalPositionSize + totalScaleSize + totalNormalUpSize + totalNormalRightSize, 8));
+    auto worldPositions = convertInstancePositions(ellipsoid, cartographicPositions, attribIndices);
     for (size_t i = 0; i < attribIndices.size(); ++i) {
         size_t instanceIdx = static_cast<size_t>(attribIndices[i]);
-        glm::dvec3 worldPosition = ellipsoid.cartographicToCartesian(cartographicPositions[instanceIdx]);
+        const glm::dvec3 &worldPosition = worldPositions[i];
         glm::vec3 positionRTC = worldPosition - center;
 
         glm::dmat4 rotation = calculateModelOrientation(worldPosition, orientation[instanceIdx]);
@@ -405,18 +443,11 @@ size_t writeToI3DM(std::string GltfURI,
     return header.byteLength;
 }
 
-void writeToB3DM(tinygltf::Model *gltf, const CDBInstancesAttributes *instancesAttribs, std::ofstream &fs)
+void writeToB3DM(tinygltf::Model *gltf, const CDBInstancesAttributes *instancesAttribs, std::ostream &fs)
 {
-    // create glb
-    std::stringstream ss;
-    tinygltf::TinyGLTF gltfIO;
-    gltfIO.WriteGltfSceneToStream(gltf, ss, false, true);
-
-    // put glb into buffer
-    ss.seekp(0, std::ios::end);
-    std::stringstream::pos_type offset = ss.tellp();
-    std::vector<uint8_t> glbBuffer(roundUp(static_cast<size_t>(offset), 8), 0);
-    ss.read(reinterpret_cast<char *>(glbBuffer.data()), static_cast<std::streamsize>(glbBuffer.size()));
+    // create glb. It is written straight to the stream at the end, and padded to 8 bytes
+    GLBWriter glbWriter(gltf, 4);
+    size_t glbByteLength = roundUp(glbWriter.getByteLength(), 8);
 
     // create feature table
     size_t numOfBatchID = 0;
@@ -443,7 +474,7 @@ void writeToB3DM(tinygltf::Model *gltf, const CDBInstancesAttributes *instancesA
                         + static_cast<uint32_t>(featureTableString.size())
                         + static_cast<uint32_t>(batchTableHeader.size())
                         + static_cast<uint32_t>(batchTableBuffer.size())
-                        + static_cast<uint32_t>(glbBuffer.size());
+                        + static_cast<uint32_t>(glbByteLength);
     header.featureTableJsonByteLength = static_cast<uint32_t>(featureTableString.size());
     header.featureTableBinByteLength = 0;
     header.batchTableJsonByteLength = static_cast<uint32_t>(batchTableHeader.size());
@@ -455,10 +486,12 @@ void writeToB3DM(tinygltf::Model *gltf, const CDBInstancesAttributes *instancesA
     fs.write(batchTableHeader.data(), static_cast<std::streamsize>(batchTableHeader.size()));
     fs.write(reinterpret_cast<const char *>(batchTableBuffer.data()), static_cast<std::streamsize>(batchTableBuffer.size()));
 
-    fs.write(reinterpret_cast<const char *>(glbBuffer.data()), static_cast<std::streamsize>(glbBuffer.size()));
+    glbWriter.write(fs);
+    static const char ZEROS[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    fs.write(ZEROS, static_cast<std::streamsize>(glbByteLength - glbWriter.getByteLength()));
 }
 
-void writeToGLTF(tinygltf::Model *gltf, const CDBInstancesAttributes *instancesAttribs, std::ofstream &fs)
+void writeToGLTF(tinygltf::Model *gltf, const CDBInstancesAttributes *instancesAttribs, std::ostream &fs)
 {
     // Add metadata.
     if (instancesAttribs) {
@@ -483,8 +516,8 @@ void writeToGLTF(tinygltf::Model *gltf, const CDBInstancesAttributes *instancesA
 }
 
 void writeToCMPT(uint32_t numOfTiles,
-                 std::ofstream &fs,
-                 std::function<uint32_t(std::ofstream &, size_t tileIdx)> writeToTileFormat)
+                 std::ostream &fs,
+                 std::function<uint32_t(std::ostream &, size_t tileIdx)> writeToTileFormat)
 {
     CmptHeader header;
     header.magic[0] = 'c';
@@ -715,7 +748,8 @@ static void convertTilesetToJson(const CDBTile &tile,
                                  bool use3dTilesNext,
                                  int subtreeLevels,
                                  int maxLevel,
-                                 std::map<int, std::vector<std::string>> urisAtEachLevel)
+                                 std::map<int, std::vector<std::string>> urisAtEachLevel,
+                                 TileLayout layout)
 {
     const auto &boundRegion = tile.getBoundRegion();
     const auto &rectangle = boundRegion.getRectangle();
@@ -751,7 +785,9 @@ static void convertTilesetToJson(const CDBTile &tile,
                 implicitTiling["subtreeLevels"] = subtreeLevels;
                 implicitTiling["subtrees"] = nlohmann::json::object();
                 std::string csKey = std::to_string(tile.getCS_1()) + "_" + std::to_string(tile.getCS_2());
-                implicitTiling["subtrees"]["uri"] = "subtrees/{level}_{x}_{y}.subtree";
+                std::string templateDirectory = layout == TileLayout::Nested ? "L{level}/U{y}/" : "";
+                implicitTiling["subtrees"]["uri"] = "subtrees/" + templateDirectory
+                                                    + "{level}_{x}_{y}.subtree";
 
                 implicitJson["geometricError"] = geometricError / 2.0f;
                 implicitJson["boundingVolume"] = json["boundingVolume"];
@@ -775,7 +811,7 @@ static void convertTilesetToJson(const CDBTile &tile,
                 contentURI.insert(Rposition + 1, "{x}");
                 nlohmann::json content;
                 std::string fileExtension = ".glb";
-                content["uri"] = contentURI + fileExtension;
+                content["uri"] = templateDirectory + contentURI + fileExtension;
                 implicitJson["content"] = content;
                 json["children"].emplace_back(implicitJson);
                 return;
@@ -806,7 +842,8 @@ static void convertTilesetToJson(const CDBTile &tile,
                                  use3dTilesNext,
                                  subtreeLevels,
                                  maxLevel,
-                                 urisAtEachLevel);
+                                 urisAtEachLevel,
+                                 layout);
             json["children"].emplace_back(childJson);
         }
     }
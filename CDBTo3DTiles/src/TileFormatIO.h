@@ -43,31 +43,42 @@ struct CmptHeader
     uint32_t titleLength;
 };
 
+// where the tile content goes in its tileset directory. Flat puts every tile in the tileset directory, nested
+// puts each tile in L{level}/U{UREF} sub directories like the CDB, so no directory grows too large
+enum class TileLayout
+{
+    Flat,
+    Nested
+};
+
+std::filesystem::path getTileContentDirectory(TileLayout layout, int level, int UREF);
+
 void combineTilesetJson(const std::vector<std::filesystem::path> &tilesetJsonPaths,
                         const std::vector<Core::BoundingRegion> &regions,
-                        std::ofstream &fs,
+                        std::ostream &fs,
                         bool use3dTilesNext = false);
 
 void writeToTilesetJson(const CDBTileset &tileset,
                         bool replace,
-                        std::ofstream &fs,
+                        std::ostream &fs,
                         bool use3dTilesNext = false,
                         int subtreeLevels = 7,
                         int maxLevel = 0,
-                        std::map<int, std::vector<std::string>> urisAtEachLevel = {});
+                        std::map<int, std::vector<std::string>> urisAtEachLevel = {},
+                        TileLayout layout = TileLayout::Flat);
 
 size_t writeToI3DM(std::string GltfURI,
                    const CDBModelsAttributes &modelsAttribs,
                    const std::vector<int> &attribIndices,
-                   std::ofstream &fs);
+                   std::ostream &fs);
 
-void writeToB3DM(tinygltf::Model *gltf, const CDBInstancesAttributes *instancesAttribs, std::ofstream &fs);
+void writeToB3DM(tinygltf::Model *gltf, const CDBInstancesAttributes *instancesAttribs, std::ostream &fs);
 
 void writeToCMPT(uint32_t numOfTiles,
-                 std::ofstream &fs,
-                 std::function<uint32_t(std::ofstream &fs, size_t tileIdx)> writeToTileFormat);
+                 std::ostream &fs,
+                 std::function<uint32_t(std::ostream &fs, size_t tileIdx)> writeToTileFormat);
 
-void writeToGLTF(tinygltf::Model *gltf, const CDBInstancesAttributes *instancesAttribs, std::ofstream &fs);
+void writeToGLTF(tinygltf::Model *gltf, const CDBInstancesAttributes *instancesAttribs, std::ostream &fs);
 
 void createInstancingExtension(tinygltf::Model *gltf,
                                const CDBModelsAttributes &modelsAttribs,
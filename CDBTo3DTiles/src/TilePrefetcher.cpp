@@ -0,0 +1,161 @@
+#include "TilePrefetcher.h"
+#include "VirtualFileSystem.h"
+#include <fstream>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace CDBTo3DTiles {
+
+TilePrefetcher::TilePrefetcher(size_t threadCount, size_t tileCount, uintmax_t maxPrefetchedBytes)
+    : m_tileCount{tileCount}
+    , m_maxPrefetchedBytes{maxPrefetchedBytes}
+    , m_pendingBytes{0}
+    , m_stop{false}
+    , m_hitCount{0}
+    , m_missCount{0}
+    , m_prefetchedByteLength{0}
+{
+    threadCount = threadCount > 0 ? threadCount : 1;
+    m_threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this]() { prefetchLoop(); });
+    }
+}
+
+TilePrefetcher::~TilePrefetcher() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_tiles.clear();
+    }
+
+    m_hasTiles.notify_all();
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+}
+
+std::shared_ptr<TilePrefetcher::Tile> TilePrefetcher::prefetch(std::vector<File> files)
+{
+    auto tile = std::make_shared<Tile>();
+    for (const auto &file : files) {
+        tile->byteLength += file.size;
+    }
+
+    tile->files = std::move(files);
+
+    {
+        // the bytes stay in the budget until the tile is read, since that is when the page cache can let
+        // them go again
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pendingBytes > 0 && m_pendingBytes + tile->byteLength > m_maxPrefetchedBytes) {
+            return nullptr;
+        }
+
+        m_pendingBytes += tile->byteLength;
+        m_tiles.emplace_back(tile);
+    }
+
+    m_hasTiles.notify_one();
+    return tile;
+}
+
+void TilePrefetcher::consume(const std::shared_ptr<Tile> &tile)
+{
+    if (tile == nullptr) {
+        ++m_missCount;
+        return;
+    }
+
+    tile->isConsumed = true;
+    if (tile->isWarm) {
+        ++m_hitCount;
+    } else {
+        ++m_missCount;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pendingBytes -= tile->byteLength;
+}
+
+TilePrefetcher::Statistics TilePrefetcher::getStatistics() const
+{
+    Statistics statistics;
+    statistics.hitCount = m_hitCount;
+    statistics.missCount = m_missCount;
+    statistics.prefetchedByteLength = m_prefetchedByteLength;
+    return statistics;
+}
+
+void TilePrefetcher::prefetchLoop()
+{
+    while (true) {
+        std::shared_ptr<Tile> tile;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_hasTiles.wait(lock, [this]() { return m_stop || !m_tiles.empty(); });
+            if (m_tiles.empty()) {
+                return;
+            }
+
+            tile = std::move(m_tiles.front());
+            m_tiles.pop_front();
+        }
+
+        // a tile the converter already read is a miss anyway, so don't spend I/O on it
+        bool isWarm = true;
+        for (const auto &file : tile->files) {
+            if (tile->isConsumed) {
+                isWarm = false;
+                break;
+            }
+
+            if (warmFile(file)) {
+                m_prefetchedByteLength += file.size;
+            } else {
+                isWarm = false;
+            }
+        }
+
+        tile->isWarm = isWarm;
+        tile->isPrefetched = true;
+    }
+}
+
+bool TilePrefetcher::warmFile(const File &file)
+{
+    // a file that can't be opened is skipped. The converter reports it when it reads the tile
+    if (VirtualFileSystem::isVirtualPath(file.path)) {
+        // reading a file inside an archive brings its part of the archive into the page cache
+        return VirtualFileSystem::readFile(file.path) != std::nullopt;
+    }
+
+#if defined(__linux__)
+    int fd = ::open(file.path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    // readahead blocks until the pages are in the page cache, so the tile is only marked warm once they are
+    bool isRead = ::readahead(fd, 0, static_cast<size_t>(file.size)) == 0;
+    ::close(fd);
+    return isRead;
+#else
+    std::ifstream fs(file.path, std::ios::binary);
+    if (!fs) {
+        return false;
+    }
+
+    std::vector<char> buffer(64 * 1024);
+    while (fs.read(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+    }
+
+    return true;
+#endif
+}
+
+} // namespace CDBTo3DTiles
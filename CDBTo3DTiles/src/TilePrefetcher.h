@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CDBTo3DTiles {
+// Warms the page cache with the input files of upcoming tiles on background I/O threads, so they are
+// already in memory when the converter reads them
+class TilePrefetcher
+{
+public:
+    struct File
+    {
+        std::filesystem::path path;
+        uintmax_t size;
+    };
+
+    // the input files of one tile, from the moment they are queued until the tile is read
+    struct Tile
+    {
+        std::vector<File> files;
+        uintmax_t byteLength{0};
+
+        // set once the I/O threads are done with the tile. It is only warm when every file was read
+        std::atomic<bool> isPrefetched{false};
+        std::atomic<bool> isWarm{false};
+        std::atomic<bool> isConsumed{false};
+    };
+
+    struct Statistics
+    {
+        uint64_t hitCount{0};
+        uint64_t missCount{0};
+        uint64_t prefetchedByteLength{0};
+    };
+
+    TilePrefetcher(size_t threadCount, size_t tileCount, uintmax_t maxPrefetchedBytes);
+
+    TilePrefetcher(const TilePrefetcher &) = delete;
+
+    TilePrefetcher &operator=(const TilePrefetcher &) = delete;
+
+    ~TilePrefetcher() noexcept;
+
+    // number of tiles ahead of the current one to keep warm
+    inline size_t getTileCount() const noexcept { return m_tileCount; }
+
+    inline uintmax_t getMaxPrefetchedBytes() const noexcept { return m_maxPrefetchedBytes; }
+
+    // queues the files of an upcoming tile. Returns nullptr without queueing anything when the tile would
+    // go over the byte budget, unless no other tile is waiting to be read
+    std::shared_ptr<Tile> prefetch(std::vector<File> files);
+
+    // called when the tile is read. A tile whose files were all warmed in time counts as a hit, a tile that
+    // wasn't warmed yet, couldn't be warmed or was never queued (nullptr) counts as a miss
+    void consume(const std::shared_ptr<Tile> &tile);
+
+    Statistics getStatistics() const;
+
+private:
+    void prefetchLoop();
+
+    static bool warmFile(const File &file);
+
+    size_t m_tileCount;
+    uintmax_t m_maxPrefetchedBytes;
+    uintmax_t m_pendingBytes;
+    bool m_stop;
+    std::atomic<uint64_t> m_hitCount;
+    std::atomic<uint64_t> m_missCount;
+    std::atomic<uint64_t> m_prefetchedByteLength;
+    std::deque<std::shared_ptr<Tile>> m_tiles;
+    std::mutex m_mutex;
+    std::condition_variable m_hasTiles;
+    std::vector<std::thread> m_threads;
+};
+} // namespace CDBTo3DTiles
@@ -0,0 +1,304 @@
+#include "VirtualFileSystem.h"
+#include "cpl_conv.h"
+#include "cpl_string.h"
+#include "cpl_vsi.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace CDBTo3DTiles {
+
+struct ExtractedFiles
+{
+    ~ExtractedFiles() noexcept
+    {
+        if (!directory.empty()) {
+            std::error_code errorCode;
+            std::filesystem::remove_all(directory, errorCode);
+        }
+    }
+
+    // a file is extracted once, outside of the lock, by the first thread that asks for it
+    struct LocalFile
+    {
+        std::once_flag extracted;
+        std::filesystem::path path;
+    };
+
+    std::mutex mutex;
+    std::filesystem::path directory;
+    std::unordered_map<std::string, std::shared_ptr<LocalFile>> localPaths;
+    std::unordered_map<std::string, std::filesystem::path> localDirectories;
+    std::unordered_map<std::string, std::filesystem::path> archivedDirectories;
+};
+
+static ExtractedFiles &getExtractedFiles()
+{
+    static ExtractedFiles extractedFiles;
+    return extractedFiles;
+}
+
+static std::string getArchivePrefix(std::string filename)
+{
+    std::transform(filename.begin(), filename.end(), filename.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+
+    auto isEndedWith = [&](const std::string &extension) {
+        return filename.size() > extension.size()
+               && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+    };
+
+    if (isEndedWith(".zip")) {
+        return "/vsizip/";
+    }
+
+    if (isEndedWith(".tar") || isEndedWith(".tgz") || isEndedWith(".tar.gz")) {
+        return "/vsitar/";
+    }
+
+    return "";
+}
+
+static bool statVirtualPath(const std::filesystem::path &path, VSIStatBufL &status, int flags)
+{
+    return VSIStatExL(path.string().c_str(), &status, flags) == 0;
+}
+
+bool VirtualFileSystem::isVirtualPath(const std::filesystem::path &path)
+{
+    return path.generic_string().rfind("/vsi", 0) == 0;
+}
+
+std::filesystem::path VirtualFileSystem::resolveArchivePath(const std::filesystem::path &path)
+{
+    if (isVirtualPath(path)) {
+        return path;
+    }
+
+    // the first regular file with an archive extension is the archive, the rest of the path is inside it.
+    // GDAL wants the absolute archive path after the prefix, e.g /vsizip//data/CDB.zip
+    std::filesystem::path archivePath;
+    for (auto part = path.begin(); part != path.end(); ++part) {
+        archivePath /= *part;
+        std::string prefix = getArchivePrefix(part->string());
+        std::error_code errorCode;
+        if (prefix.empty() || !std::filesystem::is_regular_file(archivePath, errorCode)) {
+            continue;
+        }
+
+        std::filesystem::path virtualPath = prefix + std::filesystem::absolute(archivePath).generic_string();
+        for (++part; part != path.end(); ++part) {
+            if (!part->empty()) {
+                virtualPath /= *part;
+            }
+        }
+
+        return virtualPath;
+    }
+
+    return path;
+}
+
+bool VirtualFileSystem::exists(const std::filesystem::path &path)
+{
+    if (isVirtualPath(path)) {
+        VSIStatBufL status;
+        return statVirtualPath(path, status, VSI_STAT_EXISTS_FLAG);
+    }
+
+    std::error_code errorCode;
+    return std::filesystem::exists(path, errorCode);
+}
+
+bool VirtualFileSystem::isDirectory(const std::filesystem::path &path)
+{
+    if (isVirtualPath(path)) {
+        VSIStatBufL status;
+        return statVirtualPath(path, status, VSI_STAT_NATURE_FLAG) && VSI_ISDIR(status.st_mode);
+    }
+
+    std::error_code errorCode;
+    return std::filesystem::is_directory(path, errorCode);
+}
+
+std::optional<uintmax_t> VirtualFileSystem::getFileSize(const std::filesystem::path &path)
+{
+    if (isVirtualPath(path)) {
+        VSIStatBufL status;
+        if (!statVirtualPath(path, status, VSI_STAT_SIZE_FLAG)) {
+            return std::nullopt;
+        }
+
+        return static_cast<uintmax_t>(status.st_size);
+    }
+
+    std::error_code errorCode;
+    auto size = std::filesystem::file_size(path, errorCode);
+    if (errorCode) {
+        return std::nullopt;
+    }
+
+    return size;
+}
+
+std::optional<int64_t> VirtualFileSystem::getModifiedTime(const std::filesystem::path &path)
+{
+    if (isVirtualPath(path)) {
+        VSIStatBufL status;
+        if (!statVirtualPath(path, status, VSI_STAT_EXISTS_FLAG)) {
+            return std::nullopt;
+        }
+
+        return static_cast<int64_t>(status.st_mtime);
+    }
+
+    std::error_code errorCode;
+    auto modifiedTime = std::filesystem::last_write_time(path, errorCode);
+    if (errorCode) {
+        return std::nullopt;
+    }
+
+    return static_cast<int64_t>(modifiedTime.time_since_epoch().count());
+}
+
+std::vector<VirtualFileSystem::Entry> VirtualFileSystem::listDirectory(const std::filesystem::path &path)
+{
+    std::vector<Entry> entries;
+    if (isVirtualPath(path)) {
+        // the archive listing is cached by GDAL, so the status of each entry doesn't read the archive again
+        char **names = VSIReadDir(path.string().c_str());
+        for (int i = 0; i < CSLCount(names); ++i) {
+            std::string name = names[i];
+            if (name == "." || name == "..") {
+                continue;
+            }
+
+            VSIStatBufL status;
+            auto entryPath = path / name;
+            bool isDirectory = statVirtualPath(entryPath, status, VSI_STAT_NATURE_FLAG)
+                               && VSI_ISDIR(status.st_mode);
+            entries.push_back({std::move(entryPath), isDirectory});
+        }
+
+        CSLDestroy(names);
+        return entries;
+    }
+
+    std::error_code errorCode;
+    for (const auto &entry : std::filesystem::directory_iterator(path, errorCode)) {
+        entries.push_back({entry.path(), entry.is_directory(errorCode)});
+    }
+
+    return entries;
+}
+
+std::optional<std::string> VirtualFileSystem::readFile(const std::filesystem::path &path)
+{
+    GByte *data = nullptr;
+    vsi_l_offset byteLength = 0;
+    if (!VSIIngestFile(nullptr, path.string().c_str(), &data, &byteLength, -1)) {
+        return std::nullopt;
+    }
+
+    std::string content(reinterpret_cast<const char *>(data), static_cast<size_t>(byteLength));
+    VSIFree(data);
+    return content;
+}
+
+std::filesystem::path VirtualFileSystem::getLocalPath(const std::filesystem::path &path)
+{
+    if (!isVirtualPath(path)) {
+        return path;
+    }
+
+    auto &extractedFiles = getExtractedFiles();
+    std::shared_ptr<ExtractedFiles::LocalFile> localFile;
+    {
+        std::lock_guard<std::mutex> lock(extractedFiles.mutex);
+        auto &cachedFile = extractedFiles.localPaths[path.string()];
+        if (cachedFile == nullptr) {
+            if (extractedFiles.directory.empty()) {
+                auto name = std::filesystem::path(CPLGenerateTempFilename("cdb-to-3dtiles")).filename();
+                extractedFiles.directory = std::filesystem::temp_directory_path() / name;
+            }
+
+            // the files of an archived directory are extracted into the same local directory, so readers
+            // find the files next to each other like in the archive
+            std::string archivedDirectory = path.parent_path().string();
+            auto localDirectory = extractedFiles.localDirectories.find(archivedDirectory);
+            if (localDirectory == extractedFiles.localDirectories.end()) {
+                auto directory = extractedFiles.directory
+                                 / std::to_string(extractedFiles.localDirectories.size());
+                std::filesystem::create_directories(directory);
+                extractedFiles.archivedDirectories.insert(
+                    {directory.lexically_normal().generic_string(), path.parent_path()});
+                localDirectory = extractedFiles.localDirectories.insert({archivedDirectory, directory}).first;
+            }
+
+            cachedFile = std::make_shared<ExtractedFiles::LocalFile>();
+            cachedFile->path = localDirectory->second / path.filename();
+        }
+
+        localFile = cachedFile;
+    }
+
+    std::call_once(localFile->extracted, [&]() {
+        auto content = readFile(path);
+        if (!content) {
+            return;
+        }
+
+        std::ofstream fs(localFile->path, std::ios::binary);
+        fs.write(content->data(), static_cast<std::streamsize>(content->size()));
+        if (!fs) {
+            throw std::runtime_error("Failed to extract " + path.string() + " to "
+                                     + localFile->path.string());
+        }
+    });
+
+    return localFile->path;
+}
+
+void VirtualFileSystem::removeLocalPath(const std::filesystem::path &path)
+{
+    if (!isVirtualPath(path)) {
+        return;
+    }
+
+    std::shared_ptr<ExtractedFiles::LocalFile> localFile;
+    {
+        auto &extractedFiles = getExtractedFiles();
+        std::lock_guard<std::mutex> lock(extractedFiles.mutex);
+        auto cachedFile = extractedFiles.localPaths.find(path.string());
+        if (cachedFile == extractedFiles.localPaths.end()) {
+            return;
+        }
+
+        localFile = std::move(cachedFile->second);
+        extractedFiles.localPaths.erase(cachedFile);
+    }
+
+    std::error_code errorCode;
+    std::filesystem::remove(localFile->path, errorCode);
+}
+
+std::optional<std::filesystem::path> VirtualFileSystem::getArchivedDirectory(
+    const std::filesystem::path &localDirectory)
+{
+    auto &extractedFiles = getExtractedFiles();
+    std::lock_guard<std::mutex> lock(extractedFiles.mutex);
+    auto archivedDirectory = extractedFiles.archivedDirectories.find(
+        localDirectory.lexically_normal().generic_string());
+    if (archivedDirectory == extractedFiles.archivedDirectories.end()) {
+        return std::nullopt;
+    }
+
+    return archivedDirectory->second;
+}
+
+} // namespace CDBTo3DTiles
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace CDBTo3DTiles {
+// File system queries that work on both directories and CDBs bundled in zip or tar archives. Paths inside an
+// archive go through GDAL's virtual file systems (/vsizip/, /vsitar/), which read the listing of an archive
+// once and cache it, so nothing is extracted up front
+class VirtualFileSystem
+{
+public:
+    struct Entry
+    {
+        std::filesystem::path path;
+        bool isDirectory;
+    };
+
+    static bool isVirtualPath(const std::filesystem::path &path);
+
+    // turns a path that goes through a .zip, .tar, .tgz or .tar.gz file, e.g. CDB.zip/CDB_san_diego, into the
+    // GDAL virtual path that reads it in place. Any other path is returned unchanged
+    static std::filesystem::path resolveArchivePath(const std::filesystem::path &path);
+
+    static bool exists(const std::filesystem::path &path);
+
+    static bool isDirectory(const std::filesystem::path &path);
+
+    static std::optional<uintmax_t> getFileSize(const std::filesystem::path &path);
+
+    static std::optional<int64_t> getModifiedTime(const std::filesystem::path &path);
+
+    // entries of a directory, in no particular order. A directory that can't be listed has no entries
+    static std::vector<Entry> listDirectory(const std::filesystem::path &path);
+
+    static std::optional<std::string> readFile(const std::filesystem::path &path);
+
+    // readers that can't go through GDAL, like OSG, read a local copy of a file inside an archive. The copy
+    // is extracted once and removed when the program exits. A local path is returned unchanged
+    static std::filesystem::path getLocalPath(const std::filesystem::path &path);
+
+    // removes the local copy of a file inside an archive once no reader needs it anymore
+    static void removeLocalPath(const std::filesystem::path &path);
+
+    // the archived directory that a directory of local copies is extracted from
+    static std::optional<std::filesystem::path> getArchivedDirectory(
+        const std::filesystem::path &localDirectory);
+};
+} // namespace CDBTo3DTiles
@@ -4,14 +4,70 @@
 #include "cxxopts.hpp"
 #include <iostream>
 
+static int mergeShards(int argc, char **argv)
+{
+    cxxopts::Options options("CDBConverter merge", "Combine the outputs of sharded conversions");
+
+    // clang-format off
+    options.add_options("")
+      ("i, input",
+          "Output directory of a shard. Repeat this option for each shard",
+          cxxopts::value<std::vector<std::string>>())
+      ("o, output",
+          "Directory of the combined tilesets",
+          cxxopts::value<std::string>())
+      ("combine",
+          "Combine converted datasets into one tileset, the same way as the conversion does",
+          cxxopts::value<std::vector<std::string>>()->default_value("Elevation_1_1,GSModels_1_1,GTModels_2_1,GTModels_1_1"))
+      ("h, help", "Print usage");
+    // clang-format on
+
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+        std::cout << options.help({""}) << "\n";
+        return 0;
+    }
+
+    try {
+        if (result.count("input") && result.count("output")) {
+            std::vector<std::filesystem::path> shardPaths;
+            for (const auto &input : result["input"].as<std::vector<std::string>>()) {
+                shardPaths.emplace_back(input);
+            }
+
+            std::filesystem::path outputPath = result["output"].as<std::string>();
+            std::vector<std::string> combinedDatasets = result["combine"].as<std::vector<std::string>>();
+
+            CDBTo3DTiles::GlobalInitializer initializer;
+            CDBTo3DTiles::ShardMerger merger(shardPaths, outputPath);
+            for (const auto &combined : combinedDatasets) {
+                merger.combineDataset(CDBTo3DTiles::splitString(combined, ","));
+            }
+
+            merger.merge();
+        } else {
+            std::cout << options.help();
+            return 0;
+        }
+    } catch (const std::exception &e) {
+        std::cout << "An error has occured: " << e.what() << "\n";
+    }
+
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
+    if (argc > 1 && std::string(argv[1]) == "merge") {
+        return mergeShards(argc - 1, argv + 1);
+    }
+
     cxxopts::Options options("CDBConverter", "Convert CDB to 3D Tiles");
 
     // clang-format off
     options.add_options("")
       ("i, input",
-          "CDB directory",
+          "CDB directory. It can be inside a zip or tar archive, e.g. CDB.zip/CDB_san_diego",
           cxxopts::value<std::string>())
       ("o, output",
           "3D Tiles output directory",
@@ -33,6 +89,57 @@ int main(int argc, char **argv)
       ("elevation-threshold-indices",
           "Set target percent of indices when decimating elevation mesh",
           cxxopts::value<float>()->default_value("0.3"))
+      ("elevation-simplifier",
+          "How elevation meshes are decimated. meshopt simplifies the grid mesh with meshoptimizer, rtin extracts a right-triangulated irregular network from the heights of square grids of 2^n pixels and uses meshopt for any other grid",
+          cxxopts::value<std::string>()->default_value("meshopt"))
+      ("elevation-clip-sub-regions",
+          "Cut the simplified mesh of an elevation tile into the tiles that fill missing elevation below it, instead of simplifying each of them again",
+          cxxopts::value<bool>()->default_value("false"))
+      ("threads",
+          "Number of threads used to convert geocells concurrently",
+          cxxopts::value<int>()->default_value("1"))
+      ("pipeline-queue-depth",
+          "Convert elevation with read, build, encode and write stages connected by queues of this depth. 0 disables the pipeline",
+          cxxopts::value<int>()->default_value("0"))
+      ("pipeline-builder-threads",
+          "Number of threads simplifying elevation meshes in the pipeline",
+          cxxopts::value<int>()->default_value("1"))
+      ("pipeline-encoder-threads",
+          "Number of threads encoding elevation tiles in the pipeline",
+          cxxopts::value<int>()->default_value("1"))
+      ("pipeline-writer-threads",
+          "Number of threads writing elevation tiles in the pipeline",
+          cxxopts::value<int>()->default_value("1"))
+      ("writer-threads",
+          "Number of background threads writing tiles, textures and subtrees. 0 writes them on the converting threads",
+          cxxopts::value<int>()->default_value("0"))
+      ("writer-memory-budget",
+          "Maximum megabytes of output waiting to be written by the background writer before conversion blocks",
+          cxxopts::value<int>()->default_value("256"))
+      ("prefetch-tiles",
+          "Number of upcoming elevation tiles whose elevation, imagery, RMTexture and RMDescriptor files are read ahead in the background. 0 disables prefetching",
+          cxxopts::value<int>()->default_value("0"))
+      ("prefetch-threads",
+          "Number of background threads reading ahead the upcoming tiles",
+          cxxopts::value<int>()->default_value("2"))
+      ("prefetch-memory-budget",
+          "Maximum megabytes of input read ahead and not yet converted",
+          cxxopts::value<int>()->default_value("256"))
+      ("shard",
+          "Only convert the geocells of shard {index}/{count}, e.g. 0/4. Combine the shard outputs with the merge subcommand",
+          cxxopts::value<std::string>())
+      ("index-cache",
+          "Save the CDB file index to {CDB}/.cdb23dtiles.index and reuse it in later runs. Only geocells whose directories changed are listed again",
+          cxxopts::value<bool>()->default_value("false"))
+      ("output-sink",
+          "Where the converted files go. filesystem writes them to the output directory, archive stores them in a single 3D Tiles archive (3TZ) file at the output path, null only counts them",
+          cxxopts::value<std::string>()->default_value("filesystem"))
+      ("dedup-output",
+          "Write identical output files once. Later copies are hard linked to the first one when the output goes to the file system",
+          cxxopts::value<bool>()->default_value("false"))
+      ("tile-layout",
+          "Where the tile content goes in each tileset directory. flat puts every tile in the tileset directory, nested puts tiles in L{level}/U{UREF} sub directories like the CDB",
+          cxxopts::value<std::string>()->default_value("flat"))
       ("h, help", "Print usage");
 
     options.add_options("hidden")
@@ -65,6 +172,22 @@ int main(int argc, char **argv)
             int subtreeLevels = result["subtree-levels"].as<int>();
             float elevationDecimateError = result["elevation-decimate-error"].as<float>();
             float elevationThresholdIndices = result["elevation-threshold-indices"].as<float>();
+            std::string elevationSimplifier = result["elevation-simplifier"].as<std::string>();
+            bool elevationClipSubRegions = result["elevation-clip-sub-regions"].as<bool>();
+            int threadCount = result["threads"].as<int>();
+            int pipelineQueueDepth = result["pipeline-queue-depth"].as<int>();
+            int pipelineBuilderThreads = result["pipeline-builder-threads"].as<int>();
+            int pipelineEncoderThreads = result["pipeline-encoder-threads"].as<int>();
+            int pipelineWriterThreads = result["pipeline-writer-threads"].as<int>();
+            int writerThreads = result["writer-threads"].as<int>();
+            int writerMemoryBudget = result["writer-memory-budget"].as<int>();
+            int prefetchTiles = result["prefetch-tiles"].as<int>();
+            int prefetchThreads = result["prefetch-threads"].as<int>();
+            int prefetchMemoryBudget = result["prefetch-memory-budget"].as<int>();
+            bool useIndexCache = result["index-cache"].as<bool>();
+            std::string outputSink = result["output-sink"].as<std::string>();
+            bool deduplicateOutput = result["dedup-output"].as<bool>();
+            std::string tileLayout = result["tile-layout"].as<std::string>();
             std::vector<std::string> combinedDatasets = result["combine"].as<std::vector<std::string>>();
 
             CDBTo3DTiles::GlobalInitializer initializer;
@@ -76,11 +199,66 @@ int main(int argc, char **argv)
             converter.setSubtreeLevels(subtreeLevels);
             converter.setElevationDecimateError(elevationDecimateError);
             converter.setElevationThresholdIndices(elevationThresholdIndices);
+            if (elevationSimplifier == "rtin") {
+                converter.setElevationSimplifier(CDBTo3DTiles::ElevationSimplifier::RTIN);
+            } else if (elevationSimplifier != "meshopt") {
+                throw std::runtime_error("Unknown elevation simplifier " + elevationSimplifier
+                                         + ". It should be meshopt or rtin");
+            }
+            converter.setElevationClipSubRegions(elevationClipSubRegions);
+            converter.setThreadCount(threadCount);
+            converter.setPipelineQueueDepth(pipelineQueueDepth);
+            converter.setPipelineBuilderThreads(pipelineBuilderThreads);
+            converter.setPipelineEncoderThreads(pipelineEncoderThreads);
+            converter.setPipelineWriterThreads(pipelineWriterThreads);
+            converter.setWriterThreads(writerThreads);
+            converter.setWriterMemoryBudget(writerMemoryBudget);
+            converter.setPrefetchTiles(prefetchTiles);
+            converter.setPrefetchThreads(prefetchThreads);
+            converter.setPrefetchMemoryBudget(prefetchMemoryBudget);
+            converter.setUseIndexCache(useIndexCache);
+            converter.setDeduplicateOutput(deduplicateOutput);
+            if (tileLayout == "nested") {
+                converter.setTileLayout(CDBTo3DTiles::TileLayout::Nested);
+            } else if (tileLayout != "flat") {
+                throw std::runtime_error("Unknown tile layout " + tileLayout
+                                         + ". It should be flat or nested");
+            }
+            if (outputSink == "archive") {
+                // the archive is written at the output path, and its entries are relative to it
+                auto archive = std::make_shared<CDBTo3DTiles::ArchiveOutputSink>(outputPath, outputPath);
+                converter.setOutputSink(archive);
+            } else if (outputSink == "null") {
+                converter.setOutputSink(std::make_shared<CDBTo3DTiles::NullOutputSink>());
+            } else if (outputSink != "filesystem") {
+                throw std::runtime_error("Unknown output sink " + outputSink
+                                         + ". It should be filesystem, archive or null");
+            }
+            if (result.count("shard")) {
+                auto shard = CDBTo3DTiles::splitString(result["shard"].as<std::string>(), "/");
+                if (shard.size() != 2) {
+                    throw std::runtime_error("Wrong shard format. Required format should be: {index}/{count}");
+                }
+
+                converter.setShard(std::stoi(shard[0]), std::stoi(shard[1]));
+            }
+
             for (const auto &combined : combinedDatasets) {
                 converter.combineDataset(CDBTo3DTiles::splitString(combined, ","));
             }
 
             converter.convert();
+            if (prefetchTiles > 0) {
+                const auto &statistics = converter.getPrefetchStatistics();
+                std::cout << "Prefetched elevation tiles: " << statistics.hitCount << " hits, "
+                          << statistics.missCount << " misses, " << statistics.prefetchedByteLength
+                          << " bytes read ahead\n";
+            }
+
+            if (deduplicateOutput) {
+                std::cout << "Deduplicated output: " << converter.getDuplicateFileCount() << " files, "
+                          << converter.getDuplicateByteLength() << " bytes not written\n";
+            }
         } else {
             std::cout << options.help();
             return 0;
@@ -2,6 +2,7 @@
 
 #include "Cartographic.h"
 #include "glm/glm.hpp"
+#include <cstddef>
 #include <optional>
 
 namespace Core {
@@ -22,6 +23,19 @@ public:
 
     glm::dvec3 cartographicToCartesian(const Cartographic &cartographic) const;
 
+    // converts count positions given as separate arrays of longitudes and latitudes in radians and heights in
+    // meters. The trigonometry runs on AVX2 or NEON when the CPU has it and agrees with the single position
+    // conversion to within a few units in the last place
+    void cartographicToCartesian(const double *longitudes,
+                                 const double *latitudes,
+                                 const double *heights,
+                                 size_t count,
+                                 glm::dvec3 *cartesians) const;
+
+    void cartographicToCartesian(const Cartographic *cartographics,
+                                 size_t count,
+                                 glm::dvec3 *cartesians) const;
+
     std::optional<Cartographic> cartesianToCartographic(const glm::dvec3 &cartesian) const;
 
     std::optional<glm::dvec3> scaleToGeodeticSurface(const glm::dvec3 &cartesian) const;
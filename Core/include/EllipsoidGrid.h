@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Ellipsoid.h"
+#include "glm/glm.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace Core {
+// converts the positions of a regular longitude/latitude grid, where every row shares a latitude and every
+// column shares a longitude. Sines and cosines are evaluated once per column and once per row instead of
+// once per position
+class EllipsoidGrid
+{
+public:
+    EllipsoidGrid(const Ellipsoid &ellipsoid, const double *longitudes, size_t longitudeCount);
+
+    inline size_t getColumnCount() const noexcept { return m_cosLongitudes.size(); }
+
+    // converts the row at the latitude in radians, with a height in meters for every column, and grows
+    // minimum and maximum to contain the converted positions
+    void convertRow(double latitude,
+                    const double *heights,
+                    glm::dvec3 *cartesians,
+                    glm::dvec3 &minimum,
+                    glm::dvec3 &maximum) const;
+
+private:
+    glm::dvec3 m_radiiSquared;
+    std::vector<double> m_cosLongitudes;
+    std::vector<double> m_sinLongitudes;
+};
+} // namespace Core
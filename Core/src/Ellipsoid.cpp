@@ -1,8 +1,58 @@
 #include "Ellipsoid.h"
 #include "MathHelpers.h"
+#include "SIMDHelpers.h"
 
 namespace Core {
 
+#ifdef CORE_SIMD
+// converts the positions in whole SIMD blocks and returns how many it converted. The arithmetic after the
+// trigonometry follows the single position conversion step by step
+CORE_SIMD_TARGET static size_t simdCartographicToCartesian(const glm::dvec3 &radiiSquared,
+                                                           const double *longitudes,
+                                                           const double *latitudes,
+                                                           const double *heights,
+                                                           size_t count,
+                                                           glm::dvec3 *cartesians)
+{
+    SimdDouble radiiSquaredX = simdSet(radiiSquared.x);
+    SimdDouble radiiSquaredY = simdSet(radiiSquared.y);
+    SimdDouble radiiSquaredZ = simdSet(radiiSquared.z);
+    SimdDouble one = simdSet(1.0);
+
+    size_t blockCount = count - count % SIMD_WIDTH;
+    for (size_t i = 0; i < blockCount; i += SIMD_WIDTH) {
+        SimdDouble sinLongitude, cosLongitude, sinLatitude, cosLatitude;
+        simdSinCos(simdLoad(longitudes + i), sinLongitude, cosLongitude);
+        simdSinCos(simdLoad(latitudes + i), sinLatitude, cosLatitude);
+
+        SimdDouble nX = simdMul(cosLatitude, cosLongitude);
+        SimdDouble nY = simdMul(cosLatitude, sinLongitude);
+        SimdDouble nZ = sinLatitude;
+        SimdDouble nLengthSquared = simdAdd(simdAdd(simdMul(nX, nX), simdMul(nY, nY)), simdMul(nZ, nZ));
+        SimdDouble oneOverNLength = simdDiv(one, simdSqrt(nLengthSquared));
+        nX = simdMul(nX, oneOverNLength);
+        nY = simdMul(nY, oneOverNLength);
+        nZ = simdMul(nZ, oneOverNLength);
+
+        SimdDouble kX = simdMul(radiiSquaredX, nX);
+        SimdDouble kY = simdMul(radiiSquaredY, nY);
+        SimdDouble kZ = simdMul(radiiSquaredZ, nZ);
+        SimdDouble gamma = simdSqrt(simdAdd(simdAdd(simdMul(nX, kX), simdMul(nY, kY)), simdMul(nZ, kZ)));
+
+        SimdDouble height = simdLoad(heights + i);
+        double x[SIMD_WIDTH], y[SIMD_WIDTH], z[SIMD_WIDTH];
+        simdStore(x, simdAdd(simdDiv(kX, gamma), simdMul(nX, height)));
+        simdStore(y, simdAdd(simdDiv(kY, gamma), simdMul(nY, height)));
+        simdStore(z, simdAdd(simdDiv(kZ, gamma), simdMul(nZ, height)));
+        for (size_t j = 0; j < SIMD_WIDTH; ++j) {
+            cartesians[i + j] = glm::dvec3(x[j], y[j], z[j]);
+        }
+    }
+
+    return blockCount;
+}
+#endif
+
 const Ellipsoid Ellipsoid::WGS84 = Ellipsoid(6378137.0, 6378137.0, 6356752.3142451793);
 
 Ellipsoid::Ellipsoid(double x, double y, double z)
@@ -42,6 +92,46 @@ glm::dvec3 Ellipsoid::cartographicToCartesian(const Cartographic &cartographic)
     return k + n;
 }
 
+void Ellipsoid::cartographicToCartesian(const double *longitudes,
+                                        const double *latitudes,
+                                        const double *heights,
+                                        size_t count,
+                                        glm::dvec3 *cartesians) const
+{
+    size_t converted = 0;
+#ifdef CORE_SIMD
+    static const bool isSimdEnabled = isSimdSupported();
+    if (isSimdEnabled) {
+        converted = simdCartographicToCartesian(
+            m_radiiSquared, longitudes, latitudes, heights, count, cartesians);
+    }
+#endif
+
+    // the positions that don't fill a whole SIMD block, or all of them without SIMD
+    for (size_t i = converted; i < count; ++i) {
+        cartesians[i] = cartographicToCartesian(Cartographic(longitudes[i], latitudes[i], heights[i]));
+    }
+}
+
+void Ellipsoid::cartographicToCartesian(const Cartographic *cartographics,
+                                        size_t count,
+                                        glm::dvec3 *cartesians) const
+{
+    // split the positions into separate arrays a block at a time, so the block stays in the cache
+    static constexpr size_t BLOCK_SIZE = 256;
+    double longitudes[BLOCK_SIZE], latitudes[BLOCK_SIZE], heights[BLOCK_SIZE];
+    for (size_t begin = 0; begin < count; begin += BLOCK_SIZE) {
+        size_t blockCount = glm::min(BLOCK_SIZE, count - begin);
+        for (size_t i = 0; i < blockCount; ++i) {
+            longitudes[i] = cartographics[begin + i].longitude;
+            latitudes[i] = cartographics[begin + i].latitude;
+            heights[i] = cartographics[begin + i].height;
+        }
+
+        cartographicToCartesian(longitudes, latitudes, heights, blockCount, cartesians + begin);
+    }
+}
+
 std::optional<Cartographic> Ellipsoid::cartesianToCartographic(const glm::dvec3 &cartesian) const
 {
     std::optional<glm::dvec3> p = scaleToGeodeticSurface(cartesian);
@@ -0,0 +1,129 @@
+#include "EllipsoidGrid.h"
+#include "SIMDHelpers.h"
+
+namespace Core {
+
+#ifdef CORE_SIMD
+// converts the row in whole SIMD blocks and returns how many positions it converted
+CORE_SIMD_TARGET static size_t simdConvertRow(const glm::dvec3 &radiiSquared,
+                                              double cosLatitude,
+                                              double sinLatitude,
+                                              const double *cosLongitudes,
+                                              const double *sinLongitudes,
+                                              const double *heights,
+                                              size_t count,
+                                              glm::dvec3 *cartesians,
+                                              glm::dvec3 &minimum,
+                                              glm::dvec3 &maximum)
+{
+    size_t blockCount = count - count % SIMD_WIDTH;
+    if (blockCount == 0) {
+        return 0;
+    }
+
+    // the latitude terms are the same for the whole row
+    SimdDouble radiiSquaredX = simdSet(radiiSquared.x);
+    SimdDouble radiiSquaredY = simdSet(radiiSquared.y);
+    SimdDouble cosLatitudes = simdSet(cosLatitude);
+    SimdDouble nZ = simdSet(sinLatitude);
+    SimdDouble kZ = simdSet(radiiSquared.z * sinLatitude);
+    SimdDouble nZkZ = simdSet(sinLatitude * (radiiSquared.z * sinLatitude));
+    SimdDouble one = simdSet(1.0);
+
+    SimdDouble minimumX = simdSet(minimum.x), minimumY = simdSet(minimum.y), minimumZ = simdSet(minimum.z);
+    SimdDouble maximumX = simdSet(maximum.x), maximumY = simdSet(maximum.y), maximumZ = simdSet(maximum.z);
+    for (size_t i = 0; i < blockCount; i += SIMD_WIDTH) {
+        SimdDouble nX = simdMul(cosLatitudes, simdLoad(cosLongitudes + i));
+        SimdDouble nY = simdMul(cosLatitudes, simdLoad(sinLongitudes + i));
+        SimdDouble kX = simdMul(radiiSquaredX, nX);
+        SimdDouble kY = simdMul(radiiSquaredY, nY);
+        SimdDouble gamma = simdSqrt(simdAdd(simdAdd(simdMul(nX, kX), simdMul(nY, kY)), nZkZ));
+        SimdDouble oneOverGamma = simdDiv(one, gamma);
+
+        SimdDouble height = simdLoad(heights + i);
+        SimdDouble x = simdAdd(simdMul(kX, oneOverGamma), simdMul(nX, height));
+        SimdDouble y = simdAdd(simdMul(kY, oneOverGamma), simdMul(nY, height));
+        SimdDouble z = simdAdd(simdMul(kZ, oneOverGamma), simdMul(nZ, height));
+        minimumX = simdMin(minimumX, x);
+        minimumY = simdMin(minimumY, y);
+        minimumZ = simdMin(minimumZ, z);
+        maximumX = simdMax(maximumX, x);
+        maximumY = simdMax(maximumY, y);
+        maximumZ = simdMax(maximumZ, z);
+
+        double xs[SIMD_WIDTH], ys[SIMD_WIDTH], zs[SIMD_WIDTH];
+        simdStore(xs, x);
+        simdStore(ys, y);
+        simdStore(zs, z);
+        for (size_t j = 0; j < SIMD_WIDTH; ++j) {
+            cartesians[i + j] = glm::dvec3(xs[j], ys[j], zs[j]);
+        }
+    }
+
+    // reduce the lanes of the bounds
+    double lanes[6][SIMD_WIDTH];
+    simdStore(lanes[0], minimumX);
+    simdStore(lanes[1], minimumY);
+    simdStore(lanes[2], minimumZ);
+    simdStore(lanes[3], maximumX);
+    simdStore(lanes[4], maximumY);
+    simdStore(lanes[5], maximumZ);
+    for (size_t j = 0; j < SIMD_WIDTH; ++j) {
+        minimum = glm::min(minimum, glm::dvec3(lanes[0][j], lanes[1][j], lanes[2][j]));
+        maximum = glm::max(maximum, glm::dvec3(lanes[3][j], lanes[4][j], lanes[5][j]));
+    }
+
+    return blockCount;
+}
+#endif
+
+EllipsoidGrid::EllipsoidGrid(const Ellipsoid &ellipsoid, const double *longitudes, size_t longitudeCount)
+    : m_radiiSquared{ellipsoid.getRadii() * ellipsoid.getRadii()}
+{
+    m_cosLongitudes.reserve(longitudeCount);
+    m_sinLongitudes.reserve(longitudeCount);
+    for (size_t i = 0; i < longitudeCount; ++i) {
+        m_cosLongitudes.emplace_back(glm::cos(longitudes[i]));
+        m_sinLongitudes.emplace_back(glm::sin(longitudes[i]));
+    }
+}
+
+void EllipsoidGrid::convertRow(double latitude,
+                               const double *heights,
+                               glm::dvec3 *cartesians,
+                               glm::dvec3 &minimum,
+                               glm::dvec3 &maximum) const
+{
+    double cosLatitude = glm::cos(latitude);
+    double sinLatitude = glm::sin(latitude);
+    size_t count = m_cosLongitudes.size();
+    size_t converted = 0;
+#ifdef CORE_SIMD
+    static const bool isSimdEnabled = isSimdSupported();
+    if (isSimdEnabled) {
+        converted = simdConvertRow(m_radiiSquared,
+                                   cosLatitude,
+                                   sinLatitude,
+                                   m_cosLongitudes.data(),
+                                   m_sinLongitudes.data(),
+                                   heights,
+                                   count,
+                                   cartesians,
+                                   minimum,
+                                   maximum);
+    }
+#endif
+
+    // the surface normal of a position is the unit vector of its longitude and latitude, which is scaled onto
+    // the ellipsoid and then raised by the height
+    for (size_t i = converted; i < count; ++i) {
+        glm::dvec3 n(cosLatitude * m_cosLongitudes[i], cosLatitude * m_sinLongitudes[i], sinLatitude);
+        glm::dvec3 k = m_radiiSquared * n;
+        double oneOverGamma = 1.0 / glm::sqrt(glm::dot(n, k));
+        glm::dvec3 position = k * oneOverGamma + n * heights[i];
+        cartesians[i] = position;
+        minimum = glm::min(minimum, position);
+        maximum = glm::max(maximum, position);
+    }
+}
+} // namespace Core
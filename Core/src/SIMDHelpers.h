@@ -0,0 +1,278 @@
+#pragma once
+
+#include "MathHelpers.h"
+#include <cstddef>
+
+// thin wrappers over the AVX2 or NEON double intrinsics, so a kernel is written once for both. Kernels are
+// marked CORE_SIMD_TARGET and only called when isSimdSupported() returns true
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define CORE_SIMD
+#define CORE_SIMD_AVX2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CORE_SIMD
+#define CORE_SIMD_NEON
+#endif
+
+// AVX2 kernels are compiled for AVX2 on their own and only run when the CPU supports it, so the rest of the
+// library still runs on any x86-64 CPU
+#if defined(CORE_SIMD_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#define CORE_SIMD_TARGET __attribute__((target("avx2")))
+#else
+#define CORE_SIMD_TARGET
+#endif
+
+namespace Core {
+
+#ifdef CORE_SIMD_AVX2
+using SimdDouble = __m256d;
+static constexpr size_t SIMD_WIDTH = 4;
+
+static inline bool isSimdSupported()
+{
+#if defined(_MSC_VER)
+    // AVX2 needs both the instructions and an OS that saves the YMM registers
+    int info[4];
+    __cpuid(info, 1);
+    bool isOSXSAVESupported = (info[2] & (1 << 27)) != 0;
+    bool isAVXSupported = (info[2] & (1 << 28)) != 0;
+    if (!isOSXSAVESupported || !isAVXSupported || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdSet(double value)
+{
+    return _mm256_set1_pd(value);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdLoad(const double *values)
+{
+    return _mm256_loadu_pd(values);
+}
+
+CORE_SIMD_TARGET static inline void simdStore(double *values, SimdDouble v)
+{
+    _mm256_storeu_pd(values, v);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdAdd(SimdDouble a, SimdDouble b)
+{
+    return _mm256_add_pd(a, b);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdSub(SimdDouble a, SimdDouble b)
+{
+    return _mm256_sub_pd(a, b);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdMul(SimdDouble a, SimdDouble b)
+{
+    return _mm256_mul_pd(a, b);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdDiv(SimdDouble a, SimdDouble b)
+{
+    return _mm256_div_pd(a, b);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdSqrt(SimdDouble v)
+{
+    return _mm256_sqrt_pd(v);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdRound(SimdDouble v)
+{
+    return _mm256_round_pd(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdFloor(SimdDouble v)
+{
+    return _mm256_floor_pd(v);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdMin(SimdDouble a, SimdDouble b)
+{
+    return _mm256_min_pd(a, b);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdMax(SimdDouble a, SimdDouble b)
+{
+    return _mm256_max_pd(a, b);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdEqual(SimdDouble a, SimdDouble b)
+{
+    return _mm256_cmp_pd(a, b, _CMP_EQ_OQ);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdOr(SimdDouble a, SimdDouble b)
+{
+    return _mm256_or_pd(a, b);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdSelect(SimdDouble mask, SimdDouble a, SimdDouble b)
+{
+    return _mm256_blendv_pd(b, a, mask);
+}
+
+CORE_SIMD_TARGET static inline SimdDouble simdNegateWhere(SimdDouble mask, SimdDouble v)
+{
+    return _mm256_xor_pd(v, _mm256_and_pd(mask, _mm256_set1_pd(-0.0)));
+}
+#elif defined(CORE_SIMD_NEON)
+using SimdDouble = float64x2_t;
+static constexpr size_t SIMD_WIDTH = 2;
+
+static inline bool isSimdSupported()
+{
+    // NEON is part of every AArch64 CPU
+    return true;
+}
+
+static inline SimdDouble simdSet(double value)
+{
+    return vdupq_n_f64(value);
+}
+
+static inline SimdDouble simdLoad(const double *values)
+{
+    return vld1q_f64(values);
+}
+
+static inline void simdStore(double *values, SimdDouble v)
+{
+    vst1q_f64(values, v);
+}
+
+static inline SimdDouble simdAdd(SimdDouble a, SimdDouble b)
+{
+    return vaddq_f64(a, b);
+}
+
+static inline SimdDouble simdSub(SimdDouble a, SimdDouble b)
+{
+    return vsubq_f64(a, b);
+}
+
+static inline SimdDouble simdMul(SimdDouble a, SimdDouble b)
+{
+    return vmulq_f64(a, b);
+}
+
+static inline SimdDouble simdDiv(SimdDouble a, SimdDouble b)
+{
+    return vdivq_f64(a, b);
+}
+
+static inline SimdDouble simdSqrt(SimdDouble v)
+{
+    return vsqrtq_f64(v);
+}
+
+static inline SimdDouble simdRound(SimdDouble v)
+{
+    return vrndnq_f64(v);
+}
+
+static inline SimdDouble simdFloor(SimdDouble v)
+{
+    return vrndmq_f64(v);
+}
+
+static inline SimdDouble simdMin(SimdDouble a, SimdDouble b)
+{
+    return vminq_f64(a, b);
+}
+
+static inline SimdDouble simdMax(SimdDouble a, SimdDouble b)
+{
+    return vmaxq_f64(a, b);
+}
+
+static inline SimdDouble simdEqual(SimdDouble a, SimdDouble b)
+{
+    return vreinterpretq_f64_u64(vceqq_f64(a, b));
+}
+
+static inline SimdDouble simdOr(SimdDouble a, SimdDouble b)
+{
+    return vreinterpretq_f64_u64(vorrq_u64(vreinterpretq_u64_f64(a), vreinterpretq_u64_f64(b)));
+}
+
+static inline SimdDouble simdSelect(SimdDouble mask, SimdDouble a, SimdDouble b)
+{
+    return vbslq_f64(vreinterpretq_u64_f64(mask), a, b);
+}
+
+static inline SimdDouble simdNegateWhere(SimdDouble mask, SimdDouble v)
+{
+    uint64x2_t signs = vandq_u64(vreinterpretq_u64_f64(mask), vreinterpretq_u64_f64(vdupq_n_f64(-0.0)));
+    return vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(v), signs));
+}
+#endif
+
+#ifdef CORE_SIMD
+CORE_SIMD_TARGET static inline SimdDouble simdPolynomial(SimdDouble x, const double (&coefficients)[6])
+{
+    SimdDouble result = simdSet(coefficients[0]);
+    for (size_t i = 1; i < 6; ++i) {
+        result = simdAdd(simdMul(result, x), simdSet(coefficients[i]));
+    }
+
+    return result;
+}
+
+// sin and cos with the Cephes polynomials. The angle is reduced to [-pi/4, pi/4] by subtracting the nearest
+// multiple of pi/2, which is split in three parts so the subtraction stays exact for angles of a few turns
+CORE_SIMD_TARGET static inline void simdSinCos(SimdDouble x, SimdDouble &sinX, SimdDouble &cosX)
+{
+    static constexpr double PI_OVER_TWO_1 = 2.0 * 7.85398125648498535156E-1;
+    static constexpr double PI_OVER_TWO_2 = 2.0 * 3.77489470793079817668E-8;
+    static constexpr double PI_OVER_TWO_3 = 2.0 * 2.69515142907905952645E-15;
+    static constexpr double SIN_COEFFICIENTS[6] = {1.58962301576546568060E-10,
+                                                   -2.50507477628578072866E-8,
+                                                   2.75573136213857245213E-6,
+                                                   -1.98412698295895385996E-4,
+                                                   8.33333333332211858878E-3,
+                                                   -1.66666666666666307295E-1};
+    static constexpr double COS_COEFFICIENTS[6] = {-1.13585365213876817300E-11,
+                                                   2.08757008419747316778E-9,
+                                                   -2.75573141792967388112E-7,
+                                                   2.48015872888517045348E-5,
+                                                   -1.38888888888730564116E-3,
+                                                   4.16666666666665929218E-2};
+
+    SimdDouble quadrant = simdRound(simdMul(x, simdSet(2.0 / Math::ONE_PI)));
+    SimdDouble r = simdSub(x, simdMul(quadrant, simdSet(PI_OVER_TWO_1)));
+    r = simdSub(r, simdMul(quadrant, simdSet(PI_OVER_TWO_2)));
+    r = simdSub(r, simdMul(quadrant, simdSet(PI_OVER_TWO_3)));
+
+    SimdDouble r2 = simdMul(r, r);
+    SimdDouble sinR = simdAdd(r, simdMul(simdMul(r, r2), simdPolynomial(r2, SIN_COEFFICIENTS)));
+    SimdDouble cosR = simdAdd(simdSub(simdSet(1.0), simdMul(simdSet(0.5), r2)),
+                              simdMul(simdMul(r2, r2), simdPolynomial(r2, COS_COEFFICIENTS)));
+
+    // swap and negate depending on which quadrant the angle is in
+    SimdDouble turns = simdFloor(simdMul(quadrant, simdSet(0.25)));
+    SimdDouble quadrantModFour = simdSub(quadrant, simdMul(simdSet(4.0), turns));
+    SimdDouble isFirst = simdEqual(quadrantModFour, simdSet(1.0));
+    SimdDouble isSecond = simdEqual(quadrantModFour, simdSet(2.0));
+    SimdDouble isThird = simdEqual(quadrantModFour, simdSet(3.0));
+    SimdDouble isOdd = simdOr(isFirst, isThird);
+    sinX = simdNegateWhere(simdOr(isSecond, isThird), simdSelect(isOdd, cosR, sinR));
+    cosX = simdNegateWhere(simdOr(isFirst, isSecond), simdSelect(isOdd, sinR, cosR));
+}
+#endif
+} // namespace Core
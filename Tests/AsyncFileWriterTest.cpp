@@ -0,0 +1,76 @@
+#include "AsyncFileWriter.h"
+#include "catch2/catch.hpp"
+#include <fstream>
+
+using namespace CDBTo3DTiles;
+
+static std::string readFile(const std::filesystem::path &path)
+{
+    std::ifstream fs(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(fs), {});
+}
+
+TEST_CASE("Test async file writer writes every file", "[AsyncFileWriter]")
+{
+    std::filesystem::path output = "AsyncFileWriter";
+
+    {
+        // the budget is smaller than the total output, so the writes are throttled
+        AsyncFileWriter writer(2, 64);
+        for (size_t i = 0; i < 32; ++i) {
+            auto path = output / std::to_string(i % 4) / (std::to_string(i) + ".bin");
+            writer.write(path, std::string(i, static_cast<char>('a' + i % 26)));
+        }
+        writer.flush();
+    }
+
+    for (size_t i = 0; i < 32; ++i) {
+        auto path = output / std::to_string(i % 4) / (std::to_string(i) + ".bin");
+        REQUIRE(std::filesystem::exists(path));
+        REQUIRE(readFile(path) == std::string(i, static_cast<char>('a' + i % 26)));
+    }
+
+    std::filesystem::remove_all(output);
+}
+
+TEST_CASE("Test async file writer accepts a file larger than its budget", "[AsyncFileWriter]")
+{
+    std::filesystem::path output = "AsyncFileWriter";
+
+    {
+        AsyncFileWriter writer(1, 4);
+        writer.write(output / "large.bin", std::string(1024, 'x'));
+        writer.flush();
+    }
+
+    REQUIRE(readFile(output / "large.bin") == std::string(1024, 'x'));
+    std::filesystem::remove_all(output);
+}
+
+TEST_CASE("Test async file writer writes a batch of files", "[AsyncFileWriter]")
+{
+    std::filesystem::path output = "AsyncFileWriter";
+
+    {
+        AsyncFileWriter writer(2, 64);
+        for (size_t batch = 0; batch < 4; ++batch) {
+            std::vector<AsyncFileWriter::File> files;
+            for (size_t i = 0; i < 8; ++i) {
+                auto path = output / std::to_string(batch) / (std::to_string(i) + ".bin");
+                files.push_back({path, std::string(i + batch, static_cast<char>('a' + i))});
+            }
+
+            writer.write(std::move(files));
+        }
+        writer.flush();
+    }
+
+    for (size_t batch = 0; batch < 4; ++batch) {
+        for (size_t i = 0; i < 8; ++i) {
+            auto path = output / std::to_string(batch) / (std::to_string(i) + ".bin");
+            REQUIRE(readFile(path) == std::string(i + batch, static_cast<char>('a' + i)));
+        }
+    }
+
+    std::filesystem::remove_all(output);
+}
@@ -132,7 +132,7 @@ TEST_CASE("Test create elevation from file", "[CDBElevation]")
 
         // Level -6 has 16x16 raster but we extends to the edge to cover crack,
         // so total of vertices are 17x17 vertices
-        const auto &mesh = elevation->getUniformGridMesh();
+        const auto &mesh = elevation->createUniformGridMesh();
         REQUIRE(mesh.indices.size() == 16 * 16 * 6);
         REQUIRE(mesh.positions.size() == 289);
         REQUIRE(mesh.positionRTCs.size() == 289);
@@ -195,7 +195,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             REQUIRE(NW->getGridWidth() == 8);
             REQUIRE(NW->getGridHeight() == 8);
 
-            const auto &mesh = NW->getUniformGridMesh();
+            const auto &mesh = NW->createUniformGridMesh();
             REQUIRE(mesh.indices.size() == 8 * 8 * 6);
             REQUIRE(mesh.positions.size() == 81);
             REQUIRE(mesh.positionRTCs.size() == 81);
@@ -205,7 +205,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             glm::uvec2 gridFrom(0, 0);
             glm::uvec2 gridTo(elevation->getGridWidth() / 2, elevation->getGridHeight() / 2);
             checkUVTheSameAsOldElevation(mesh,
-                                         elevation->getUniformGridMesh(),
+                                         elevation->createUniformGridMesh(),
                                          elevation->getGridWidth(),
                                          gridFrom,
                                          gridTo);
@@ -219,7 +219,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             REQUIRE(NW->getGridWidth() == 8);
             REQUIRE(NW->getGridHeight() == 8);
 
-            const auto &mesh = NW->getUniformGridMesh();
+            const auto &mesh = NW->createUniformGridMesh();
             REQUIRE(mesh.indices.size() == 8 * 8 * 6);
             REQUIRE(mesh.positions.size() == 81);
             REQUIRE(mesh.positionRTCs.size() == 81);
@@ -240,7 +240,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             REQUIRE(NE->getGridWidth() == 8);
             REQUIRE(NE->getGridHeight() == 8);
 
-            const auto &mesh = NE->getUniformGridMesh();
+            const auto &mesh = NE->createUniformGridMesh();
             REQUIRE(mesh.indices.size() == 8 * 8 * 6);
             REQUIRE(mesh.positions.size() == 81);
             REQUIRE(mesh.positionRTCs.size() == 81);
@@ -251,7 +251,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             glm::uvec2 gridTo = gridFrom
                                 + glm::uvec2(elevation->getGridWidth() / 2, elevation->getGridHeight() / 2);
             checkUVTheSameAsOldElevation(mesh,
-                                         elevation->getUniformGridMesh(),
+                                         elevation->createUniformGridMesh(),
                                          elevation->getGridWidth(),
                                          gridFrom,
                                          gridTo);
@@ -265,7 +265,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             REQUIRE(NE->getGridWidth() == 8);
             REQUIRE(NE->getGridHeight() == 8);
 
-            const auto &mesh = NE->getUniformGridMesh();
+            const auto &mesh = NE->createUniformGridMesh();
             REQUIRE(mesh.indices.size() == 8 * 8 * 6);
             REQUIRE(mesh.positions.size() == 81);
             REQUIRE(mesh.positionRTCs.size() == 81);
@@ -286,7 +286,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             REQUIRE(SW->getGridWidth() == 8);
             REQUIRE(SW->getGridHeight() == 8);
 
-            const auto &mesh = SW->getUniformGridMesh();
+            const auto &mesh = SW->createUniformGridMesh();
             REQUIRE(mesh.indices.size() == 8 * 8 * 6);
             REQUIRE(mesh.positions.size() == 81);
             REQUIRE(mesh.positionRTCs.size() == 81);
@@ -297,7 +297,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             glm::uvec2 gridTo = gridFrom
                                 + glm::uvec2(elevation->getGridWidth() / 2, elevation->getGridHeight() / 2);
             checkUVTheSameAsOldElevation(mesh,
-                                         elevation->getUniformGridMesh(),
+                                         elevation->createUniformGridMesh(),
                                          elevation->getGridWidth(),
                                          gridFrom,
                                          gridTo);
@@ -311,7 +311,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             REQUIRE(SW->getGridWidth() == 8);
             REQUIRE(SW->getGridHeight() == 8);
 
-            const auto &mesh = SW->getUniformGridMesh();
+            const auto &mesh = SW->createUniformGridMesh();
             REQUIRE(mesh.indices.size() == 8 * 8 * 6);
             REQUIRE(mesh.positions.size() == 81);
             REQUIRE(mesh.positionRTCs.size() == 81);
@@ -332,7 +332,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             REQUIRE(SE->getGridWidth() == 8);
             REQUIRE(SE->getGridHeight() == 8);
 
-            const auto &mesh = SE->getUniformGridMesh();
+            const auto &mesh = SE->createUniformGridMesh();
             REQUIRE(mesh.indices.size() == 8 * 8 * 6);
             REQUIRE(mesh.positions.size() == 81);
             REQUIRE(mesh.positionRTCs.size() == 81);
@@ -342,7 +342,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             glm::uvec2 gridFrom(elevation->getGridWidth() / 2, elevation->getGridHeight() / 2);
             glm::uvec2 gridTo = glm::uvec2(elevation->getGridWidth(), elevation->getGridHeight());
             checkUVTheSameAsOldElevation(mesh,
-                                         elevation->getUniformGridMesh(),
+                                         elevation->createUniformGridMesh(),
                                          elevation->getGridWidth(),
                                          gridFrom,
                                          gridTo);
@@ -356,7 +356,7 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
             REQUIRE(SE->getGridWidth() == 8);
             REQUIRE(SE->getGridHeight() == 8);
 
-            const auto &mesh = SE->getUniformGridMesh();
+            const auto &mesh = SE->createUniformGridMesh();
             REQUIRE(mesh.indices.size() == 8 * 8 * 6);
             REQUIRE(mesh.positions.size() == 81);
             REQUIRE(mesh.positionRTCs.size() == 81);
@@ -368,6 +368,127 @@ TEST_CASE("Test create sub region of an elevation", "[CDBElevation]")
     }
 }
 
+TEST_CASE("Test elevation view matches its uniform grid mesh", "[CDBElevation]")
+{
+    auto elevation = CDBElevation::createFromFile(dataPath / "Elevation"
+                                                  / "N34W119_D001_S001_T001_LC06_U0_R0.tif");
+    REQUIRE(elevation != std::nullopt);
+
+    const auto &view = elevation->getView();
+    REQUIRE(view.getVertexCount() == 289);
+    REQUIRE(view.getIndexCount() == 16 * 16 * 6);
+
+    auto mesh = elevation->createUniformGridMesh();
+    REQUIRE(view.createIndices() == mesh.indices);
+    for (size_t y = 0; y < view.getVerticesHeight(); ++y) {
+        for (size_t x = 0; x < view.getVerticesWidth(); ++x) {
+            size_t index = y * view.getVerticesWidth() + x;
+            REQUIRE(glm::length(view.getPosition(x, y) - mesh.positions[index]) < 1e-6);
+            REQUIRE(view.getUV(x, y) == mesh.UVs[index]);
+            REQUIRE(mesh.aabb->min.x <= mesh.positions[index].x);
+            REQUIRE(mesh.aabb->max.z >= mesh.positions[index].z);
+        }
+    }
+
+    // a sub region is a window into the same heights and keeps the positions of the vertices it shares
+    auto SE = elevation->createSouthEastSubRegion(false);
+    REQUIRE(SE != std::nullopt);
+    const auto &subView = SE->getView();
+    REQUIRE(subView.getOrigin() == glm::uvec2(8, 8));
+    REQUIRE(subView.getExtent() == glm::uvec2(8, 8));
+    REQUIRE(subView.getStride() == 17);
+
+    auto NW = SE->createNorthWestSubRegion(false);
+    REQUIRE(NW != std::nullopt);
+    REQUIRE(NW->getView().getOrigin() == glm::uvec2(8, 8));
+    REQUIRE(NW->getView().getExtent() == glm::uvec2(4, 4));
+    for (size_t y = 0; y < subView.getVerticesHeight(); ++y) {
+        for (size_t x = 0; x < subView.getVerticesWidth(); ++x) {
+            REQUIRE(subView.getHeight(x, y) == view.getHeight(x + 8, y + 8));
+            REQUIRE(glm::length(subView.getPosition(x, y) - view.getPosition(x + 8, y + 8)) < 1e-6);
+            REQUIRE(subView.getUV(x, y).x == Approx(view.getUV(x + 8, y + 8).x));
+            REQUIRE(subView.getUV(x, y).y == Approx(view.getUV(x + 8, y + 8).y));
+        }
+    }
+}
+
+TEST_CASE("Test sub regions clip the simplified triangles of their parent", "[CDBElevation]")
+{
+    auto elevation = CDBElevation::createFromFile(dataPath / "Elevation"
+                                                  / "N34W119_D001_S001_T001_LC06_U0_R0.tif");
+    REQUIRE(elevation != std::nullopt);
+    REQUIRE(!elevation->hasSimplifiedTriangles());
+    REQUIRE(elevation->createSimplifiedTrianglesMesh().indices.empty());
+
+    size_t targetIndexCount = elevation->getView().getIndexCount() / 3;
+    elevation->keepSimplifiedTriangles(targetIndexCount, 0.01f);
+    REQUIRE(elevation->hasSimplifiedTriangles());
+
+    // the kept triangles are the same mesh as simplifying right away
+    auto kept = elevation->createSimplifiedTrianglesMesh();
+    auto simplified = elevation->createSimplifiedMesh(targetIndexCount, 0.01f);
+    REQUIRE(kept.indices == simplified.indices);
+    REQUIRE(kept.positions == simplified.positions);
+    REQUIRE(kept.UVs == simplified.UVs);
+
+    auto SE = elevation->createSouthEastSubRegion(true);
+    REQUIRE(SE != std::nullopt);
+    REQUIRE(SE->hasSimplifiedTriangles());
+
+    // sub regions of sub regions clip the triangles clipped for their parent
+    auto NW = SE->createNorthWestSubRegion(true);
+    REQUIRE(NW != std::nullopt);
+    REQUIRE(NW->hasSimplifiedTriangles());
+    for (const CDBElevation *subRegion : {&*SE, &*NW}) {
+        auto mesh = subRegion->createSimplifiedTrianglesMesh();
+        REQUIRE(mesh.indices.size() > 0);
+        REQUIRE(mesh.positions.size() == mesh.UVs.size());
+        for (const auto &UV : mesh.UVs) {
+            REQUIRE(UV.x >= 0.0f);
+            REQUIRE(UV.x <= 1.0f);
+            REQUIRE(UV.y >= 0.0f);
+            REQUIRE(UV.y <= 1.0f);
+        }
+    }
+}
+
+TEST_CASE("Test clipping elevation triangles into quadrants", "[CDBElevation]")
+{
+    // two triangles over 2 x 2 pixels with a height of 0 in the west and 2 in the east
+    std::vector<float> heights{0.0f, 1.0f, 2.0f, 0.0f, 1.0f, 2.0f, 0.0f, 1.0f, 2.0f};
+    ElevationGrid grid(std::move(heights), 2, 2, Core::Cartographic(0.0, 0.0), glm::dvec2(1.0, -1.0));
+    auto view = grid.getView();
+    ElevationTriangles triangles(view, {0, 8, 2, 8, 0, 6});
+    REQUIRE(triangles.getVertices().size() == 4);
+
+    double totalArea = 0.0;
+    for (unsigned y = 0; y < 2; ++y) {
+        for (unsigned x = 0; x < 2; ++x) {
+            auto clipped = triangles.clip(glm::dvec2(x, y), glm::dvec2(x + 1, y + 1));
+            const auto &vertices = clipped.getVertices();
+            const auto &indices = clipped.getIndices();
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                REQUIRE(vertices[i].x >= 0.0);
+                REQUIRE(vertices[i].x <= 1.0);
+                REQUIRE(vertices[i].y >= 0.0);
+                REQUIRE(vertices[i].y <= 1.0);
+
+                // heights are interpolated along the split edges
+                REQUIRE(clipped.getHeights()[i] == Approx(vertices[i].x + x));
+            }
+
+            for (size_t i = 0; i < indices.size(); i += 3) {
+                glm::dvec2 a = vertices[indices[i]];
+                glm::dvec2 b = vertices[indices[i + 1]];
+                glm::dvec2 c = vertices[indices[i + 2]];
+                totalArea += glm::abs((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)) * 0.5;
+            }
+        }
+    }
+
+    REQUIRE(totalArea == Approx(4.0));
+}
+
 TEST_CASE("Test conversion when elevation has more LOD than imagery", "[CDBElevationConversion]")
 {
     SECTION("Imagery has only negative LOD")
@@ -498,6 +619,35 @@ TEST_CASE("Test conversion when imagery has more LOD than elevation", "[CDBEleva
         // remove the test output
         std::filesystem::remove_all(output);
     }
+
+    SECTION("Test conversion when elevation has positive LOD and sub regions are clipped")
+    {
+        std::filesystem::path input = dataPath / "ImageryMoreLODPositiveElevation";
+        std::filesystem::path output = "ImageryMoreLODPositiveElevationClipped";
+        std::filesystem::path elevationOutputDir = output / "Tiles" / "N32" / "W118" / "Elevation" / "1_1";
+
+        Converter converter(input, output);
+        converter.setElevationClipSubRegions(true);
+        converter.convert();
+
+        // the same tiles are filled as when they are simplified again
+        std::filesystem::path imageryInput = input / "Tiles" / "N32" / "W118" / "004_Imagery";
+        std::filesystem::path textureOutputDir = elevationOutputDir / "Textures";
+        REQUIRE(std::filesystem::exists(textureOutputDir));
+        checkAllConvertedImagery(imageryInput, textureOutputDir, 18);
+        checkElevationDuplicated(imageryInput, elevationOutputDir, 18);
+
+        std::ifstream verifiedJS(input / "VerifiedTileset.json");
+        nlohmann::json verifiedJson = nlohmann::json::parse(verifiedJS);
+
+        std::ifstream testJS(elevationOutputDir / "N32W118_D001_S001_T001.json");
+        nlohmann::json testJson = nlohmann::json::parse(testJS);
+
+        REQUIRE(testJson == verifiedJson);
+
+        // remove the test output
+        std::filesystem::remove_all(output);
+    }
 }
 
 TEST_CASE("Test conversion using elevation LOD only", "[CDBElevationConversion]")
@@ -542,7 +692,7 @@ TEST_CASE("Test that elevation conversion uses uniform grid mesh instead of simp
     auto elevation = CDBElevation::createFromFile(LC09Path);
     REQUIRE(elevation != std::nullopt);
     size_t targetIndices = static_cast<size_t>(
-        thresholdIndices * static_cast<float>(elevation->getUniformGridMesh().indices.size()));
+        thresholdIndices * static_cast<float>(elevation->createUniformGridMesh().indices.size()));
     auto simplied = elevation->createSimplifiedMesh(targetIndices, decimateError);
     REQUIRE(simplied.indices.size() == 0);
     REQUIRE(simplied.positionRTCs.size() == 0);
@@ -592,7 +742,7 @@ TEST_CASE("Test that elevation conversion uses uniform grid mesh instead of simp
     REQUIRE(gltfPrimitive.attributes.at("TEXCOORD_0") == 2);
 
     // check accessors
-    const auto &uniformElevation = elevation->getUniformGridMesh();
+    const auto &uniformElevation = elevation->createUniformGridMesh();
     const auto &indicesAccessor = model.accessors[static_cast<size_t>(gltfPrimitive.indices)];
     REQUIRE(indicesAccessor.count == uniformElevation.indices.size());
     REQUIRE(indicesAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT);
@@ -762,4 +912,4 @@ TEST_CASE("Test writing of external schema for RMDescriptor", "[3D Tiles Next]")
 
     // remove the test output
     std::filesystem::remove_all(output);
-}
\ No newline at end of file
+}
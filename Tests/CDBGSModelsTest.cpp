@@ -2,6 +2,7 @@
 #include "CDBTo3DTiles.h"
 #include "TileFormatIO.h"
 #include "Config.h"
+#include "ThreadPool.h"
 #include "catch2/catch.hpp"
 #include "nlohmann/json.hpp"
 #include "tiny_gltf.h"
@@ -115,6 +116,53 @@ TEST_CASE("Test creating GSModel from model attributes", "[CDBGSModels]")
     }
 }
 
+TEST_CASE("Test decoding GSModel in parallel gives the same model", "[CDBGSModels]")
+{
+    std::filesystem::path CDBPath = dataPath / "GSModelsWithGTModelTexture";
+    std::filesystem::path input = CDBPath / "Tiles" / "N32" / "W118" / "100_GSFeature" / "L00" / "U0"
+                                  / "N32W118_D100_S001_T001_L00_U0_R0.dbf";
+
+    auto createModels = [&](ThreadPool *threadPool) {
+        GDALDatasetUniquePtr attributesDataset = GDALDatasetUniquePtr(
+            (GDALDataset *) GDALOpenEx(input.c_str(), GDAL_OF_VECTOR, nullptr, nullptr, nullptr));
+        REQUIRE(attributesDataset != nullptr);
+
+        auto GSFeatureTile = CDBTile::createFromFile(input.filename().string());
+        CDBModelsAttributes modelsAttributes(std::move(attributesDataset), *GSFeatureTile, CDBPath);
+        return CDBGSModels::createFromModelsAttributes(std::move(modelsAttributes), CDBPath, threadPool);
+    };
+
+    auto serialModels = createModels(nullptr);
+    ThreadPool threadPool(3);
+    auto parallelModels = createModels(&threadPool);
+    REQUIRE(serialModels != std::nullopt);
+    REQUIRE(parallelModels != std::nullopt);
+
+    REQUIRE(parallelModels->getInstancesAttributes().getCNAMs()
+            == serialModels->getInstancesAttributes().getCNAMs());
+
+    const auto &serialModel3D = serialModels->getModel3D();
+    const auto &parallelModel3D = parallelModels->getModel3D();
+    REQUIRE(parallelModel3D.getMaterials().size() == serialModel3D.getMaterials().size());
+    REQUIRE(parallelModel3D.getTextures().size() == serialModel3D.getTextures().size());
+    for (size_t i = 0; i < serialModel3D.getTextures().size(); ++i) {
+        REQUIRE(parallelModel3D.getTextures()[i].uri == serialModel3D.getTextures()[i].uri);
+    }
+
+    const auto &serialMeshes = serialModel3D.getMeshes();
+    const auto &parallelMeshes = parallelModel3D.getMeshes();
+    REQUIRE(parallelMeshes.size() == serialMeshes.size());
+    for (size_t i = 0; i < serialMeshes.size(); ++i) {
+        REQUIRE(parallelMeshes[i].material == serialMeshes[i].material);
+        REQUIRE(parallelMeshes[i].indices == serialMeshes[i].indices);
+        REQUIRE(parallelMeshes[i].positions == serialMeshes[i].positions);
+        REQUIRE(parallelMeshes[i].positionRTCs == serialMeshes[i].positionRTCs);
+        REQUIRE(parallelMeshes[i].normals == serialMeshes[i].normals);
+        REQUIRE(parallelMeshes[i].UVs == serialMeshes[i].UVs);
+        REQUIRE(parallelMeshes[i].batchIDs == serialMeshes[i].batchIDs);
+    }
+}
+
 TEST_CASE("Test GSModel will close zip archive when destruct", "[CDBGSModels]")
 {
     std::filesystem::path CDBPath = dataPath / "GSModelsWithGTModelTexture";
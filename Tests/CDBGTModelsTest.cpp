@@ -1,10 +1,14 @@
 #include "CDBModels.h"
 #include "CDBTo3DTiles.h"
 #include "Config.h"
+#include "ThreadPool.h"
+#include "TileFormatIO.h"
 #include "catch2/catch.hpp"
 #include "nlohmann/json.hpp"
 #include "ogrsf_frmts.h"
+#include "tiny_gltf.h"
 #include <filesystem>
+#include <set>
 
 using namespace CDBTo3DTiles;
 
@@ -62,6 +66,32 @@ TEST_CASE("Test locating GTModel in CDB database", "[CDBGTModelCache]")
     }
 }
 
+TEST_CASE("Test locating the same GTModel concurrently parses it once", "[CDBGTModelCache]")
+{
+    std::filesystem::path input = dataPath / "GTModels";
+
+    CDBGTModelCache GTModelCache(input);
+    std::vector<const CDBModel3DResult *> model3DResults(16, nullptr);
+    std::vector<std::string> modelKeys(model3DResults.size());
+    {
+        ThreadPool threadPool(4);
+        TaskGroup tasks(&threadPool);
+        for (size_t i = 0; i < model3DResults.size(); ++i) {
+            tasks.run([&, i]() {
+                model3DResults[i] = GTModelCache.locateModel3D("AL015", "coronado_bridge", 0, modelKeys[i]);
+            });
+        }
+
+        tasks.wait();
+    }
+
+    for (size_t i = 0; i < model3DResults.size(); ++i) {
+        REQUIRE(model3DResults[i] != nullptr);
+        REQUIRE(model3DResults[i] == model3DResults.front());
+        REQUIRE(modelKeys[i] == "D500_S001_T001_AL015_000_coronado_bridge");
+    }
+}
+
 TEST_CASE("Test locating GTModel with metadata in CDB database", "[CDBGTModels]")
 {
     std::filesystem::path CDBPath = dataPath / "GTModels";
@@ -158,3 +188,65 @@ TEST_CASE("Test CDBGTModels conversion to tileset.json", "[CDBGTModels]")
 
     std::filesystem::remove_all(output);
 }
+
+TEST_CASE("Test CDBGTModels conversion with nested tile layout and a relative output", "[CDBGTModels]")
+{
+    std::filesystem::path CDBPath = dataPath / "GTModels";
+    std::filesystem::path output = "GTModelsNested";
+    Converter converter(CDBPath, output);
+    converter.setUse3dTilesNext(true);
+    converter.setTileLayout(TileLayout::Nested);
+
+    std::set<std::filesystem::path> workingDirectoryFiles;
+    for (const auto &entry : std::filesystem::directory_iterator(std::filesystem::current_path())) {
+        workingDirectoryFiles.insert(entry.path());
+    }
+
+    converter.convert();
+
+    // nothing but the output is written to the working directory
+    for (const auto &entry : std::filesystem::directory_iterator(std::filesystem::current_path())) {
+        if (!std::filesystem::equivalent(entry.path(), output)) {
+            REQUIRE(workingDirectoryFiles.find(entry.path()) != workingDirectoryFiles.end());
+        }
+    }
+
+    // the combined glTF of each tile is written to the nested directory of its level and UREF, and nowhere
+    // else in the tileset directory. Its images point at the textures of the models
+    std::filesystem::path tilesetOutput = output / "Tiles" / "N32" / "W118" / "GTModels" / "1_1";
+    size_t glbCount = 0;
+    size_t imageCount = 0;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(tilesetOutput)) {
+        auto relativePath = entry.path().lexically_relative(tilesetOutput);
+        for (const auto &component : relativePath) {
+            REQUIRE(component != output);
+        }
+
+        if (entry.path().extension() != ".glb" || *relativePath.begin() == "Gltf") {
+            continue;
+        }
+
+        auto tile = CDBTile::createFromFile(entry.path().stem().string());
+        REQUIRE(tile);
+        REQUIRE(entry.path().parent_path()
+                == tilesetOutput
+                       / getTileContentDirectory(TileLayout::Nested, tile->getLevel(), tile->getUREF()));
+
+        tinygltf::TinyGLTF gltfIO;
+        tinygltf::Model gltf;
+        std::string error, warning;
+        REQUIRE(gltfIO.LoadBinaryFromFile(&gltf, &error, &warning, entry.path().string(), 0));
+        for (const auto &image : gltf.images) {
+            REQUIRE(!image.uri.empty());
+            REQUIRE(std::filesystem::exists(entry.path().parent_path() / image.uri));
+            ++imageCount;
+        }
+
+        ++glbCount;
+    }
+
+    REQUIRE(glbCount > 0);
+    REQUIRE(imageCount > 0);
+
+    std::filesystem::remove_all(output);
+}
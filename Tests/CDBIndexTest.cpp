@@ -0,0 +1,171 @@
+#include "CDBIndex.h"
+#include "Config.h"
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace CDBTo3DTiles;
+
+TEST_CASE("Test CDBIndex answers tile existence like the file system", "[CDBIndex]")
+{
+    std::filesystem::path CDBPath = dataPath / "ElevationWithRMTextureRMDescriptor";
+    CDBGeoCell geoCell(12, 44);
+    CDBIndex index(CDBPath);
+
+    struct DatasetExtension
+    {
+        CDBDataset dataset;
+        std::string extension;
+    };
+
+    std::vector<DatasetExtension> datasetExtensions = {{CDBDataset::Elevation, ".tif"},
+                                                       {CDBDataset::Imagery, ".jp2"},
+                                                       {CDBDataset::RMTexture, ".tif"},
+                                                       {CDBDataset::RMDescriptor, ".xml"}};
+
+    for (const auto &datasetExtension : datasetExtensions) {
+        for (int level = -10; level < 3; ++level) {
+            int width = level > 0 ? 1 << level : 1;
+            for (int UREF = 0; UREF < width; ++UREF) {
+                for (int RREF = 0; RREF < width; ++RREF) {
+                    CDBTile tile(geoCell, datasetExtension.dataset, 1, 1, level, UREF, RREF);
+                    bool exists = std::filesystem::exists(
+                        CDBPath / (tile.getRelativePath().string() + datasetExtension.extension));
+                    REQUIRE(index.isTileExist(tile, datasetExtension.extension) == exists);
+                }
+            }
+        }
+    }
+
+    // wrong extension and wrong components are not found
+    CDBTile elevation(geoCell, CDBDataset::Elevation, 1, 1, -1, 0, 0);
+    REQUIRE(index.isTileExist(elevation, ".tif"));
+    REQUIRE_FALSE(index.isTileExist(elevation, ".jp2"));
+    REQUIRE_FALSE(index.isTileExist(geoCell, CDBDataset::Elevation, 2, 1, -1, 0, 0, ".tif"));
+
+    // geocell that does not exist is empty
+    REQUIRE_FALSE(index.isTileExist(CDBGeoCell(13, 44), CDBDataset::Elevation, 1, 1, -1, 0, 0, ".tif"));
+    REQUIRE(index.getDatasetFiles(CDBGeoCell(13, 44), CDBDataset::Elevation).empty());
+}
+
+TEST_CASE("Test CDBIndex enumerates dataset files", "[CDBIndex]")
+{
+    std::filesystem::path CDBPath = dataPath / "ElevationWithRMTextureRMDescriptor";
+    CDBGeoCell geoCell(12, 44);
+    CDBIndex index(CDBPath);
+
+    std::vector<std::filesystem::path> expectedFiles;
+    for (const auto &file :
+         std::filesystem::recursive_directory_iterator(CDBPath / geoCell.getRelativePath() / "004_Imagery")) {
+        if (file.is_regular_file()) {
+            expectedFiles.emplace_back(file.path());
+        }
+    }
+
+    std::vector<std::filesystem::path> files;
+    for (const auto &file : index.getDatasetFiles(geoCell, CDBDataset::Imagery)) {
+        files.emplace_back(file.path);
+    }
+
+    std::sort(files.begin(), files.end());
+    std::sort(expectedFiles.begin(), expectedFiles.end());
+    REQUIRE(files == expectedFiles);
+    REQUIRE(index.getDatasetFiles(geoCell, CDBDataset::GSFeature).empty());
+}
+
+TEST_CASE("Test CDBIndex sweeps a geocell once when queried concurrently", "[CDBIndex]")
+{
+    std::filesystem::path CDBPath = dataPath / "ElevationWithRMTextureRMDescriptor";
+    CDBGeoCell geoCell(12, 44);
+    CDBIndex index(CDBPath);
+
+    std::vector<const std::vector<CDBIndex::File> *> files(8, nullptr);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < files.size(); ++i) {
+        threads.emplace_back([&, i]() { files[i] = &index.getDatasetFiles(geoCell, CDBDataset::Elevation); });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (auto file : files) {
+        REQUIRE(file == files.front());
+    }
+
+    REQUIRE(files.front()->size() == 2);
+}
+
+TEST_CASE("Test CDBIndex reuses the cache of unchanged geocells", "[CDBIndex]")
+{
+    std::filesystem::path input = dataPath / "ElevationWithRMTextureRMDescriptor";
+    std::filesystem::path CDBPath = "IndexCacheCDB";
+    std::filesystem::remove_all(CDBPath);
+    std::filesystem::copy(input, CDBPath, std::filesystem::copy_options::recursive);
+
+    CDBGeoCell geoCell(12, 44);
+    std::filesystem::path cachePath = CDBPath / CDBIndex::CACHE_FILE;
+    {
+        CDBIndex index(CDBPath, cachePath);
+        REQUIRE(index.getGeoCells().size() == 1);
+        REQUIRE(index.isTileExist(geoCell, CDBDataset::Elevation, 1, 1, -1, 0, 0, ".tif"));
+        index.saveCache();
+    }
+
+    REQUIRE(std::filesystem::exists(cachePath));
+
+    // the cache records every file with its size
+    {
+        CDBIndex index(CDBPath, cachePath);
+        REQUIRE(index.getGeoCells().size() == 1);
+        const auto &files = index.getDatasetFiles(geoCell, CDBDataset::Elevation);
+        REQUIRE(files.size() == 2);
+        for (const auto &file : files) {
+            REQUIRE(file.size == std::filesystem::file_size(file.path));
+        }
+    }
+
+    // a file added without changing the directory modified time is not seen, since the cache is reused
+    std::filesystem::path elevationDirectory = CDBPath / geoCell.getRelativePath() / "001_Elevation" / "LC"
+                                               / "U0";
+    auto modifiedTime = std::filesystem::last_write_time(elevationDirectory);
+    std::filesystem::copy_file(elevationDirectory / "N12E044_D001_S001_T001_LC02_U0_R0.tif",
+                               elevationDirectory / "N12E044_D001_S001_T001_LC03_U0_R0.tif");
+    std::filesystem::last_write_time(elevationDirectory, modifiedTime);
+    {
+        CDBIndex index(CDBPath, cachePath);
+        REQUIRE_FALSE(index.isTileExist(geoCell, CDBDataset::Elevation, 1, 1, -3, 0, 0, ".tif"));
+        REQUIRE(index.getDatasetFiles(geoCell, CDBDataset::Elevation).size() == 2);
+    }
+
+    // once the directory is modified, the geocell is swept again and the cache is updated
+    std::filesystem::last_write_time(elevationDirectory, modifiedTime + std::chrono::seconds(1));
+    {
+        CDBIndex index(CDBPath, cachePath);
+        REQUIRE(index.isTileExist(geoCell, CDBDataset::Elevation, 1, 1, -3, 0, 0, ".tif"));
+        REQUIRE(index.getDatasetFiles(geoCell, CDBDataset::Elevation).size() == 3);
+        index.saveCache();
+    }
+
+    {
+        CDBIndex index(CDBPath, cachePath);
+        REQUIRE(index.isTileExist(geoCell, CDBDataset::Elevation, 1, 1, -3, 0, 0, ".tif"));
+    }
+
+    // a cache that can't be parsed is ignored
+    {
+        std::ofstream fs(cachePath, std::ios::binary);
+        fs << "not an index";
+    }
+
+    {
+        CDBIndex index(CDBPath, cachePath);
+        REQUIRE(index.getGeoCells().size() == 1);
+        REQUIRE(index.isTileExist(geoCell, CDBDataset::Elevation, 1, 1, -3, 0, 0, ".tif"));
+    }
+
+    std::filesystem::remove_all(CDBPath);
+}
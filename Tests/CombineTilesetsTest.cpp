@@ -4,6 +4,7 @@
 #include "CDBTile.h"
 #include "CDBTo3DTiles.h"
 #include "Config.h"
+#include "OutputSink.h"
 #include "catch2/catch.hpp"
 #include "glm/glm.hpp"
 #include "morton.h"
@@ -411,6 +412,165 @@ TEST_CASE("Test combine multiple sets of tilesets", "[CombineTilesets]")
     std::filesystem::remove_all(output);
 }
 
+TEST_CASE("Test converter produces the same combined tilesets when converting geocells concurrently",
+          "[CombineTilesets]")
+{
+    std::filesystem::path input = dataPath / "CombineTilesets";
+    std::filesystem::path serialOutput = "CombineTilesetsSerial";
+    std::filesystem::path concurrentOutput = "CombineTilesetsConcurrent";
+
+    {
+        Converter converter(input, serialOutput);
+        converter.combineDataset({"Elevation_1_1", "GTModels_1_1"});
+        converter.convert();
+    }
+
+    {
+        Converter converter(input, concurrentOutput);
+        converter.combineDataset({"Elevation_1_1", "GTModels_1_1"});
+        converter.setThreadCount(4);
+        converter.convert();
+    }
+
+    for (auto tileset : {"Elevation_1_1.json", "GTModels_1_1.json", "GTModels_2_1.json", "tileset.json"}) {
+        REQUIRE(std::filesystem::exists(serialOutput / tileset));
+        REQUIRE(std::filesystem::exists(concurrentOutput / tileset));
+        std::ifstream serialFs(serialOutput / tileset);
+        std::ifstream concurrentFs(concurrentOutput / tileset);
+        REQUIRE(nlohmann::json::parse(serialFs) == nlohmann::json::parse(concurrentFs));
+    }
+
+    std::filesystem::remove_all(serialOutput);
+    std::filesystem::remove_all(concurrentOutput);
+}
+
+TEST_CASE("Test merging sharded conversions produces the same combined tilesets", "[CombineTilesets]")
+{
+    std::filesystem::path input = dataPath / "CombineTilesets";
+    std::filesystem::path serialOutput = "CombineTilesetsSerial";
+    std::filesystem::path mergedOutput = "CombineTilesetsMerged";
+    std::vector<std::filesystem::path> shardOutputs = {"CombineTilesetsShard0", "CombineTilesetsShard1"};
+
+    {
+        Converter converter(input, serialOutput);
+        converter.combineDataset({"Elevation_1_1", "GTModels_1_1"});
+        converter.convert();
+    }
+
+    for (size_t i = 0; i < shardOutputs.size(); ++i) {
+        Converter converter(input, shardOutputs[i]);
+        converter.combineDataset({"Elevation_1_1", "GTModels_1_1"});
+        converter.setShard(static_cast<int>(i), static_cast<int>(shardOutputs.size()));
+        converter.convert();
+    }
+
+    // the two geocells have to be split between the shards
+    std::filesystem::path W118 = CDBGeoCell(32, -118).getRelativePath();
+    std::filesystem::path W119 = CDBGeoCell(32, -119).getRelativePath();
+    bool shard0HasW118 = std::filesystem::exists(shardOutputs[0] / W118);
+    bool shard0HasW119 = std::filesystem::exists(shardOutputs[0] / W119);
+    REQUIRE(shard0HasW118 != std::filesystem::exists(shardOutputs[1] / W118));
+    REQUIRE(shard0HasW119 != std::filesystem::exists(shardOutputs[1] / W119));
+    REQUIRE(shard0HasW118 != shard0HasW119);
+
+    ShardMerger merger(shardOutputs, mergedOutput);
+    merger.combineDataset({"Elevation_1_1", "GTModels_1_1"});
+    merger.merge();
+
+    for (auto tileset : {"Elevation_1_1.json", "GTModels_1_1.json", "GTModels_2_1.json", "tileset.json"}) {
+        REQUIRE(std::filesystem::exists(serialOutput / tileset));
+        REQUIRE(std::filesystem::exists(mergedOutput / tileset));
+        std::ifstream serialFs(serialOutput / tileset);
+        std::ifstream mergedFs(mergedOutput / tileset);
+        nlohmann::json serialJson = nlohmann::json::parse(serialFs);
+        nlohmann::json mergedJson = nlohmann::json::parse(mergedFs);
+
+        // merged tilesets point into the shard directories, so compare the uris relative to them
+        auto &mergedChildren = mergedJson["root"]["children"];
+        auto &serialChildren = serialJson["root"]["children"];
+        REQUIRE(mergedChildren.size() == serialChildren.size());
+        for (size_t i = 0; i < mergedChildren.size(); ++i) {
+            std::filesystem::path uri = mergedChildren[i]["content"]["uri"].get<std::string>();
+            REQUIRE(std::filesystem::exists(mergedOutput / uri));
+            for (const auto &shardOutput : shardOutputs) {
+                auto shardUri = uri.lexically_relative(std::filesystem::path("..") / shardOutput);
+                if (!shardUri.empty() && *shardUri.begin() != "..") {
+                    uri = shardUri;
+                }
+            }
+
+            mergedChildren[i]["content"]["uri"] = uri.string();
+        }
+
+        REQUIRE(serialJson == mergedJson);
+    }
+
+    ShardMerger incompleteMerger({shardOutputs[0]}, mergedOutput);
+    REQUIRE_THROWS_WITH(incompleteMerger.merge(), "Output of shard 1/2 is missing");
+
+    // the merge step can only read shard outputs from the file system
+    Converter shardConversion(input, shardOutputs[0]);
+    shardConversion.setShard(0, 2);
+    REQUIRE_THROWS_WITH(shardConversion.setOutputSink(std::make_shared<NullOutputSink>()),
+                        "Sharded conversion can only write to the file system output sink");
+    Converter nullConversion(input, shardOutputs[0]);
+    nullConversion.setOutputSink(std::make_shared<NullOutputSink>());
+    REQUIRE_THROWS_WITH(nullConversion.setShard(0, 2),
+                        "Sharded conversion can only write to the file system output sink");
+
+    std::filesystem::remove_all(serialOutput);
+    std::filesystem::remove_all(mergedOutput);
+    for (const auto &shardOutput : shardOutputs) {
+        std::filesystem::remove_all(shardOutput);
+    }
+}
+
+TEST_CASE("Test converter produces the same elevation tiles when converting with the pipeline",
+          "[CombineTilesets]")
+{
+    std::filesystem::path input = dataPath / "CombineTilesets";
+    std::filesystem::path serialOutput = "CombineTilesetsSerial";
+    std::filesystem::path pipelineOutput = "CombineTilesetsPipeline";
+
+    {
+        Converter converter(input, serialOutput);
+        converter.convert();
+    }
+
+    {
+        Converter converter(input, pipelineOutput);
+        converter.setPipelineQueueDepth(2);
+        converter.setPipelineBuilderThreads(2);
+        converter.setPipelineEncoderThreads(2);
+        converter.setPipelineWriterThreads(2);
+        converter.setWriterThreads(2);
+        converter.setWriterMemoryBudget(1);
+        converter.convert();
+    }
+
+    size_t tileCount = 0;
+    std::filesystem::path elevationDirectory = serialOutput / "Tiles" / "N32" / "W119" / "Elevation";
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(elevationDirectory)) {
+        auto extension = entry.path().extension();
+        if (extension != ".b3dm" && extension != ".json" && extension != ".jpeg") {
+            continue;
+        }
+
+        auto pipelineTile = pipelineOutput / std::filesystem::relative(entry.path(), serialOutput);
+        REQUIRE(std::filesystem::exists(pipelineTile));
+        std::ifstream serialFs(entry.path(), std::ios::binary);
+        std::ifstream pipelineFs(pipelineTile, std::ios::binary);
+        std::vector<char> serialBuffer(std::istreambuf_iterator<char>(serialFs), {});
+        std::vector<char> pipelineBuffer(std::istreambuf_iterator<char>(pipelineFs), {});
+        REQUIRE(serialBuffer == pipelineBuffer);
+        ++tileCount;
+    }
+
+    REQUIRE(tileCount > 0);
+    std::filesystem::remove_all(serialOutput);
+    std::filesystem::remove_all(pipelineOutput);
+}
+
 TEST_CASE("Test converter for implicit elevation", "[CombineTilesets]")
 {
     const uint64_t headerByteLength = 24;
@@ -613,5 +773,42 @@ TEST_CASE("Test converter for implicit elevation", "[CombineTilesets]")
                 != extensionsRequired.end());
     }
 
+    SECTION("Verify subtrees are the same when dataset passes run concurrently.")
+    {
+        std::filesystem::path concurrentOutput = "CombineTilesetsConcurrent";
+        {
+            Converter converter(input, output);
+            converter.setUse3dTilesNext(true);
+            converter.convert();
+        }
+
+        {
+            Converter converter(input, concurrentOutput);
+            converter.setUse3dTilesNext(true);
+            converter.setThreadCount(4);
+            converter.setWriterThreads(2);
+            converter.convert();
+        }
+
+        size_t subtreeCount = 0;
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(output)) {
+            if (entry.path().extension() != ".subtree") {
+                continue;
+            }
+
+            auto concurrentSubtree = concurrentOutput / std::filesystem::relative(entry.path(), output);
+            REQUIRE(std::filesystem::exists(concurrentSubtree));
+            std::ifstream serialFs(entry.path(), std::ios::binary);
+            std::ifstream concurrentFs(concurrentSubtree, std::ios::binary);
+            std::vector<char> serialBuffer(std::istreambuf_iterator<char>(serialFs), {});
+            std::vector<char> concurrentBuffer(std::istreambuf_iterator<char>(concurrentFs), {});
+            REQUIRE(serialBuffer == concurrentBuffer);
+            ++subtreeCount;
+        }
+
+        REQUIRE(subtreeCount > 0);
+        std::filesystem::remove_all(concurrentOutput);
+    }
+
     std::filesystem::remove_all(output);
 }
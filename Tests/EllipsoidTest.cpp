@@ -0,0 +1,116 @@
+#include "Ellipsoid.h"
+#include "EllipsoidGrid.h"
+#include "MathHelpers.h"
+#include "catch2/catch.hpp"
+#include <limits>
+#include <random>
+#include <vector>
+
+static void requireSamePositions(const std::vector<glm::dvec3> &positions,
+                                 const std::vector<glm::dvec3> &expectedPositions)
+{
+    REQUIRE(positions.size() == expectedPositions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        REQUIRE(glm::length(positions[i] - expectedPositions[i]) < Core::Math::EPSILON7);
+    }
+}
+
+TEST_CASE("Test batch conversion agrees with converting one position at a time", "[Ellipsoid]")
+{
+    const auto &ellipsoid = Core::Ellipsoid::WGS84;
+
+    // an odd count, so the positions that don't fill a whole SIMD block are converted too
+    std::mt19937 generator(0);
+    const double pi = Core::Math::ONE_PI;
+    std::uniform_real_distribution<double> longitudeDistribution(-pi, pi);
+    std::uniform_real_distribution<double> latitudeDistribution(-pi / 2.0, pi / 2.0);
+    std::uniform_real_distribution<double> heightDistribution(-500.0, 9000.0);
+    std::vector<double> longitudes;
+    std::vector<double> latitudes;
+    std::vector<double> heights;
+    for (size_t i = 0; i < 10007; ++i) {
+        longitudes.emplace_back(longitudeDistribution(generator));
+        latitudes.emplace_back(latitudeDistribution(generator));
+        heights.emplace_back(heightDistribution(generator));
+    }
+
+    // the quadrant boundaries of the angle reduction and the poles
+    for (double angle : {0.0, pi / 4.0, pi / 2.0, 3.0 * pi / 4.0, pi}) {
+        for (double sign : {1.0, -1.0}) {
+            longitudes.emplace_back(sign * angle);
+            latitudes.emplace_back(sign * angle / 2.0);
+            heights.emplace_back(0.0);
+        }
+    }
+
+    std::vector<glm::dvec3> expectedPositions;
+    std::vector<Core::Cartographic> cartographics;
+    for (size_t i = 0; i < longitudes.size(); ++i) {
+        cartographics.emplace_back(longitudes[i], latitudes[i], heights[i]);
+        expectedPositions.emplace_back(ellipsoid.cartographicToCartesian(cartographics.back()));
+    }
+
+    SECTION("Convert separate arrays")
+    {
+        std::vector<glm::dvec3> positions(longitudes.size());
+        ellipsoid.cartographicToCartesian(
+            longitudes.data(), latitudes.data(), heights.data(), longitudes.size(), positions.data());
+        requireSamePositions(positions, expectedPositions);
+    }
+
+    SECTION("Convert cartographic positions")
+    {
+        std::vector<glm::dvec3> positions(cartographics.size());
+        ellipsoid.cartographicToCartesian(cartographics.data(), cartographics.size(), positions.data());
+        requireSamePositions(positions, expectedPositions);
+    }
+
+    SECTION("Convert fewer positions than a SIMD block")
+    {
+        std::vector<glm::dvec3> positions(3);
+        ellipsoid.cartographicToCartesian(
+            longitudes.data(), latitudes.data(), heights.data(), positions.size(), positions.data());
+        expectedPositions.resize(positions.size());
+        requireSamePositions(positions, expectedPositions);
+    }
+}
+
+TEST_CASE("Test grid conversion agrees with converting one position at a time", "[Ellipsoid]")
+{
+    const auto &ellipsoid = Core::Ellipsoid::WGS84;
+
+    // an odd number of columns, so the columns that don't fill a whole SIMD block are converted too
+    size_t columnCount = 67;
+    size_t rowCount = 5;
+    std::vector<double> longitudes;
+    for (size_t x = 0; x < columnCount; ++x) {
+        longitudes.emplace_back(glm::radians(-118.0 + static_cast<double>(x) / 64.0));
+    }
+
+    Core::EllipsoidGrid grid(ellipsoid, longitudes.data(), longitudes.size());
+    REQUIRE(grid.getColumnCount() == columnCount);
+
+    glm::dvec3 minimum(std::numeric_limits<double>::max());
+    glm::dvec3 maximum(std::numeric_limits<double>::lowest());
+    glm::dvec3 expectedMinimum = minimum;
+    glm::dvec3 expectedMaximum = maximum;
+    std::vector<double> heights(columnCount);
+    std::vector<glm::dvec3> positions(columnCount);
+    std::vector<glm::dvec3> expectedPositions(columnCount);
+    for (size_t y = 0; y < rowCount; ++y) {
+        double latitude = glm::radians(32.0 + static_cast<double>(y) / 64.0);
+        for (size_t x = 0; x < columnCount; ++x) {
+            heights[x] = static_cast<double>((x * 7 + y * 13) % 100) - 20.0;
+            expectedPositions[x] = ellipsoid.cartographicToCartesian(
+                Core::Cartographic(longitudes[x], latitude, heights[x]));
+            expectedMinimum = glm::min(expectedMinimum, expectedPositions[x]);
+            expectedMaximum = glm::max(expectedMaximum, expectedPositions[x]);
+        }
+
+        grid.convertRow(latitude, heights.data(), positions.data(), minimum, maximum);
+        requireSamePositions(positions, expectedPositions);
+    }
+
+    REQUIRE(glm::length(minimum - expectedMinimum) < Core::Math::EPSILON7);
+    REQUIRE(glm::length(maximum - expectedMaximum) < Core::Math::EPSILON7);
+}
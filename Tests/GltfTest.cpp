@@ -3,6 +3,7 @@
 #include "catch2/catch.hpp"
 #include <fstream>
 #include <ostream>
+#include <sstream>
 
 using namespace CDBTo3DTiles;
 
@@ -361,6 +362,47 @@ TEST_CASE("Test writing GLBs with JSON chunks padded to 8 bytes", "[Gltf]")
     std::filesystem::remove_all(glbPath);
 }
 
+TEST_CASE("Test GLBWriter writes the same GLB as tinygltf", "[Gltf]")
+{
+    Mesh triangleMesh = createTriangleMesh();
+    tinygltf::Model model = createGltf(triangleMesh, nullptr, nullptr);
+
+    std::stringstream tinygltfStream;
+    tinygltf::TinyGLTF io;
+    io.WriteGltfSceneToStream(&model, tinygltfStream, false, true);
+    std::string tinygltfGLB = tinygltfStream.str();
+
+    GLBWriter writer(&model, 4);
+    std::stringstream writerStream;
+    writer.write(writerStream);
+    std::string writerGLB = writerStream.str();
+
+    // the writer doesn't touch the model
+    REQUIRE(model.buffers.front().data.size() > 0);
+
+    REQUIRE(writer.getByteLength() == writerGLB.size());
+    uint32_t glbLength;
+    std::memcpy(&glbLength, writerGLB.data() + 8, 4);
+    REQUIRE(glbLength == writerGLB.size());
+    REQUIRE(writerGLB == tinygltfGLB);
+
+    // padding the JSON chunk to 8 bytes keeps the GLB loadable
+    std::stringstream paddedStream;
+    writePaddedGLB(&model, paddedStream);
+    std::string paddedGLB = paddedStream.str();
+    std::memcpy(&glbLength, paddedGLB.data() + 8, 4);
+    REQUIRE(glbLength == paddedGLB.size());
+
+    tinygltf::Model loadedModel;
+    std::string error, warning;
+    REQUIRE(io.LoadBinaryFromMemory(&loadedModel,
+                                    &error,
+                                    &warning,
+                                    reinterpret_cast<const unsigned char *>(paddedGLB.data()),
+                                    static_cast<unsigned int>(paddedGLB.size())));
+    REQUIRE(loadedModel.buffers.front().data == model.buffers.front().data);
+}
+
 TEST_CASE("Test combining GLBs", "[Gltf]")
 {
     Mesh triangleMesh = createTriangleMesh();
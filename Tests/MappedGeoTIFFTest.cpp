@@ -0,0 +1,130 @@
+#include "MappedGeoTIFF.h"
+#include "Config.h"
+#include "catch2/catch.hpp"
+#include "cpl_string.h"
+#include "gdal_priv.h"
+
+using namespace CDBTo3DTiles;
+
+static std::vector<float> readHeightsWithGDAL(const std::filesystem::path &path, double geoTransform[6])
+{
+    GDALDatasetUniquePtr dataset = GDALDatasetUniquePtr(
+        (GDALDataset *) GDALOpen(path.string().c_str(), GDALAccess::GA_ReadOnly));
+    REQUIRE(dataset != nullptr);
+    dataset->GetGeoTransform(geoTransform);
+
+    int width = dataset->GetRasterXSize();
+    int height = dataset->GetRasterYSize();
+    std::vector<float> heights(static_cast<size_t>(width * height));
+    REQUIRE(dataset->GetRasterBand(1)->RasterIO(
+                GF_Read, 0, 0, width, height, heights.data(), width, height, GDT_Float32, 0, 0, nullptr)
+            == CE_None);
+
+    return heights;
+}
+
+static void writeGeoTIFF(const std::filesystem::path &path,
+                         GDALDataType dataType,
+                         const std::vector<std::pair<const char *, const char *>> &options)
+{
+    int width = 40;
+    int height = 24;
+    auto memoryDriver = GetGDALDriverManager()->GetDriverByName("MEM");
+    GDALDatasetUniquePtr dataset = GDALDatasetUniquePtr(
+        memoryDriver->Create("", width, height, 1, dataType, nullptr));
+    double geoTransform[6] = {-119.0, 0.025, 0.0, 35.0, 0.0, -0.0416};
+    dataset->SetGeoTransform(geoTransform);
+
+    std::vector<float> heights(static_cast<size_t>(width * height));
+    for (size_t i = 0; i < heights.size(); ++i) {
+        heights[i] = static_cast<float>(i % 97) * 12.5f - 100.0f;
+    }
+
+    REQUIRE(dataset->GetRasterBand(1)->RasterIO(
+                GF_Write, 0, 0, width, height, heights.data(), width, height, GDT_Float32, 0, 0, nullptr)
+            == CE_None);
+
+    char **creationOptions = nullptr;
+    for (const auto &option : options) {
+        creationOptions = CSLSetNameValue(creationOptions, option.first, option.second);
+    }
+
+    auto geoTIFFDriver = GetGDALDriverManager()->GetDriverByName("GTiff");
+    GDALDatasetUniquePtr geoTIFF = GDALDatasetUniquePtr(
+        geoTIFFDriver->CreateCopy(path.string().c_str(), dataset.get(), false, creationOptions, nullptr, nullptr));
+    CSLDestroy(creationOptions);
+    REQUIRE(geoTIFF != nullptr);
+}
+
+static std::unique_ptr<MappedGeoTIFF> checkSameAsGDAL(const std::filesystem::path &path)
+{
+    auto geoTIFF = MappedGeoTIFF::open(path);
+    REQUIRE(geoTIFF != nullptr);
+
+    double geoTransform[6];
+    auto heights = readHeightsWithGDAL(path, geoTransform);
+    REQUIRE(geoTIFF->getPixelSizeX() == geoTransform[1]);
+    REQUIRE(geoTIFF->getPixelSizeY() == geoTransform[5]);
+    REQUIRE(geoTIFF->getWidth() * geoTIFF->getHeight() == heights.size());
+    for (size_t i = 0; i < heights.size(); ++i) {
+        REQUIRE(geoTIFF->getHeights()[i] == heights[i]);
+    }
+
+    return geoTIFF;
+}
+
+TEST_CASE("Test memory mapped GeoTIFF reads CDB elevation like GDAL", "[MappedGeoTIFF]")
+{
+    auto path = dataPath / "Elevation" / "N34W119_D001_S001_T001_LC06_U0_R0.tif";
+    auto geoTIFF = checkSameAsGDAL(path);
+    REQUIRE(geoTIFF->isZeroCopy());
+    REQUIRE(geoTIFF->getWidth() == 16);
+    REQUIRE(geoTIFF->getHeight() == 16);
+}
+
+TEST_CASE("Test memory mapped GeoTIFF reads strips and tiles like GDAL", "[MappedGeoTIFF]")
+{
+    std::filesystem::path output = "MappedGeoTIFF";
+    std::filesystem::create_directories(output);
+
+    SECTION("Strips")
+    {
+        writeGeoTIFF(output / "strips.tif", GDT_Float32, {{"BLOCKYSIZE", "5"}});
+        checkSameAsGDAL(output / "strips.tif");
+    }
+
+    SECTION("Tiles")
+    {
+        writeGeoTIFF(output / "tiles.tif",
+                     GDT_Float32,
+                     {{"TILED", "YES"}, {"BLOCKXSIZE", "16"}, {"BLOCKYSIZE", "16"}});
+        REQUIRE(!checkSameAsGDAL(output / "tiles.tif")->isZeroCopy());
+    }
+
+    std::filesystem::remove_all(output);
+}
+
+TEST_CASE("Test memory mapped GeoTIFF leaves other layouts to GDAL", "[MappedGeoTIFF]")
+{
+    std::filesystem::path output = "MappedGeoTIFF";
+    std::filesystem::create_directories(output);
+
+    SECTION("Compressed")
+    {
+        writeGeoTIFF(output / "compressed.tif", GDT_Float32, {{"COMPRESS", "LZW"}});
+        REQUIRE(MappedGeoTIFF::open(output / "compressed.tif") == nullptr);
+    }
+
+    SECTION("Double heights")
+    {
+        writeGeoTIFF(output / "double.tif", GDT_Float64, {});
+        REQUIRE(MappedGeoTIFF::open(output / "double.tif") == nullptr);
+    }
+
+    SECTION("Empty file")
+    {
+        REQUIRE(MappedGeoTIFF::open(dataPath / "Elevation" / "N34W119_D001_S001_T001_L06_U0_R0.tif") == nullptr);
+    }
+
+    std::filesystem::remove_all(output);
+}
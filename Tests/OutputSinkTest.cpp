@@ -0,0 +1,278 @@
+#include "AsyncFileWriter.h"
+#include "OutputSink.h"
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace CDBTo3DTiles;
+
+static std::string readFile(const std::filesystem::path &path)
+{
+    std::ifstream fs(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(fs), {});
+}
+
+template<typename T>
+static T readLittleEndian(const std::string &buffer, size_t offset)
+{
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value = static_cast<T>(value | static_cast<T>(static_cast<uint8_t>(buffer[offset + i])) << (8 * i));
+    }
+
+    return value;
+}
+
+struct ZipEntry
+{
+    std::string name;
+    size_t offset;
+    std::string content;
+};
+
+static std::vector<ZipEntry> readStoredZip(const std::string &archive)
+{
+    // the end of central directory record is the last 22 bytes, since the archive has no comment
+    size_t endOfCentralDirectory = archive.size() - 22;
+    REQUIRE(readLittleEndian<uint32_t>(archive, endOfCentralDirectory) == 0x06054B50);
+    auto entryCount = readLittleEndian<uint16_t>(archive, endOfCentralDirectory + 10);
+    auto centralDirectoryByteLength = readLittleEndian<uint32_t>(archive, endOfCentralDirectory + 12);
+    size_t centralDirectoryOffset = readLittleEndian<uint32_t>(archive, endOfCentralDirectory + 16);
+    REQUIRE(centralDirectoryOffset + centralDirectoryByteLength == endOfCentralDirectory);
+
+    std::vector<ZipEntry> entries;
+    size_t offset = centralDirectoryOffset;
+    for (uint16_t i = 0; i < entryCount; ++i) {
+        REQUIRE(readLittleEndian<uint32_t>(archive, offset) == 0x02014B50);
+        REQUIRE(readLittleEndian<uint16_t>(archive, offset + 10) == 0);
+        auto byteLength = readLittleEndian<uint32_t>(archive, offset + 24);
+        auto nameLength = readLittleEndian<uint16_t>(archive, offset + 28);
+        size_t localHeaderOffset = readLittleEndian<uint32_t>(archive, offset + 42);
+        std::string name = archive.substr(offset + 46, nameLength);
+
+        REQUIRE(readLittleEndian<uint32_t>(archive, localHeaderOffset) == 0x04034B50);
+        REQUIRE(readLittleEndian<uint16_t>(archive, localHeaderOffset + 26) == nameLength);
+        REQUIRE(archive.substr(localHeaderOffset + 30, nameLength) == name);
+        auto content = archive.substr(localHeaderOffset + 30 + nameLength, byteLength);
+        entries.push_back({name, localHeaderOffset, content});
+
+        offset += 46 + nameLength;
+    }
+
+    return entries;
+}
+
+static std::map<std::string, std::string> getZipFiles(const std::vector<ZipEntry> &entries)
+{
+    std::map<std::string, std::string> files;
+    for (const auto &entry : entries) {
+        files[entry.name] = entry.content;
+    }
+
+    return files;
+}
+
+TEST_CASE("Test file system output sink creates missing directories", "[OutputSink]")
+{
+    std::filesystem::path output = "OutputSink";
+    std::string content = "content";
+
+    auto &outputSink = FileSystemOutputSink::getInstance();
+    REQUIRE(outputSink.isFileSystem());
+    outputSink.write(output / "a" / "b.bin", content.data(), content.size());
+    REQUIRE(readFile(output / "a" / "b.bin") == content);
+
+    std::filesystem::remove_all(output);
+}
+
+TEST_CASE("Test memory output sink keeps the last write of each file", "[OutputSink]")
+{
+    MemoryOutputSink outputSink;
+    REQUIRE(!outputSink.isFileSystem());
+
+    std::string first = "first";
+    std::string second = "second";
+    outputSink.write("Output/a.bin", first.data(), first.size());
+    outputSink.write("Output/b.bin", first.data(), first.size());
+    outputSink.write("Output/a.bin", second.data(), second.size());
+
+    REQUIRE(outputSink.getFiles().size() == 2);
+    REQUIRE(*outputSink.getFile("Output/a.bin") == second);
+    REQUIRE(*outputSink.getFile("Output/b.bin") == first);
+    REQUIRE(outputSink.getFile("Output/c.bin") == nullptr);
+}
+
+TEST_CASE("Test null output sink counts the written bytes", "[OutputSink]")
+{
+    NullOutputSink outputSink;
+    std::string content(100, 'x');
+    for (int i = 0; i < 10; ++i) {
+        outputSink.write("Output/" + std::to_string(i), content.data(), content.size());
+    }
+
+    REQUIRE(outputSink.getFileCount() == 10);
+    REQUIRE(outputSink.getByteLength() == 1000);
+}
+
+TEST_CASE("Test async file writer writes to the output sink", "[OutputSink]")
+{
+    MemoryOutputSink outputSink;
+    {
+        AsyncFileWriter writer(2, 64, outputSink);
+        for (size_t i = 0; i < 16; ++i) {
+            writer.write(std::to_string(i) + ".bin", std::string(i, 'a'));
+        }
+        writer.flush();
+    }
+
+    REQUIRE(outputSink.getFiles().size() == 16);
+    for (size_t i = 0; i < 16; ++i) {
+        REQUIRE(*outputSink.getFile(std::to_string(i) + ".bin") == std::string(i, 'a'));
+    }
+}
+
+TEST_CASE("Test archive output sink writes a zip archive", "[OutputSink]")
+{
+    std::filesystem::path output = "OutputSink";
+    std::filesystem::path archivePath = output / "output.zip";
+    std::filesystem::path rootPath = output / "tileset";
+
+    {
+        ArchiveOutputSink outputSink(archivePath, rootPath);
+        std::string tileset = "{\"asset\":{\"version\":\"1.0\"}}";
+        std::string tile(1000, '\0');
+        std::string replacedTile = "replaced";
+        outputSink.write(rootPath / "tileset.json", tileset.data(), tileset.size());
+        outputSink.write(rootPath / "Tiles" / "0.b3dm", tile.data(), tile.size());
+        outputSink.write(rootPath / "Tiles" / "1.b3dm", tile.data(), tile.size());
+        outputSink.write(rootPath / "Tiles" / "1.b3dm", replacedTile.data(), replacedTile.size());
+        outputSink.finish();
+
+        // finishing twice doesn't add a second central directory
+        outputSink.finish();
+        REQUIRE_THROWS(outputSink.write(rootPath / "late.json", tileset.data(), tileset.size()));
+    }
+
+    auto entries = readStoredZip(readFile(archivePath));
+    auto files = getZipFiles(entries);
+    REQUIRE(entries.size() == 4);
+    REQUIRE(entries.back().name == ArchiveOutputSink::INDEX_NAME);
+    REQUIRE(files["tileset.json"] == "{\"asset\":{\"version\":\"1.0\"}}");
+    REQUIRE(files["Tiles/0.b3dm"] == std::string(1000, '\0'));
+    REQUIRE(files["Tiles/1.b3dm"] == "replaced");
+
+    std::filesystem::remove_all(output);
+}
+
+TEST_CASE("Test archive output sink finishes the archive when it is destroyed", "[OutputSink]")
+{
+    std::filesystem::path output = "OutputSink";
+    std::filesystem::path archivePath = output / "output.zip";
+
+    {
+        ArchiveOutputSink outputSink(archivePath, output);
+        std::string content = "content";
+        outputSink.write(output / "a.bin", content.data(), content.size());
+    }
+
+    auto files = getZipFiles(readStoredZip(readFile(archivePath)));
+    REQUIRE(files.size() == 2);
+    REQUIRE(files["a.bin"] == "content");
+
+    std::filesystem::remove_all(output);
+}
+
+TEST_CASE("Test archive output sink writes a sorted 3TZ index", "[OutputSink]")
+{
+    std::filesystem::path output = "OutputSink";
+    std::filesystem::path archivePath = output / "output.3tz";
+
+    {
+        ArchiveOutputSink outputSink(archivePath, output);
+        std::string content = "content";
+        outputSink.write(output / "tileset.json", content.data(), content.size());
+        outputSink.write(output / "Tiles" / "0.b3dm", content.data(), content.size());
+        outputSink.write(output / "Tiles" / "1.b3dm", content.data(), content.size());
+    }
+
+    auto entries = readStoredZip(readFile(archivePath));
+    REQUIRE(entries.size() == 4);
+    const auto &index = entries.back().content;
+    REQUIRE(index.size() == 3 * 24);
+
+    // MD5 hashes of the paths, sorted by their last 8 bytes as a little endian uint64
+    std::vector<std::pair<std::array<uint8_t, 16>, std::string>> expectedIndex{
+        {{0xc0, 0x9b, 0xde, 0xa7, 0xe7, 0x45, 0x89, 0x4f, 0x49, 0x9a, 0x75, 0x17, 0xdb, 0x9a, 0x77, 0x09},
+         "tileset.json"},
+        {{0x42, 0x83, 0x38, 0x75, 0xad, 0xe3, 0x7f, 0x47, 0xdb, 0x29, 0xf7, 0x50, 0x79, 0x6c, 0x36, 0xbf},
+         "Tiles/1.b3dm"},
+        {{0x98, 0xec, 0xa4, 0x47, 0xe2, 0x22, 0xfb, 0xb7, 0xbe, 0x5d, 0x45, 0x42, 0x24, 0xc3, 0x24, 0xe5},
+         "Tiles/0.b3dm"},
+    };
+
+    for (size_t i = 0; i < expectedIndex.size(); ++i) {
+        const auto &[hash, name] = expectedIndex[i];
+        REQUIRE(std::memcmp(index.data() + i * 24, hash.data(), hash.size()) == 0);
+
+        auto entry = std::find_if(entries.begin(), entries.end(), [&name](const ZipEntry &zipEntry) {
+            return zipEntry.name == name;
+        });
+        REQUIRE(entry != entries.end());
+        REQUIRE(readLittleEndian<uint64_t>(index, i * 24 + 16) == entry->offset);
+    }
+
+    std::filesystem::remove_all(output);
+}
+
+TEST_CASE("Test deduplicating output sink hashes with XXH64", "[OutputSink]")
+{
+    std::string text = "Nobody inspects the spammish repetition";
+    REQUIRE(DeduplicatingOutputSink::computeXXH64("", 0) == 0xEF46DB3751D8E999);
+    REQUIRE(DeduplicatingOutputSink::computeXXH64("abc", 3) == 0x44BC2CF5AD770999);
+    REQUIRE(DeduplicatingOutputSink::computeXXH64(text.data(), text.size()) == 0xFBCEA83C8A378BF1);
+}
+
+TEST_CASE("Test deduplicating output sink links identical files", "[OutputSink]")
+{
+    std::filesystem::path output = "OutputSink";
+    std::string content(1000, 'a');
+    std::string otherContent(1000, 'b');
+
+    DeduplicatingOutputSink outputSink(FileSystemOutputSink::getInstance());
+    REQUIRE(!outputSink.isFileSystem());
+    outputSink.write(output / "a.bin", content.data(), content.size());
+    outputSink.write(output / "b" / "b.bin", content.data(), content.size());
+    outputSink.write(output / "c.bin", otherContent.data(), otherContent.size());
+    REQUIRE(outputSink.getDuplicateFileCount() == 1);
+    REQUIRE(outputSink.getDuplicateByteLength() == 1000);
+    REQUIRE(std::filesystem::equivalent(output / "a.bin", output / "b" / "b.bin"));
+    REQUIRE(readFile(output / "b" / "b.bin") == content);
+
+    // rewriting a linked file leaves the file it was linked to unchanged
+    outputSink.write(output / "b" / "b.bin", otherContent.data(), otherContent.size());
+    REQUIRE(readFile(output / "a.bin") == content);
+    REQUIRE(readFile(output / "b" / "b.bin") == otherContent);
+    REQUIRE(outputSink.getDuplicateFileCount() == 2);
+
+    std::filesystem::remove_all(output);
+}
+
+TEST_CASE("Test deduplicating output sink skips files rewritten with the same content", "[OutputSink]")
+{
+    MemoryOutputSink memoryOutputSink;
+    DeduplicatingOutputSink outputSink(memoryOutputSink);
+
+    std::string first = "first";
+    std::string second = "second";
+    outputSink.write("Output/a.bin", first.data(), first.size());
+    outputSink.write("Output/a.bin", first.data(), first.size());
+    REQUIRE(outputSink.getDuplicateFileCount() == 1);
+
+    // without a file system, a copy at another path is still written
+    outputSink.write("Output/b.bin", first.data(), first.size());
+    outputSink.write("Output/a.bin", second.data(), second.size());
+    REQUIRE(outputSink.getDuplicateFileCount() == 1);
+    REQUIRE(*memoryOutputSink.getFile("Output/a.bin") == second);
+    REQUIRE(*memoryOutputSink.getFile("Output/b.bin") == first);
+}
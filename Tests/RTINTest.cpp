@@ -0,0 +1,203 @@
+#include "CDBElevation.h"
+#include "Config.h"
+#include "ElevationGrid.h"
+#include "RTIN.h"
+#include "catch2/catch.hpp"
+#include <chrono>
+#include <iostream>
+#include <map>
+
+using namespace CDBTo3DTiles;
+
+static ElevationGrid createWavyGrid(size_t gridSize)
+{
+    std::vector<float> heights;
+    heights.reserve((gridSize + 1) * (gridSize + 1));
+    for (size_t y = 0; y <= gridSize; ++y) {
+        for (size_t x = 0; x <= gridSize; ++x) {
+            double fx = static_cast<double>(x);
+            double fy = static_cast<double>(y);
+            double height = 300.0 * glm::sin(fx * 0.02) * glm::cos(fy * 0.03)
+                            + 20.0 * glm::sin(fx * 0.4 + fy * 0.7);
+            heights.emplace_back(static_cast<float>(height));
+        }
+    }
+
+    double pixelSize = 1.0 / static_cast<double>(gridSize);
+    return ElevationGrid(std::move(heights),
+                         gridSize,
+                         gridSize,
+                         Core::Cartographic(glm::radians(-118.0), glm::radians(33.0)),
+                         glm::dvec2(pixelSize, -pixelSize));
+}
+
+// counts how many triangles share each edge. In a triangulation without cracks, an edge inside the grid is
+// shared by two triangles and an edge on the border of the grid belongs to one
+static void countEdges(const ElevationView &view,
+                       const std::vector<uint32_t> &indices,
+                       std::map<std::pair<size_t, size_t>, int> &edges,
+                       size_t gridVerticesWidth)
+{
+    glm::uvec2 origin = view.getOrigin();
+    auto toGridIndex = [&](uint32_t index) {
+        size_t x = index % view.getVerticesWidth() + origin.x;
+        size_t y = index / view.getVerticesWidth() + origin.y;
+        return y * gridVerticesWidth + x;
+    };
+
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (size_t j = 0; j < 3; ++j) {
+            size_t a = toGridIndex(indices[i + j]);
+            size_t b = toGridIndex(indices[i + (j + 1) % 3]);
+            ++edges[std::make_pair(glm::min(a, b), glm::max(a, b))];
+        }
+    }
+}
+
+static bool isWithoutCracks(const std::map<std::pair<size_t, size_t>, int> &edges, size_t gridSize)
+{
+    size_t verticesWidth = gridSize + 1;
+    for (const auto &edge : edges) {
+        size_t ax = edge.first.first % verticesWidth;
+        size_t ay = edge.first.first / verticesWidth;
+        size_t bx = edge.first.second % verticesWidth;
+        size_t by = edge.first.second / verticesWidth;
+        bool isBorder = (ax == bx && (ax == 0 || ax == gridSize))
+                        || (ay == by && (ay == 0 || ay == gridSize));
+        if (edge.second != (isBorder ? 1 : 2)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+TEST_CASE("Test RTIN of a flat grid", "[RTIN]")
+{
+    ElevationGrid grid(std::vector<float>(17 * 17, 10.0f),
+                       16,
+                       16,
+                       Core::Cartographic(0.0, 0.0),
+                       glm::dvec2(1.0 / 16.0, -1.0 / 16.0));
+    auto view = grid.getView();
+    REQUIRE(RTIN::isSupported(view));
+
+    RTIN rtin(view);
+    REQUIRE(rtin.getError(8, 8) == 0.0f);
+
+    // the two triangles of the whole grid
+    auto indices = rtin.createIndices(view, 0.0f);
+    REQUIRE(indices == std::vector<uint32_t>{0, 288, 16, 288, 0, 272});
+
+    // the south east quadrant is split along its north west to south east diagonal like the grid, and the
+    // north east quadrant along the other diagonal
+    auto southEast = view.createSubView(glm::uvec2(8, 8), glm::uvec2(8, 8));
+    REQUIRE(rtin.isCovering(southEast));
+    REQUIRE(rtin.createIndices(southEast, 0.0f) == std::vector<uint32_t>{0, 80, 8, 80, 0, 72});
+
+    auto northEast = view.createSubView(glm::uvec2(8, 0), glm::uvec2(8, 8));
+    REQUIRE(rtin.createIndices(northEast, 0.0f) == std::vector<uint32_t>{72, 8, 0, 8, 72, 80});
+}
+
+TEST_CASE("Test RTIN only supports square grids of 2^n pixels", "[RTIN]")
+{
+    Core::Cartographic topLeft(0.0, 0.0);
+    glm::dvec2 pixelSize(1.0, -1.0);
+    ElevationGrid rectangle(std::vector<float>(17 * 9, 0.0f), 16, 8, topLeft, pixelSize);
+    REQUIRE(!RTIN::isSupported(rectangle.getView()));
+
+    ElevationGrid square(std::vector<float>(13 * 13, 0.0f), 12, 12, topLeft, pixelSize);
+    REQUIRE(!RTIN::isSupported(square.getView()));
+    REQUIRE_THROWS(RTIN(square.getView()));
+
+    ElevationGrid grid(std::vector<float>(17 * 17, 0.0f), 16, 16, topLeft, pixelSize);
+    auto view = grid.getView();
+    REQUIRE(!RTIN::isSupported(view.createSubView(glm::uvec2(0), glm::uvec2(8))));
+
+    RTIN rtin(view);
+    REQUIRE(rtin.isCovering(view.createSubView(glm::uvec2(4, 12), glm::uvec2(4))));
+    REQUIRE(!rtin.isCovering(view.createSubView(glm::uvec2(2, 0), glm::uvec2(4))));
+    REQUIRE(!rtin.isCovering(view.createSubView(glm::uvec2(0), glm::uvec2(8, 4))));
+}
+
+TEST_CASE("Test RTIN triangles have no cracks", "[RTIN]")
+{
+    size_t gridSize = 64;
+    auto grid = createWavyGrid(gridSize);
+    auto view = grid.getView();
+    RTIN rtin(view);
+
+    for (float maxError : {0.0f, 1.0f, 10.0f, 100.0f}) {
+        std::map<std::pair<size_t, size_t>, int> edges;
+        auto indices = rtin.createIndices(view, maxError);
+        countEdges(view, indices, edges, gridSize + 1);
+        REQUIRE(isWithoutCracks(edges, gridSize));
+
+        // the quadrants of the quadrants are extracted from the same error map, so they line up with each
+        // other even though each of them has its own level of detail
+        std::map<std::pair<size_t, size_t>, int> subRegionEdges;
+        for (unsigned y = 0; y < gridSize; y += 16) {
+            for (unsigned x = 0; x < gridSize; x += 16) {
+                auto subView = view.createSubView(glm::uvec2(x, y), glm::uvec2(16));
+                REQUIRE(rtin.isCovering(subView));
+                countEdges(subView, rtin.createIndices(subView, maxError), subRegionEdges, gridSize + 1);
+            }
+        }
+
+        REQUIRE(isWithoutCracks(subRegionEdges, gridSize));
+    }
+
+    // no height is left out without an error
+    REQUIRE(rtin.createIndices(view, 0.0f).size() == view.getIndexCount());
+}
+
+TEST_CASE("Test RTIN simplifier of elevation", "[RTIN]")
+{
+    auto elevation = CDBElevation::createFromFile(dataPath / "Elevation"
+                                                  / "N34W119_D001_S001_T001_LC06_U0_R0.tif");
+    REQUIRE(elevation != std::nullopt);
+    REQUIRE(!elevation->hasRTIN());
+
+    elevation->createRTIN();
+    REQUIRE(elevation->hasRTIN());
+
+    size_t indexCount = elevation->getView().getIndexCount();
+    auto simplified = elevation->createSimplifiedMesh(indexCount / 3, 0.01f, ElevationSimplifier::RTIN);
+    REQUIRE(simplified.indices.size() > 0);
+    REQUIRE(simplified.indices.size() <= indexCount / 3);
+    REQUIRE(simplified.positions.size() == simplified.UVs.size());
+    REQUIRE(simplified.positions.size() == simplified.positionRTCs.size());
+
+    // sub regions are simplified with the error map of the whole tile
+    auto subRegion = elevation->createNorthEastSubRegion(false);
+    REQUIRE(subRegion != std::nullopt);
+    REQUIRE(subRegion->hasRTIN());
+    auto simplifiedSubRegion = subRegion->createSimplifiedMesh(indexCount / 12,
+                                                               0.01f,
+                                                               ElevationSimplifier::RTIN);
+    REQUIRE(simplifiedSubRegion.indices.size() > 0);
+    REQUIRE(simplifiedSubRegion.indices.size() <= indexCount / 12);
+}
+
+TEST_CASE("Benchmark RTIN against meshopt_simplify", "[.][benchmark][RTIN]")
+{
+    CDBTile tile(CDBGeoCell(33, -118), CDBDataset::Elevation, 1, 1, 0, 0, 0);
+    CDBElevation elevation(createWavyGrid(1024), tile);
+    size_t targetIndexCount = elevation.getView().getIndexCount() * 3 / 10;
+
+    auto begin = std::chrono::steady_clock::now();
+    auto meshopt = elevation.createSimplifiedMesh(targetIndexCount,
+                                                  0.01f,
+                                                  ElevationSimplifier::MeshOptimizer);
+    auto meshoptEnd = std::chrono::steady_clock::now();
+    elevation.createRTIN();
+    auto rtin = elevation.createSimplifiedMesh(targetIndexCount, 0.01f, ElevationSimplifier::RTIN);
+    auto rtinEnd = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double, std::milli> meshoptTime = meshoptEnd - begin;
+    std::chrono::duration<double, std::milli> rtinTime = rtinEnd - meshoptEnd;
+    std::cout << "meshopt_simplify: " << meshoptTime.count() << " ms, " << meshopt.indices.size()
+              << " indices\n"
+              << "RTIN: " << rtinTime.count() << " ms, " << rtin.indices.size() << " indices\n";
+    REQUIRE(rtin.indices.size() > 0);
+}
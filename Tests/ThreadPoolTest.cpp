@@ -0,0 +1,100 @@
+#include "ThreadPool.h"
+#include "catch2/catch.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+using namespace CDBTo3DTiles;
+
+static void runNestedTasks(ThreadPool *pool, int depth, std::atomic<int> &taskCount)
+{
+    ++taskCount;
+    if (depth == 0) {
+        return;
+    }
+
+    TaskGroup children(pool);
+    for (int i = 0; i < 4; ++i) {
+        children.run([pool, depth, &taskCount]() { runNestedTasks(pool, depth - 1, taskCount); });
+    }
+    children.wait();
+}
+
+TEST_CASE("Test task group runs tasks inline without a thread pool", "[ThreadPool]")
+{
+    std::vector<int> order;
+    TaskGroup tasks(nullptr);
+    for (int i = 0; i < 4; ++i) {
+        tasks.run([&order, i]() { order.emplace_back(i); });
+    }
+    tasks.wait();
+
+    REQUIRE(order == std::vector<int>{0, 1, 2, 3});
+}
+
+TEST_CASE("Test nested task groups finish on a small thread pool", "[ThreadPool]")
+{
+    ThreadPool pool(2);
+    std::atomic<int> taskCount{0};
+
+    TaskGroup tasks(&pool);
+    for (int i = 0; i < 8; ++i) {
+        tasks.run([&pool, &taskCount]() { runNestedTasks(&pool, 4, taskCount); });
+        tasks.limitPendingTasks(2);
+    }
+    tasks.wait();
+
+    // each root task spawns 1 + 4 + 16 + 64 + 256 tasks
+    REQUIRE(taskCount == 8 * 341);
+}
+
+TEST_CASE("Test task group rethrows the exception of a failed task", "[ThreadPool]")
+{
+    ThreadPool pool(2);
+    std::atomic<int> taskCount{0};
+
+    TaskGroup tasks(&pool);
+    for (int i = 0; i < 4; ++i) {
+        tasks.run([&taskCount]() { ++taskCount; });
+    }
+    tasks.run([]() { throw std::runtime_error("Task failed"); });
+
+    REQUIRE_THROWS_WITH(tasks.wait(), "Task failed");
+    REQUIRE(taskCount == 4);
+}
+
+TEST_CASE("Test waiting task group only runs its own tasks", "[ThreadPool]")
+{
+    ThreadPool pool(1);
+    std::atomic<bool> isBlocking{false};
+    std::atomic<bool> isReleased{false};
+    std::atomic<bool> isOtherTaskRun{false};
+    std::atomic<bool> isOwnTaskRun{false};
+
+    // keep the only worker busy, so queued tasks can only be run by a waiting thread
+    TaskGroup blocking(&pool);
+    blocking.run([&isBlocking, &isReleased]() {
+        isBlocking = true;
+        while (!isReleased) {
+            std::this_thread::yield();
+        }
+    });
+
+    while (!isBlocking) {
+        std::this_thread::yield();
+    }
+
+    TaskGroup own(&pool);
+    TaskGroup other(&pool);
+    own.run([&isOwnTaskRun]() { isOwnTaskRun = true; });
+    other.run([&isOtherTaskRun]() { isOtherTaskRun = true; });
+    own.wait();
+
+    REQUIRE(isOwnTaskRun);
+    REQUIRE(!isOtherTaskRun);
+
+    isReleased = true;
+    other.wait();
+    blocking.wait();
+    REQUIRE(isOtherTaskRun);
+}
@@ -0,0 +1,132 @@
+#include "CDBTile.h"
+#include "CDBTo3DTiles.h"
+#include "Config.h"
+#include "TileFormatIO.h"
+#include "catch2/catch.hpp"
+#include "nlohmann/json.hpp"
+#include "tiny_gltf.h"
+#include <cstdio>
+#include <fstream>
+
+using namespace CDBTo3DTiles;
+
+static void checkNestedTileContent(const nlohmann::json &tileJson,
+                                   const std::filesystem::path &tilesetDirectory,
+                                   size_t &contentCount)
+{
+    if (tileJson.find("content") != tileJson.end()) {
+        std::filesystem::path contentPath = tileJson["content"]["uri"].get<std::string>();
+        auto tile = CDBTile::createFromFile(contentPath.filename().replace_extension(".tif").string());
+        REQUIRE(tile);
+        REQUIRE(contentPath.parent_path() == getTileContentDirectory(TileLayout::Nested,
+                                                                     tile->getLevel(),
+                                                                     tile->getUREF()));
+        REQUIRE(std::filesystem::exists(tilesetDirectory / contentPath));
+        ++contentCount;
+    }
+
+    if (tileJson.find("children") != tileJson.end()) {
+        for (const auto &child : tileJson["children"]) {
+            checkNestedTileContent(child, tilesetDirectory, contentCount);
+        }
+    }
+}
+
+TEST_CASE("Test getting the tile content directory of each layout", "[TileLayout]")
+{
+    REQUIRE(getTileContentDirectory(TileLayout::Flat, 3, 5).empty());
+    REQUIRE(getTileContentDirectory(TileLayout::Nested, 3, 5) == std::filesystem::path("L3") / "U5");
+    REQUIRE(getTileContentDirectory(TileLayout::Nested, -4, 0) == std::filesystem::path("LC4") / "U0");
+}
+
+TEST_CASE("Test conversion with nested tile layout", "[TileLayout]")
+{
+    SECTION("Tileset json points to the nested tiles")
+    {
+        std::filesystem::path input = dataPath / "ElevationMoreLODPositiveImagery";
+        std::filesystem::path output = "ElevationMoreLODPositiveImageryNested";
+        std::filesystem::path elevationOutputDir = output / "Tiles" / "N32" / "W118" / "Elevation" / "1_1";
+
+        Converter converter(input, output);
+        converter.setTileLayout(TileLayout::Nested);
+        converter.convert();
+
+        std::ifstream tilesetJS(elevationOutputDir / "N32W118_D001_S001_T001.json");
+        nlohmann::json tilesetJson = nlohmann::json::parse(tilesetJS);
+
+        size_t contentCount = 0;
+        checkNestedTileContent(tilesetJson["root"], elevationOutputDir, contentCount);
+        REQUIRE(contentCount > 0);
+
+        // no tile is left in the tileset directory itself
+        for (const auto &entry : std::filesystem::directory_iterator(elevationOutputDir)) {
+            REQUIRE(entry.path().extension() != ".b3dm");
+        }
+
+        // remove the test output
+        std::filesystem::remove_all(output);
+    }
+
+    SECTION("Implicit tiling templates, subtrees and glTF URIs point to the nested files")
+    {
+        std::filesystem::path input = dataPath / "ElevationWithRMTextureRMDescriptor";
+        std::filesystem::path output = "ElevationWithRMTextureRMDescriptorNested";
+        std::filesystem::path elevationOutputDir = output / "Tiles" / "N12" / "E044" / "Elevation" / "1_1";
+
+        Converter converter(input, output);
+        converter.setUse3dTilesNext(true);
+        converter.setExternalSchema(true);
+        converter.setTileLayout(TileLayout::Nested);
+        converter.convert();
+
+        std::ifstream tilesetJS(elevationOutputDir / "N12E044_D001_S001_T001.json");
+        nlohmann::json tilesetJson = nlohmann::json::parse(tilesetJS);
+        auto implicitTile = tilesetJson["root"]["children"][0];
+        REQUIRE(implicitTile["content"]["uri"].get<std::string>().rfind("L{level}/U{y}/", 0) == 0);
+        auto implicitTiling = implicitTile["extensions"]["3DTILES_implicit_tiling"];
+        REQUIRE(implicitTiling["subtrees"]["uri"] == "subtrees/L{level}/U{y}/{level}_{x}_{y}.subtree");
+
+        size_t subtreeCount = 0;
+        size_t glbCount = 0;
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(elevationOutputDir)) {
+            if (entry.path().extension() == ".subtree") {
+                int level, x, y;
+                REQUIRE(sscanf(entry.path().stem().string().c_str(), "%d_%d_%d", &level, &x, &y) == 3);
+                REQUIRE(entry.path().parent_path()
+                        == elevationOutputDir / "subtrees"
+                               / getTileContentDirectory(TileLayout::Nested, level, y));
+                ++subtreeCount;
+                continue;
+            }
+
+            if (entry.path().extension() != ".glb") {
+                continue;
+            }
+
+            auto tile = CDBTile::createFromFile(entry.path().filename().replace_extension(".tif").string());
+            REQUIRE(tile);
+            REQUIRE(entry.path().parent_path()
+                    == elevationOutputDir
+                           / getTileContentDirectory(TileLayout::Nested, tile->getLevel(), tile->getUREF()));
+
+            tinygltf::TinyGLTF gltfIO;
+            tinygltf::Model gltf;
+            std::string error, warning;
+            REQUIRE(gltfIO.LoadBinaryFromFile(&gltf, &error, &warning, entry.path().string(), 0));
+            for (const auto &image : gltf.images) {
+                REQUIRE(std::filesystem::exists(entry.path().parent_path() / image.uri));
+            }
+
+            auto schemaUri = gltf.extensions["EXT_feature_metadata"].Get("schemaUri").Get<std::string>();
+            auto schemaPath = entry.path().parent_path() / schemaUri;
+            REQUIRE(std::filesystem::equivalent(schemaPath, output / "materials.json"));
+            ++glbCount;
+        }
+
+        REQUIRE(subtreeCount > 0);
+        REQUIRE(glbCount > 0);
+
+        // remove the test output
+        std::filesystem::remove_all(output);
+    }
+}
@@ -0,0 +1,139 @@
+#include "CDB.h"
+#include "Config.h"
+#include "TilePrefetcher.h"
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+using namespace CDBTo3DTiles;
+
+static void waitUntilPrefetched(const TilePrefetcher::Tile &tile)
+{
+    while (!tile.isPrefetched) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+TEST_CASE("Test tile prefetcher counts hits and misses", "[TilePrefetcher]")
+{
+    std::filesystem::path output = "TilePrefetcher";
+    std::filesystem::create_directories(output);
+    {
+        std::ofstream fs(output / "a.bin", std::ios::binary);
+        fs << std::string(100, 'a');
+    }
+
+    TilePrefetcher prefetcher(1, 4, 1024);
+    REQUIRE(prefetcher.getTileCount() == 4);
+
+    SECTION("Warmed tile is a hit")
+    {
+        auto tile = prefetcher.prefetch({{output / "a.bin", 100}});
+        REQUIRE(tile != nullptr);
+        waitUntilPrefetched(*tile);
+        prefetcher.consume(tile);
+
+        auto statistics = prefetcher.getStatistics();
+        REQUIRE(statistics.hitCount == 1);
+        REQUIRE(statistics.missCount == 0);
+        REQUIRE(statistics.prefetchedByteLength == 100);
+    }
+
+    SECTION("Tile that isn't queued is a miss")
+    {
+        prefetcher.consume(nullptr);
+
+        auto statistics = prefetcher.getStatistics();
+        REQUIRE(statistics.hitCount == 0);
+        REQUIRE(statistics.missCount == 1);
+        REQUIRE(statistics.prefetchedByteLength == 0);
+    }
+
+    SECTION("Tile with a missing file is a miss")
+    {
+        auto tile = prefetcher.prefetch({{output / "a.bin", 100}, {output / "missing.bin", 50}});
+        waitUntilPrefetched(*tile);
+        REQUIRE(!tile->isWarm);
+        prefetcher.consume(tile);
+
+        auto statistics = prefetcher.getStatistics();
+        REQUIRE(statistics.hitCount == 0);
+        REQUIRE(statistics.missCount == 1);
+        REQUIRE(statistics.prefetchedByteLength == 100);
+    }
+
+    std::filesystem::remove_all(output);
+}
+
+TEST_CASE("Test tile prefetcher stays within the byte budget", "[TilePrefetcher]")
+{
+    TilePrefetcher prefetcher(1, 4, 150);
+
+    // a tile larger than the budget is still accepted when nothing else is waiting
+    auto large = prefetcher.prefetch({{"large.bin", 200}});
+    REQUIRE(large != nullptr);
+    REQUIRE(prefetcher.prefetch({{"small.bin", 10}}) == nullptr);
+
+    prefetcher.consume(large);
+    auto first = prefetcher.prefetch({{"first.bin", 100}});
+    REQUIRE(first != nullptr);
+    REQUIRE(prefetcher.prefetch({{"second.bin", 100}}) == nullptr);
+    REQUIRE(prefetcher.prefetch({{"third.bin", 50}}) != nullptr);
+}
+
+TEST_CASE("Test prefetching doesn't change the elevation tiles that are read", "[TilePrefetcher]")
+{
+    std::filesystem::path input = dataPath / "ElevationWithRMTextureRMDescriptor";
+    CDB cdb(input);
+    CDBGeoCell geoCell(12, 44);
+
+    std::vector<CDBTile> tiles;
+    cdb.forEachElevationTile(geoCell, [&](CDBElevation elevation) {
+        tiles.emplace_back(elevation.getTile());
+    });
+    REQUIRE(tiles.size() == 2);
+
+    TilePrefetcher prefetcher(2, 1, 1024 * 1024);
+    std::vector<CDBTile> prefetchedTiles;
+    cdb.forEachElevationTile(
+        geoCell,
+        [&](CDBElevation elevation) { prefetchedTiles.emplace_back(elevation.getTile()); },
+        &prefetcher);
+    REQUIRE(prefetchedTiles == tiles);
+
+    auto statistics = prefetcher.getStatistics();
+    REQUIRE(statistics.hitCount + statistics.missCount == tiles.size());
+}
+
+TEST_CASE("Test prefetching elevation tiles without an index cache counts the elevation files",
+          "[TilePrefetcher]")
+{
+    // sizes are only recorded in the index when it is cached, so the elevation file has to be sized on its
+    // own. The second tile is given time to be warmed while the first one is processed
+    std::filesystem::path input = dataPath / "ElevationWithRMTextureRMDescriptor";
+    std::filesystem::path elevationPath = input / "Tiles" / "N12" / "E044" / "001_Elevation" / "LC" / "U0";
+    uintmax_t minElevationSize = std::min(
+        std::filesystem::file_size(elevationPath / "N12E044_D001_S001_T001_LC01_U0_R0.tif"),
+        std::filesystem::file_size(elevationPath / "N12E044_D001_S001_T001_LC02_U0_R0.tif"));
+
+    CDB cdb(input);
+    TilePrefetcher prefetcher(2, 1, 16 * 1024 * 1024);
+    size_t tileCount = 0;
+    cdb.forEachElevationTile(
+        CDBGeoCell(12, 44),
+        [&](CDBElevation) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (tileCount == 0 && prefetcher.getStatistics().prefetchedByteLength < minElevationSize
+                   && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            ++tileCount;
+        },
+        &prefetcher);
+
+    REQUIRE(tileCount == 2);
+    REQUIRE(prefetcher.getStatistics().prefetchedByteLength >= minElevationSize);
+}
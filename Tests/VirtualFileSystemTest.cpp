@@ -0,0 +1,131 @@
+#include "CDBTo3DTiles.h"
+#include "Config.h"
+#include "VirtualFileSystem.h"
+#include "catch2/catch.hpp"
+#include "cpl_vsi.h"
+#include "nlohmann/json.hpp"
+#include <fstream>
+
+using namespace CDBTo3DTiles;
+
+static void writeToZip(const std::filesystem::path &zipPath,
+                       const std::filesystem::path &entryPath,
+                       const std::string &content)
+{
+    // GDAL appends each file to the zip and closes the zip again once the file is written
+    std::string virtualPath = "/vsizip/" + std::filesystem::absolute(zipPath).generic_string() + "/"
+                              + entryPath.generic_string();
+    VSILFILE *fp = VSIFOpenL(virtualPath.c_str(), "wb");
+    REQUIRE(fp != nullptr);
+    REQUIRE(VSIFWriteL(content.data(), 1, content.size(), fp) == content.size());
+    REQUIRE(VSIFCloseL(fp) == 0);
+}
+
+static void zipDirectory(const std::filesystem::path &directory,
+                         const std::filesystem::path &zipPath,
+                         const std::filesystem::path &entryDirectory)
+{
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(directory)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+
+        std::ifstream fs(entry.path(), std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
+        writeToZip(zipPath, entryDirectory / entry.path().lexically_relative(directory), content);
+    }
+}
+
+TEST_CASE("Test resolving a path inside an archive", "[VirtualFileSystem]")
+{
+    std::filesystem::path output = "VirtualFileSystem";
+    std::filesystem::create_directories(output / "Directory.zip");
+    writeToZip(output / "Resolve.zip", "CDB/Metadata/Version.xml", "version");
+
+    auto zipPath = std::filesystem::absolute(output / "Resolve.zip").generic_string();
+    REQUIRE(VirtualFileSystem::resolveArchivePath(output / "Resolve.zip" / "CDB")
+            == std::filesystem::path("/vsizip/" + zipPath) / "CDB");
+    REQUIRE(VirtualFileSystem::resolveArchivePath(output / "Resolve.zip")
+            == std::filesystem::path("/vsizip/" + zipPath));
+
+    // a directory named like an archive and a path that is already virtual stay the same
+    REQUIRE(VirtualFileSystem::resolveArchivePath(output / "Directory.zip") == output / "Directory.zip");
+    REQUIRE(VirtualFileSystem::resolveArchivePath("/vsitar/CDB.tar/CDB") == "/vsitar/CDB.tar/CDB");
+    REQUIRE(VirtualFileSystem::isVirtualPath("/vsizip/CDB.zip"));
+    REQUIRE(!VirtualFileSystem::isVirtualPath(output / "Resolve.zip"));
+
+    std::filesystem::remove_all(output);
+}
+
+TEST_CASE("Test querying files inside an archive", "[VirtualFileSystem]")
+{
+    std::filesystem::path output = "VirtualFileSystem";
+    std::filesystem::create_directories(output);
+    writeToZip(output / "CDB.zip", "CDB/Metadata/Version.xml", "version");
+    writeToZip(output / "CDB.zip", "CDB/Tiles/N32/W118/file.txt", "content");
+
+    auto CDBPath = VirtualFileSystem::resolveArchivePath(output / "CDB.zip" / "CDB");
+    REQUIRE(VirtualFileSystem::isDirectory(CDBPath / "Tiles"));
+    REQUIRE(!VirtualFileSystem::isDirectory(CDBPath / "Metadata" / "Version.xml"));
+    REQUIRE(VirtualFileSystem::exists(CDBPath / "Metadata" / "Version.xml"));
+    REQUIRE(!VirtualFileSystem::exists(CDBPath / "Metadata" / "Missing.xml"));
+    REQUIRE(VirtualFileSystem::getFileSize(CDBPath / "Tiles" / "N32" / "W118" / "file.txt") == 7u);
+    REQUIRE(!VirtualFileSystem::getFileSize(CDBPath / "Missing.txt"));
+    REQUIRE(VirtualFileSystem::readFile(CDBPath / "Metadata" / "Version.xml") == std::string("version"));
+
+    auto entries = VirtualFileSystem::listDirectory(CDBPath);
+    REQUIRE(entries.size() == 2);
+    for (const auto &entry : entries) {
+        REQUIRE(entry.isDirectory);
+        REQUIRE((entry.path == CDBPath / "Metadata" || entry.path == CDBPath / "Tiles"));
+    }
+
+    SECTION("Extract a local copy for readers that can't go through GDAL")
+    {
+        auto archivedPath = CDBPath / "Metadata" / "Version.xml";
+        auto localPath = VirtualFileSystem::getLocalPath(archivedPath);
+        REQUIRE(!VirtualFileSystem::isVirtualPath(localPath));
+        REQUIRE(VirtualFileSystem::readFile(localPath) == std::string("version"));
+        REQUIRE(VirtualFileSystem::getLocalPath(archivedPath) == localPath);
+        REQUIRE(VirtualFileSystem::getArchivedDirectory(localPath.parent_path()) == CDBPath / "Metadata");
+        REQUIRE(!VirtualFileSystem::getArchivedDirectory(output));
+
+        // copies are extracted to the temporary directory, never next to the working directory
+        auto temporaryDirectory = std::filesystem::temp_directory_path().generic_string();
+        REQUIRE(localPath.generic_string().rfind(temporaryDirectory, 0) == 0);
+
+        VirtualFileSystem::removeLocalPath(archivedPath);
+        REQUIRE(!std::filesystem::exists(localPath));
+        REQUIRE(VirtualFileSystem::readFile(VirtualFileSystem::getLocalPath(archivedPath))
+                == std::string("version"));
+    }
+
+    std::filesystem::remove_all(output);
+}
+
+TEST_CASE("Test conversion reads the CDB from a zip archive", "[VirtualFileSystem]")
+{
+    std::filesystem::path input = dataPath / "ElevationMoreLODPositiveImagery";
+    std::filesystem::path zipPath = "ElevationMoreLODPositiveImagery.zip";
+    std::filesystem::path output = "ElevationMoreLODPositiveImageryFromZip";
+    zipDirectory(input, zipPath, "CDB");
+
+    Converter converter(zipPath / "CDB", output);
+    converter.convert();
+
+    std::filesystem::path elevationOutputDir = output / "Tiles" / "N32" / "W118" / "Elevation" / "1_1";
+    std::filesystem::path tilesetPath = elevationOutputDir / "N32W118_D001_S001_T001.json";
+    REQUIRE(std::filesystem::exists(tilesetPath));
+
+    std::ifstream verifiedJS(input / "VerifiedTileset.json");
+    nlohmann::json verifiedJson = nlohmann::json::parse(verifiedJS);
+
+    std::ifstream testJS(tilesetPath);
+    nlohmann::json testJson = nlohmann::json::parse(testJS);
+
+    REQUIRE(testJson == verifiedJson);
+
+    // remove the test output
+    std::filesystem::remove_all(output);
+    std::filesystem::remove(zipPath);
+}